@@ -6,13 +6,14 @@
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
 #include <node/miner.h>
+#include <node/template_builder.h>
 #include <random.h>
 #include <test/util/mining.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <txmempool.h>
 #include <validation.h>
-
+#include <validationinterface.h>
 
 #include <vector>
 
@@ -60,5 +61,66 @@ static void BlockAssemblerAddPackageTxns(benchmark::Bench& bench)
     });
 }
 
+
+/** Fetch a template after every change to a populated mempool, either by
+ * rebuilding it or from BlockTemplateBuilder. Each change removes a
+ * transaction and adds it back. */
+static void BlockTemplateChurn(benchmark::Bench& bench, bool incremental)
+{
+    FastRandomContext det_rand{true};
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    node::NodeContext& node{testing_setup->m_node};
+    CTxMemPool& mempool{*node.mempool};
+    const auto txs{testing_setup->PopulateMempool(det_rand, /*num_transactions=*/1000, /*submit=*/true)};
+    node::BlockAssembler::Options assembler_options;
+    assembler_options.test_block_validity = false;
+
+    // Churn a transaction that makes it into the template and has no descendants
+    CTransactionRef tx;
+    CAmount fee;
+    {
+        LOCK(mempool.cs);
+        for (auto it{txs.rbegin()}; !tx; ++it) {
+            const auto entry{*Assert(mempool.GetIter((*it)->GetHash()))};
+            if (entry->GetCountWithDescendants() == 1 && CFeeRate{entry->GetFee(), uint32_t(entry->GetTxSize())} >= assembler_options.blockMinFeeRate) {
+                tx = *it;
+                fee = entry->GetFee();
+            }
+        }
+    }
+
+    node::BlockTemplateBuilder builder{*node.chainman, mempool, assembler_options};
+    if (incremental) node.validation_signals->RegisterValidationInterface(&builder);
+
+    bench.run([&] {
+        {
+            LOCK2(cs_main, mempool.cs);
+            mempool.removeRecursive(*tx, MemPoolRemovalReason::EXPIRY);
+            LockPoints lp;
+            mempool.addUnchecked(CTxMemPoolEntry(tx, fee, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
+                                                 /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
+        }
+        node.validation_signals->TransactionAddedToMempool(NewMempoolTransactionInfo(tx, fee, GetVirtualTransactionSize(*tx), /*height=*/1,
+                                                                                     /*mempool_limit_bypassed=*/false, /*submitted_in_package=*/false,
+                                                                                     /*chainstate_is_current=*/true, /*has_no_mempool_parents=*/false),
+                                                           mempool.GetAndIncrementSequence());
+        node.validation_signals->SyncWithValidationInterfaceQueue();
+        if (incremental) {
+            LOCK(cs_main);
+            uint64_t sequence;
+            builder.GetTemplate(sequence);
+        } else {
+            PrepareBlock(node, P2WSH_OP_TRUE, assembler_options);
+        }
+    });
+
+    if (incremental) node.validation_signals->UnregisterValidationInterface(&builder);
+}
+
+static void BlockTemplateRebuild(benchmark::Bench& bench) { BlockTemplateChurn(bench, /*incremental=*/false); }
+static void BlockTemplateIncremental(benchmark::Bench& bench) { BlockTemplateChurn(bench, /*incremental=*/true); }
+
 BENCHMARK(AssembleBlock, benchmark::PriorityLevel::HIGH);
 BENCHMARK(BlockAssemblerAddPackageTxns, benchmark::PriorityLevel::LOW);
+BENCHMARK(BlockTemplateRebuild, benchmark::PriorityLevel::LOW);
+BENCHMARK(BlockTemplateIncremental, benchmark::PriorityLevel::LOW);
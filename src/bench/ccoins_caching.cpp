@@ -4,10 +4,14 @@
 
 #include <bench/bench.h>
 #include <coins.h>
+#include <memusage.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
+#include <support/allocators/pool.h>
 #include <test/util/transaction_utils.h>
 
+#include <unordered_map>
 #include <vector>
 
 // Microbenchmark for simple accesses to a CCoinsViewCache database. Note from
@@ -51,3 +55,99 @@ static void CCoinsCaching(benchmark::Bench& bench)
 }
 
 BENCHMARK(CCoinsCaching, benchmark::PriorityLevel::HIGH);
+
+namespace {
+/** The node-based map CCoinsMap used to be, for comparison. */
+using NodeCoinsMap = std::unordered_map<COutPoint,
+                                        CCoinsCacheEntry,
+                                        SaltedOutpointHasher,
+                                        std::equal_to<COutPoint>,
+                                        PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
+                                                      sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
+
+struct NodeMap {
+    NodeCoinsMap::allocator_type::ResourceType resource;
+    NodeCoinsMap map{0, SaltedOutpointHasher{/*deterministic=*/true}, std::equal_to<COutPoint>{}, &resource};
+};
+
+struct DenseMap {
+    CCoinsMap map{SaltedOutpointHasher{/*deterministic=*/true}};
+};
+
+constexpr size_t NUM_COINS{100'000};
+
+std::vector<COutPoint> RandomOutPoints()
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(NUM_COINS);
+    for (size_t i = 0; i < NUM_COINS; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(rng.rand256()), rng.randrange(4));
+    }
+    return outpoints;
+}
+
+template <typename Map>
+void Fill(Map& map, const std::vector<COutPoint>& outpoints)
+{
+    for (const COutPoint& outpoint : outpoints) {
+        Coin coin{CTxOut{1, CScript{} << OP_TRUE}, /*nHeightIn=*/1, /*fCoinBaseIn=*/false};
+        map.try_emplace(outpoint, std::move(coin), CCoinsCacheEntry::DIRTY);
+    }
+}
+
+/** Insert NUM_COINS coins, as when connecting blocks into an empty cache. */
+template <typename Holder>
+void CoinsMapInsert(benchmark::Bench& bench)
+{
+    const auto outpoints{RandomOutPoints()};
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        Holder holder;
+        Fill(holder.map, outpoints);
+        ankerl::nanobench::doNotOptimizeAway(memusage::DynamicUsage(holder.map));
+    });
+}
+
+/** Look up coins in a populated cache, as when checking block inputs. */
+template <typename Holder>
+void CoinsMapLookup(benchmark::Bench& bench)
+{
+    const auto outpoints{RandomOutPoints()};
+    Holder holder;
+    Fill(holder.map, outpoints);
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        for (const COutPoint& outpoint : outpoints) {
+            ankerl::nanobench::doNotOptimizeAway(holder.map.find(outpoint)->second.flags);
+        }
+    });
+}
+
+/** Iterate over and erase all coins, as CCoinsViewDB::BatchWrite does when flushing. */
+template <typename Holder>
+void CoinsMapFlush(benchmark::Bench& bench)
+{
+    const auto outpoints{RandomOutPoints()};
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        Holder holder;
+        Fill(holder.map, outpoints);
+        for (auto it = holder.map.begin(); it != holder.map.end();) {
+            ankerl::nanobench::doNotOptimizeAway(it->second.flags);
+            it = holder.map.erase(it);
+        }
+    });
+}
+} // namespace
+
+static void CCoinsMapInsert(benchmark::Bench& bench) { CoinsMapInsert<DenseMap>(bench); }
+static void CCoinsMapInsertNodeMap(benchmark::Bench& bench) { CoinsMapInsert<NodeMap>(bench); }
+static void CCoinsMapLookup(benchmark::Bench& bench) { CoinsMapLookup<DenseMap>(bench); }
+static void CCoinsMapLookupNodeMap(benchmark::Bench& bench) { CoinsMapLookup<NodeMap>(bench); }
+static void CCoinsMapFlush(benchmark::Bench& bench) { CoinsMapFlush<DenseMap>(bench); }
+static void CCoinsMapFlushNodeMap(benchmark::Bench& bench) { CoinsMapFlush<NodeMap>(bench); }
+
+BENCHMARK(CCoinsMapInsert, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapInsertNodeMap, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapLookup, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapLookupNodeMap, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapFlush, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapFlushNodeMap, benchmark::PriorityLevel::HIGH);
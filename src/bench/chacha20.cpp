@@ -6,6 +6,7 @@
 #include <bench/bench.h>
 #include <crypto/chacha20.h>
 #include <crypto/chacha20poly1305.h>
+#include <tinyformat.h>
 
 /* Number of bytes to process per iteration */
 static const uint64_t BUFFER_SIZE_TINY  = 64;
@@ -24,6 +25,13 @@ static void CHACHA20(benchmark::Bench& bench, size_t buffersize)
     });
 }
 
+static void CHACHA20_1MB_USING(benchmark::Bench& bench, const char* name, chacha20_implementation::UseImplementation use_implementation)
+{
+    bench.name(strprintf("%s using the '%s' ChaCha20 implementation", name, ChaCha20AutoDetect(use_implementation)));
+    CHACHA20(bench, BUFFER_SIZE_LARGE);
+    ChaCha20AutoDetect();
+}
+
 static void FSCHACHA20POLY1305(benchmark::Bench& bench, size_t buffersize)
 {
     std::vector<std::byte> key(32);
@@ -51,6 +59,21 @@ static void CHACHA20_1MB(benchmark::Bench& bench)
     CHACHA20(bench, BUFFER_SIZE_LARGE);
 }
 
+static void CHACHA20_1MB_STANDARD(benchmark::Bench& bench)
+{
+    CHACHA20_1MB_USING(bench, __func__, chacha20_implementation::STANDARD);
+}
+
+static void CHACHA20_1MB_SSE41(benchmark::Bench& bench)
+{
+    CHACHA20_1MB_USING(bench, __func__, chacha20_implementation::USE_SSE41);
+}
+
+static void CHACHA20_1MB_AVX2(benchmark::Bench& bench)
+{
+    CHACHA20_1MB_USING(bench, __func__, chacha20_implementation::USE_ALL);
+}
+
 static void FSCHACHA20POLY1305_64BYTES(benchmark::Bench& bench)
 {
     FSCHACHA20POLY1305(bench, BUFFER_SIZE_TINY);
@@ -69,6 +92,9 @@ static void FSCHACHA20POLY1305_1MB(benchmark::Bench& bench)
 BENCHMARK(CHACHA20_64BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(CHACHA20_256BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(CHACHA20_1MB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CHACHA20_1MB_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CHACHA20_1MB_SSE41, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CHACHA20_1MB_AVX2, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_64BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_256BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_1MB, benchmark::PriorityLevel::HIGH);
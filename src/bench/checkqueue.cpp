@@ -5,11 +5,13 @@
 #include <bench/bench.h>
 #include <checkqueue.h>
 #include <common/system.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
 #include <random.h>
 
+#include <algorithm>
 #include <vector>
 
 static const size_t BATCHES = 101;
@@ -65,3 +67,60 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+
+// Scaling of the CheckQueue over the number of threads (including the
+// master) and the cost of each check, which hashes check_bytes bytes. The
+// checks are added two at a time, like the inputs of typical transactions.
+static void CCheckQueueScaling(benchmark::Bench& bench, int threads, size_t check_bytes)
+{
+    // Oversubscribing the cores does not tell anything about scaling.
+    if (threads > std::max(1, GetNumCores())) return;
+
+    static const size_t CHECKS = 2000;
+    static const std::vector<unsigned char> data(4096, 0x42);
+
+    struct HashJob {
+        size_t bytes;
+        bool operator()()
+        {
+            unsigned char hash[CSHA256::OUTPUT_SIZE];
+            CSHA256().Write(data.data(), bytes).Finalize(hash);
+            return hash[0] != 0 || hash[1] != 0;
+        }
+    };
+
+    CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE, threads - 1};
+    bench.batch(CHECKS).unit("job").run([&] {
+        CCheckQueueControl<HashJob> control(&queue);
+        for (size_t i = 0; i < CHECKS; i += 2) {
+            control.Add({HashJob{check_bytes}, HashJob{check_bytes}});
+        }
+        assert(control.Wait());
+    });
+}
+
+static void CCheckQueueScaling1ThreadSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 1, 64); }
+static void CCheckQueueScaling2ThreadsSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 2, 64); }
+static void CCheckQueueScaling4ThreadsSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 4, 64); }
+static void CCheckQueueScaling8ThreadsSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 8, 64); }
+static void CCheckQueueScaling16ThreadsSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 16, 64); }
+static void CCheckQueueScaling32ThreadsSmall(benchmark::Bench& bench) { CCheckQueueScaling(bench, 32, 64); }
+static void CCheckQueueScaling1ThreadLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 1, 4096); }
+static void CCheckQueueScaling2ThreadsLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 2, 4096); }
+static void CCheckQueueScaling4ThreadsLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 4, 4096); }
+static void CCheckQueueScaling8ThreadsLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 8, 4096); }
+static void CCheckQueueScaling16ThreadsLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 16, 4096); }
+static void CCheckQueueScaling32ThreadsLarge(benchmark::Bench& bench) { CCheckQueueScaling(bench, 32, 4096); }
+
+BENCHMARK(CCheckQueueScaling1ThreadSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling2ThreadsSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling4ThreadsSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling8ThreadsSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling16ThreadsSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling32ThreadsSmall, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling1ThreadLarge, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling2ThreadsLarge, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling4ThreadsLarge, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling8ThreadsLarge, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling16ThreadsLarge, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueScaling32ThreadsLarge, benchmark::PriorityLevel::HIGH);
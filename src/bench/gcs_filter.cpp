@@ -4,6 +4,10 @@
 
 #include <bench/bench.h>
 #include <blockfilter.h>
+#include <random.h>
+
+#include <utility>
+#include <vector>
 
 static GCSFilter::ElementSet GenerateGCSTestElements()
 {
@@ -81,8 +85,72 @@ static void GCSFilterMatch(benchmark::Bench& bench)
         filter.Match(GCSFilter::Element());
     });
 }
+
+/** Block sized filters and a wallet's worth of scripts, to match like scanblocks does. */
+static std::pair<std::vector<GCSFilter>, GCSFilter::ElementSet> GenerateScanTestFilters()
+{
+    constexpr int NUM_FILTERS{100};
+    constexpr int ELEMENTS_PER_FILTER{5000};
+    constexpr int NUM_QUERIES{10000};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    auto random_elements = [&](int count) {
+        GCSFilter::ElementSet elements;
+        while (elements.size() < size_t(count)) elements.insert(rng.randbytes(25));
+        return elements;
+    };
+
+    std::vector<GCSFilter> filters;
+    for (int i = 0; i < NUM_FILTERS; ++i) {
+        filters.emplace_back(GCSFilter::Params{rng.rand64(), rng.rand64(), BASIC_FILTER_P, BASIC_FILTER_M}, random_elements(ELEMENTS_PER_FILTER));
+    }
+    return {std::move(filters), random_elements(NUM_QUERIES)};
+}
+
+static void GCSFilterMatchAnyBlocks(benchmark::Bench& bench)
+{
+    const auto scan{GenerateScanTestFilters()};
+    const std::vector<GCSFilter>& filters{scan.first};
+    const GCSFilter::ElementSet& queries{scan.second};
+
+    bench.batch(filters.size()).unit("filter").run([&] {
+        for (const GCSFilter& filter : filters) {
+            ankerl::nanobench::doNotOptimizeAway(filter.MatchAny(queries));
+        }
+    });
+}
+
+static void GCSFilterMatchAnyBatch(benchmark::Bench& bench)
+{
+    const auto scan{GenerateScanTestFilters()};
+    const std::vector<GCSFilter>& filters{scan.first};
+    const GCSFilter::ElementSet& queries{scan.second};
+    std::vector<const GCSFilter*> filter_ptrs;
+    for (const GCSFilter& filter : filters) filter_ptrs.push_back(&filter);
+
+    bench.batch(filters.size()).unit("filter").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(GCSFilter::MatchAnyBatch(filter_ptrs, queries));
+    });
+}
+
+static void GCSFilterMatchAnyDecoded(benchmark::Bench& bench)
+{
+    const auto scan{GenerateScanTestFilters()};
+    const GCSFilter::ElementSet& queries{scan.second};
+    std::vector<DecodedGCSFilter> filters;
+    for (const GCSFilter& filter : scan.first) filters.emplace_back(filter);
+    std::vector<const DecodedGCSFilter*> filter_ptrs;
+    for (const DecodedGCSFilter& filter : filters) filter_ptrs.push_back(&filter);
+
+    bench.batch(filters.size()).unit("filter").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(DecodedGCSFilter::MatchAnyBatch(filter_ptrs, queries));
+    });
+}
+
 BENCHMARK(GCSBlockFilterGetHash, benchmark::PriorityLevel::HIGH);
 BENCHMARK(GCSFilterConstruct, benchmark::PriorityLevel::HIGH);
 BENCHMARK(GCSFilterDecode, benchmark::PriorityLevel::HIGH);
 BENCHMARK(GCSFilterDecodeSkipCheck, benchmark::PriorityLevel::HIGH);
 BENCHMARK(GCSFilterMatch, benchmark::PriorityLevel::HIGH);
+BENCHMARK(GCSFilterMatchAnyBlocks, benchmark::PriorityLevel::HIGH);
+BENCHMARK(GCSFilterMatchAnyBatch, benchmark::PriorityLevel::HIGH);
+BENCHMARK(GCSFilterMatchAnyDecoded, benchmark::PriorityLevel::HIGH);
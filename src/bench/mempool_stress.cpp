@@ -103,6 +103,23 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+/** Add and remove transactions with many in-mempool parents and children. */
+static void MempoolMemoryUsage(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, /*childTxs=*/800, /*min_ancestors=*/1);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+
+    bench.batch(ordered_coins.size()).unit("tx").run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (auto& tx : ordered_coins) {
+            AddTx(tx, pool);
+        }
+        pool.TrimToSize(0);
+    });
+}
+
 static void MempoolCheck(benchmark::Bench& bench)
 {
     FastRandomContext det_rand{true};
@@ -120,3 +137,4 @@ static void MempoolCheck(benchmark::Bench& bench)
 
 BENCHMARK(ComplexMemPool, benchmark::PriorityLevel::HIGH);
 BENCHMARK(MempoolCheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolMemoryUsage, benchmark::PriorityLevel::HIGH);
@@ -7,6 +7,7 @@
 #include <crypto/poly1305.h>
 
 #include <span.h>
+#include <tinyformat.h>
 
 /* Number of bytes to process per iteration */
 static constexpr uint64_t BUFFER_SIZE_TINY  = 64;
@@ -23,6 +24,13 @@ static void POLY1305(benchmark::Bench& bench, size_t buffersize)
     });
 }
 
+static void POLY1305_1MB_USING(benchmark::Bench& bench, const char* name, poly1305_implementation::UseImplementation use_implementation)
+{
+    bench.name(strprintf("%s using the '%s' Poly1305 implementation", name, Poly1305AutoDetect(use_implementation)));
+    POLY1305(bench, BUFFER_SIZE_LARGE);
+    Poly1305AutoDetect();
+}
+
 static void POLY1305_64BYTES(benchmark::Bench& bench)
 {
     POLY1305(bench, BUFFER_SIZE_TINY);
@@ -38,6 +46,18 @@ static void POLY1305_1MB(benchmark::Bench& bench)
     POLY1305(bench, BUFFER_SIZE_LARGE);
 }
 
+static void POLY1305_1MB_STANDARD(benchmark::Bench& bench)
+{
+    POLY1305_1MB_USING(bench, __func__, poly1305_implementation::STANDARD);
+}
+
+static void POLY1305_1MB_AVX2(benchmark::Bench& bench)
+{
+    POLY1305_1MB_USING(bench, __func__, poly1305_implementation::USE_ALL);
+}
+
 BENCHMARK(POLY1305_64BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(POLY1305_256BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(POLY1305_1MB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(POLY1305_1MB_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(POLY1305_1MB_AVX2, benchmark::PriorityLevel::HIGH);
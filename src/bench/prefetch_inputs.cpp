@@ -0,0 +1,76 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <checkqueue.h>
+#include <coins.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <uint256.h>
+#include <util/chaintype.h>
+#include <validation.h>
+
+#include <set>
+#include <vector>
+
+/**
+ * Replay the input lookups ConnectBlock does for block 413567 against a cold
+ * coins cache on top of an on-disk coins database holding all its inputs,
+ * optionally prefetching the inputs on a number of threads first.
+ */
+static void PrefetchInputs(benchmark::Bench& bench, int threads)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>(ChainType::MAIN)};
+
+    DataStream stream{benchmark::data::block413567};
+    CBlock block;
+    stream >> TX_WITH_WITNESS(block);
+
+    // The inputs ConnectBlock would have to look up in the database.
+    std::vector<COutPoint> prevouts;
+    std::set<Txid> block_txids;
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                if (!block_txids.count(txin.prevout.hash)) prevouts.push_back(txin.prevout);
+            }
+        }
+        block_txids.insert(tx->GetHash());
+    }
+
+    // Use a tiny leveldb cache, so reads are served by the filesystem.
+    CCoinsViewDB db{{.path = testing_setup->m_path_root / "prefetch_coins", .cache_bytes = 1 << 10}, {}};
+    {
+        CCoinsViewCache writer{&db};
+        for (const COutPoint& prevout : prevouts) {
+            writer.AddCoin(prevout, Coin{CTxOut{1, CScript{} << OP_TRUE}, /*nHeightIn=*/1, /*fCoinBaseIn=*/false}, /*possible_overwrite=*/true);
+        }
+        writer.SetBestBlock(uint256::ONE);
+        const bool flushed{writer.Flush()};
+        assert(flushed);
+    }
+
+    CCheckQueue<CCoinPrefetch> queue{/*batch_size=*/16, threads, /*thread_name=*/"prefetch"};
+    bench.unit("block").run([&] {
+        CCoinsViewCache cache{&db};
+        if (threads > 0) PrefetchBlockInputs(block, cache, db, queue);
+        for (const COutPoint& prevout : prevouts) {
+            const bool have{!cache.AccessCoin(prevout).IsSpent()};
+            assert(have);
+        }
+    });
+}
+
+static void PrefetchInputsSerial(benchmark::Bench& bench) { PrefetchInputs(bench, 0); }
+static void PrefetchInputs4Threads(benchmark::Bench& bench) { PrefetchInputs(bench, 4); }
+static void PrefetchInputs16Threads(benchmark::Bench& bench) { PrefetchInputs(bench, 16); }
+
+BENCHMARK(PrefetchInputsSerial, benchmark::PriorityLevel::HIGH);
+BENCHMARK(PrefetchInputs4Threads, benchmark::PriorityLevel::HIGH);
+BENCHMARK(PrefetchInputs16Threads, benchmark::PriorityLevel::HIGH);
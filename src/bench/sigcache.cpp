@@ -0,0 +1,93 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <random.h>
+#include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * Look up cached signatures from a number of threads at once, like the script
+ * check threads do when connecting a block whose transactions were already
+ * accepted to the mempool.
+ */
+static void SigCacheLookup(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    constexpr int NUM_THREADS{4};
+    constexpr size_t NUM_SIGNATURES{1024};
+    constexpr size_t LOOKUPS_PER_THREAD{4096};
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    const CTransaction tx{mtx};
+    PrecomputedTransactionData txdata;
+    const CachingTransactionSignatureChecker checker{&tx, /*nInIn=*/0, /*amountIn=*/0, /*storeIn=*/true, txdata};
+
+    CKey key{GenerateRandomKey()};
+    const CPubKey pubkey{key.GetPubKey()};
+    std::vector<std::pair<uint256, std::vector<unsigned char>>> signatures(NUM_SIGNATURES);
+    for (auto& [sighash, sig] : signatures) {
+        sighash = GetRandHash();
+        key.Sign(sighash, sig);
+        // Adds the signature to the cache
+        if (!checker.VerifyECDSASignature(sig, pubkey, sighash)) throw std::runtime_error("invalid signature");
+    }
+
+    // The workers are started once. Each run of the benchmark hands them a
+    // new round of lookups and waits until all of them are done.
+    Mutex mutex;
+    std::condition_variable cv;
+    uint64_t round{0};
+    int busy{0};
+    bool stop{false};
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> workers;
+    for (int t{0}; t < NUM_THREADS; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t done{0};
+            while (true) {
+                {
+                    WAIT_LOCK(mutex, lock);
+                    cv.wait(lock, [&] { return stop || round != done; });
+                    if (stop) return;
+                    done = round;
+                }
+                for (size_t i{0}; i < LOOKUPS_PER_THREAD; ++i) {
+                    const auto& [sighash, sig]{signatures[(t * 7 + i) % NUM_SIGNATURES]};
+                    if (!checker.VerifyECDSASignature(sig, pubkey, sighash)) ++failures;
+                }
+                LOCK(mutex);
+                if (--busy == 0) cv.notify_all();
+            }
+        });
+    }
+
+    bench.batch(NUM_THREADS * LOOKUPS_PER_THREAD).unit("lookup").run([&] {
+        WAIT_LOCK(mutex, lock);
+        busy = NUM_THREADS;
+        ++round;
+        cv.notify_all();
+        cv.wait(lock, [&] { return busy == 0; });
+    });
+
+    WITH_LOCK(mutex, stop = true);
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+    if (failures > 0) throw std::runtime_error("signature lookup failed");
+}
+
+BENCHMARK(SigCacheLookup, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,81 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <protocol.h>
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+#include <util/fs_helpers.h>
+#include <util/sock.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/socket.h>
+
+/**
+ * Run the socket handler with thousands of connected peers, of which only a few send something in
+ * each iteration, like a listening node whose inbound peers mostly wait for new transactions and
+ * blocks.
+ */
+static void SocketHandlerIdlePeers(benchmark::Bench& bench)
+{
+    constexpr int NUM_PEERS{5000};
+    constexpr int ACTIVE_PER_ITERATION{10};
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::REGTEST)};
+    assert(RaiseFileDescriptorLimit(2 * NUM_PEERS + 1000) >= 2 * NUM_PEERS + 1000);
+
+    ConnmanTestMsg connman{0x1337, 0x1337, *testing_setup->m_node.addrman, *testing_setup->m_node.netgroupman, Params()};
+    std::vector<CNode*> nodes;
+    std::vector<std::unique_ptr<Sock>> remotes;
+    for (NodeId id = 0; id < NUM_PEERS; ++id) {
+        int fds[2];
+        const int ret{socketpair(AF_UNIX, SOCK_STREAM, 0, fds)};
+        assert(ret == 0);
+        auto sock{std::make_shared<Sock>(fds[0])};
+        const bool non_blocking{sock->SetNonBlocking()};
+        assert(non_blocking);
+        remotes.push_back(std::make_unique<Sock>(fds[1]));
+        nodes.push_back(new CNode{id, std::move(sock), CAddress{}, /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0,
+                                  CAddress{}, /*addrNameIn=*/"", ConnectionType::INBOUND, /*inbound_onion=*/false});
+        connman.AddTestNode(*nodes.back());
+    }
+
+    // What an active peer sends in each iteration: a ping, as it appears on the wire
+    V1Transport sender{/*node_id=*/0};
+    CSerializedNetMsg msg{NetMsg::Make(NetMsgType::PING, uint64_t{0})};
+    const bool queued{sender.SetMessageToSend(msg)};
+    assert(queued);
+    const auto& [bytes, _more, _msg_type]{sender.GetBytesToSend(/*have_next_message=*/false)};
+    const std::vector<uint8_t> ping(bytes.begin(), bytes.end());
+
+    // Let the socket handler see every peer once before measuring
+    connman.SocketHandlerPublic();
+
+    size_t next{0};
+    std::vector<CNode*> active;
+    bench.unit("iteration").run([&] {
+        active.clear();
+        for (int i = 0; i < ACTIVE_PER_ITERATION; ++i) {
+            next = (next + 397) % NUM_PEERS;
+            const ssize_t sent{remotes[next]->Send(ping.data(), ping.size(), 0)};
+            assert(sent == ssize_t(ping.size()));
+            active.push_back(nodes[next]);
+        }
+        connman.SocketHandlerPublic();
+        for (CNode* node : active) {
+            while (node->PollMessage()) {}
+        }
+    });
+
+    connman.ClearTestNodes();
+}
+
+BENCHMARK(SocketHandlerIdlePeers, benchmark::PriorityLevel::HIGH);
+#endif // WIN32
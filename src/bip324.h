@@ -66,7 +66,9 @@ public:
 
     /** Encrypt a packet. Only after Initialize().
      *
-     * It must hold that output.size() == contents.size() + EXPANSION.
+     * It must hold that output.size() == contents.size() + EXPANSION. Contents may be at offset
+     * LENGTH_LEN + HEADER_LEN in output, where their ciphertext goes (to encrypt in place), but must
+     * not overlap output otherwise.
      */
     void Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept;
 
@@ -2,12 +2,15 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <algorithm>
+#include <bit>
 #include <mutex>
 #include <set>
 
 #include <blockfilter.h>
 #include <crypto/siphash.h>
 #include <hash.h>
+#include <memusage.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
@@ -59,11 +62,11 @@ GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_fi
 
     // Verify that the encoded filter contains exactly N elements. If it has too much or too little
     // data, a std::ios_base::failure exception will be raised.
-    BitStreamReader bitreader{stream};
+    GolombRiceDecoder decoder{Span{m_encoded}.last(stream.size())};
     for (uint64_t i = 0; i < m_N; ++i) {
-        GolombRiceDecode(bitreader, m_params.m_P);
+        decoder.Decode(m_params.m_P);
     }
-    if (!stream.empty()) {
+    if (!decoder.empty()) {
         throw std::ios_base::failure("encoded_filter contains excess data");
     }
 }
@@ -106,12 +109,12 @@ bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
     uint64_t N = ReadCompactSize(stream);
     assert(N == m_N);
 
-    BitStreamReader bitreader{stream};
+    GolombRiceDecoder decoder{Span{m_encoded}.last(stream.size())};
 
     uint64_t value = 0;
     size_t hashes_index = 0;
     for (uint32_t i = 0; i < m_N; ++i) {
-        uint64_t delta = GolombRiceDecode(bitreader, m_params.m_P);
+        uint64_t delta = decoder.Decode(m_params.m_P);
         value += delta;
 
         while (true) {
@@ -130,6 +133,18 @@ bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
     return false;
 }
 
+bool GCSFilter::MatchUnsorted(Span<const uint64_t> element_hashes, DecodedGCSFilter& scratch) const
+{
+    scratch.Assign(*this);
+    return scratch.MatchHashes(element_hashes);
+}
+
+bool GCSFilter::PreferUnsorted(size_t size) const
+{
+    // Sorting costs about log2(size) steps per element hash, decoding into buckets a few per value.
+    return m_params.m_M > 0 && size * std::bit_width(size) > 2 * static_cast<uint64_t>(m_N);
+}
+
 bool GCSFilter::Match(const Element& element) const
 {
     uint64_t query = HashToRange(element);
@@ -138,10 +153,136 @@ bool GCSFilter::Match(const Element& element) const
 
 bool GCSFilter::MatchAny(const ElementSet& elements) const
 {
+    if (PreferUnsorted(elements.size())) {
+        std::vector<uint64_t> queries;
+        queries.reserve(elements.size());
+        for (const Element& element : elements) {
+            queries.push_back(HashToRange(element));
+        }
+        DecodedGCSFilter scratch;
+        return MatchUnsorted(queries, scratch);
+    }
     const std::vector<uint64_t> queries = BuildHashedSet(elements);
     return MatchInternal(queries.data(), queries.size());
 }
 
+namespace {
+/** Elements stored back to back, which makes hashing them for every filter cache friendly. */
+class PackedElements
+{
+    std::vector<unsigned char> m_data;
+    std::vector<size_t> m_ends;
+
+public:
+    explicit PackedElements(const GCSFilter::ElementSet& elements)
+    {
+        m_ends.reserve(elements.size());
+        for (const GCSFilter::Element& element : elements) {
+            m_data.insert(m_data.end(), element.begin(), element.end());
+            m_ends.push_back(m_data.size());
+        }
+    }
+
+    /** Hash every element to the range [0, F) of a filter with the given params. */
+    void HashToRange(const GCSFilter::Params& params, uint64_t F, std::vector<uint64_t>& hashes_out) const
+    {
+        hashes_out.resize(m_ends.size());
+        size_t begin{0};
+        for (size_t i = 0; i < m_ends.size(); ++i) {
+            const uint64_t hash{CSipHasher(params.m_siphash_k0, params.m_siphash_k1)
+                .Write(Span{m_data}.subspan(begin, m_ends[i] - begin))
+                .Finalize()};
+            hashes_out[i] = FastRange64(hash, F);
+            begin = m_ends[i];
+        }
+    }
+};
+} // namespace
+
+std::vector<bool> GCSFilter::MatchAnyBatch(Span<const GCSFilter* const> filters, const ElementSet& elements)
+{
+    const PackedElements packed{elements};
+    std::vector<bool> results;
+    results.reserve(filters.size());
+    std::vector<uint64_t> queries;
+    DecodedGCSFilter scratch;
+    for (const GCSFilter* filter : filters) {
+        packed.HashToRange(filter->m_params, filter->m_F, queries);
+        if (filter->PreferUnsorted(queries.size())) {
+            results.push_back(filter->MatchUnsorted(queries, scratch));
+        } else {
+            std::sort(queries.begin(), queries.end());
+            results.push_back(filter->MatchInternal(queries.data(), queries.size()));
+        }
+    }
+    return results;
+}
+
+void DecodedGCSFilter::Assign(const GCSFilter& filter)
+{
+    m_params = filter.GetParams();
+    m_N = filter.GetN();
+    m_F = static_cast<uint64_t>(m_N) * static_cast<uint64_t>(m_params.m_M);
+
+    // The values are spread evenly over [0, F), so splitting that range into buckets of 2^shift
+    // <= M values puts about one value in each bucket. Record where each bucket starts, after
+    // which a lookup only needs to check the values of one bucket.
+    m_shift = m_params.m_M > 0 ? static_cast<int>(std::bit_width(m_params.m_M)) - 1 : 0;
+    const size_t num_buckets{m_F > 0 ? static_cast<size_t>((m_F - 1) >> m_shift) + 1 : 1};
+    m_values.resize(m_N);
+    m_bucket_starts.resize(num_buckets + 1);
+
+    const std::vector<unsigned char>& encoded{filter.GetEncoded()};
+    SpanReader stream{encoded};
+    ReadCompactSize(stream);
+    GolombRiceDecoder decoder{Span{encoded}.last(stream.size())};
+    uint64_t value{0};
+    size_t bucket{0};
+    for (uint32_t i = 0; i < m_N; ++i) {
+        value += decoder.Decode(m_params.m_P);
+        m_values[i] = value;
+        // A value outside of [0, F) can only come from a corrupt filter; it never matches.
+        while (bucket <= std::min<uint64_t>(value >> m_shift, num_buckets)) m_bucket_starts[bucket++] = i;
+    }
+    while (bucket <= num_buckets) m_bucket_starts[bucket++] = m_N;
+}
+
+bool DecodedGCSFilter::MatchHashes(Span<const uint64_t> element_hashes) const
+{
+    if (m_N == 0) return false;
+    for (const uint64_t hash : element_hashes) {
+        const size_t b{static_cast<size_t>(hash >> m_shift)};
+        for (uint32_t i = m_bucket_starts[b]; i < m_bucket_starts[b + 1]; ++i) {
+            if (m_values[i] == hash) return true;
+        }
+    }
+    return false;
+}
+
+bool DecodedGCSFilter::MatchAny(const GCSFilter::ElementSet& elements) const
+{
+    const DecodedGCSFilter* filter{this};
+    return MatchAnyBatch(Span{&filter, 1}, elements).front();
+}
+
+std::vector<bool> DecodedGCSFilter::MatchAnyBatch(Span<const DecodedGCSFilter* const> filters, const GCSFilter::ElementSet& elements)
+{
+    const PackedElements packed{elements};
+    std::vector<bool> results;
+    results.reserve(filters.size());
+    std::vector<uint64_t> queries;
+    for (const DecodedGCSFilter* filter : filters) {
+        packed.HashToRange(filter->m_params, filter->m_F, queries);
+        results.push_back(filter->MatchHashes(queries));
+    }
+    return results;
+}
+
+size_t DecodedGCSFilter::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(m_values) + memusage::DynamicUsage(m_bucket_starts);
+}
+
 const std::string& BlockFilterTypeName(BlockFilterType filter_type)
 {
     static std::string unknown_retval;
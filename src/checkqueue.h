@@ -10,7 +10,11 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iterator>
+#include <memory>
+#include <string>
 #include <vector>
 
 /**
@@ -22,12 +26,23 @@
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker (including the master) owns a deque of verifications, which
+  * the master fills round-robin. A worker takes work from the back of its own
+  * deque, and steals from the front of the others' once it runs out, so that
+  * workers only contend with each other when stealing.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! The verifications owned by one worker
+    struct WorkerQueue {
+        Mutex m_mutex;
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! Mutex to protect the idle workers' state
     Mutex m_mutex;
 
     //! Worker threads block on this when out of work
@@ -36,25 +51,28 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! One queue per worker thread, followed by the master's.
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    //! The queue the next verifications are added to. Only used by the master.
+    size_t m_next_queue{0};
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! Incremented (while holding m_mutex) whenever verifications are added,
+    //! so that idle workers don't miss them.
+    std::atomic<uint64_t> m_generation{0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
+    //! The number of worker threads that are idle.
+    int m_idle GUARDED_BY(m_mutex){0};
 
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> m_all_ok{true};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<unsigned int> m_todo{0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -62,63 +80,66 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /** Move a batch of verifications into vChecks, preferably from queue `index`. */
+    bool Take(size_t index, std::vector<T>& vChecks)
+    {
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            WorkerQueue& worker_queue{*m_queues[(index + i) % m_queues.size()]};
+            LOCK(worker_queue.m_mutex);
+            std::deque<T>& checks{worker_queue.m_checks};
+            if (checks.empty()) continue;
+            // Take at most half, so that others can still steal from what is left.
+            const size_t n{std::max<size_t>(1, std::min<size_t>(nBatchSize, checks.size() / 2))};
+            // Own work is taken from the back, stolen work from the front.
+            const auto start_it{i == 0 ? checks.end() - n : checks.begin()};
+            vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(start_it + n));
+            checks.erase(start_it, start_it + n);
+            return true;
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(size_t index, bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+            const uint64_t generation{m_generation.load()};
+            if (Take(index, vChecks)) {
+                // Check whether we need to do work at all
+                if (m_all_ok.load(std::memory_order_relaxed)) {
+                    bool fOk{true};
+                    // execute work
+                    for (T& check : vChecks)
+                        if (fOk)
+                            fOk = check();
+                    if (!fOk) m_all_ok.store(false, std::memory_order_relaxed);
                 }
-                if (m_request_stop) {
-                    return false;
+                const unsigned int nNow = vChecks.size();
+                vChecks.clear();
+                if (m_todo.fetch_sub(nNow) == nNow && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result
+                    WITH_LOCK(m_mutex, m_master_cv.notify_one());
                 }
+                continue;
+            }
 
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                auto start_it = queue.end() - nNow;
-                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.end()));
-                queue.erase(start_it, queue.end());
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+            WAIT_LOCK(m_mutex, lock);
+            if (fMaster) {
+                // Nothing is left to take; wait for the workers to finish theirs.
+                while (m_todo.load() != 0) m_master_cv.wait(lock);
+                // return the current status, and reset it for new work later
+                return m_all_ok.exchange(true);
+            }
+            while (m_generation.load() == generation && !m_request_stop) {
+                m_idle++;
+                m_worker_cv.wait(lock); // wait
+                m_idle--;
+            }
+            if (m_request_stop) {
+                return false;
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
         } while (true);
     }
 
@@ -127,14 +148,17 @@ public:
     Mutex m_control_mutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num)
+    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num, const std::string& thread_name = "scriptch")
         : nBatchSize(batch_size)
     {
+        for (int n = 0; n <= worker_threads_num; ++n) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
+                Loop(n, false /* worker thread */);
             });
         }
     }
@@ -149,7 +173,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(m_worker_threads.size(), true /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -159,13 +183,26 @@ public:
             return;
         }
 
+        m_todo += vChecks.size();
+        // Spread the checks over the workers' queues in contiguous slices.
+        const size_t slice{(vChecks.size() + m_queues.size() - 1) / m_queues.size()};
+        for (auto it = vChecks.begin(); it != vChecks.end();) {
+            const auto end{it + std::min<size_t>(slice, vChecks.end() - it)};
+            WorkerQueue& worker_queue{*m_queues[m_next_queue]};
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            WITH_LOCK(worker_queue.m_mutex, worker_queue.m_checks.insert(worker_queue.m_checks.end(), std::make_move_iterator(it), std::make_move_iterator(end)));
+            it = end;
+        }
+
+        int idle;
         {
             LOCK(m_mutex);
-            queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
+            ++m_generation;
+            idle = m_idle;
         }
-
-        if (vChecks.size() == 1) {
+        if (idle == 0) {
+            return;
+        } else if (vChecks.size() == 1) {
             m_worker_cv.notify_one();
         } else {
             m_worker_cv.notify_all();
@@ -0,0 +1,179 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CLUSTER_LINEARIZE_H
+#define BITCOIN_CLUSTER_LINEARIZE_H
+
+#include <span.h>
+#include <util/check.h>
+#include <util/feefrac.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace cluster_linearize {
+
+/** Index of a transaction within a DepGraph. */
+using ClusterIndex = uint32_t;
+
+/** The fees, sizes and dependencies of a set of transactions, e.g. a cluster in the mempool. */
+class DepGraph
+{
+    std::vector<FeeFrac> m_feerates;
+    std::vector<std::vector<ClusterIndex>> m_parents;
+    std::vector<std::vector<ClusterIndex>> m_children;
+
+public:
+    DepGraph() = default;
+    explicit DepGraph(size_t reserve)
+    {
+        m_feerates.reserve(reserve);
+        m_parents.reserve(reserve);
+        m_children.reserve(reserve);
+    }
+
+    /** Add a transaction without dependencies. Returns its index. */
+    ClusterIndex AddTransaction(const FeeFrac& feerate)
+    {
+        m_feerates.push_back(feerate);
+        m_parents.emplace_back();
+        m_children.emplace_back();
+        return m_feerates.size() - 1;
+    }
+
+    /** Make child spend from parent. The dependencies must not form a cycle. */
+    void AddDependency(ClusterIndex parent, ClusterIndex child)
+    {
+        Assume(parent != child);
+        m_parents[child].push_back(parent);
+        m_children[parent].push_back(child);
+    }
+
+    size_t TxCount() const { return m_feerates.size(); }
+    const FeeFrac& FeeRate(ClusterIndex i) const { return m_feerates[i]; }
+    Span<const ClusterIndex> Parents(ClusterIndex i) const { return m_parents[i]; }
+    Span<const ClusterIndex> Children(ClusterIndex i) const { return m_children[i]; }
+};
+
+/** A chunk of a linearization: its combined fee and size, and the position in the linearization
+ * one past its last transaction. */
+struct Chunk {
+    FeeFrac feerate;
+    size_t end;
+};
+
+/** Order the transactions of a DepGraph for mining, by repeatedly picking the set of remaining
+ * ancestors (including the transaction itself) with the highest feerate.
+ *
+ * This is the same ancestor set based selection BlockAssembler used to do over the whole mempool,
+ * applied to a single cluster. The result is topologically valid: every transaction comes after
+ * its ancestors.
+ *
+ * Runs in O((n + d) log n) for n transactions with d ancestor-descendant pairs between them.
+ */
+inline std::vector<ClusterIndex> Linearize(const DepGraph& depgraph)
+{
+    const size_t count{depgraph.TxCount()};
+    std::vector<ClusterIndex> linearization;
+    linearization.reserve(count);
+    if (count == 0) return linearization;
+
+    // Find the ancestors (including itself) of every transaction, parents first.
+    std::vector<std::vector<ClusterIndex>> ancestors(count);
+    std::vector<std::vector<ClusterIndex>> descendants(count);
+    std::vector<size_t> visited(count, count);
+    for (ClusterIndex i{0}; i < count; ++i) {
+        std::vector<ClusterIndex> todo{i};
+        visited[i] = i;
+        while (!todo.empty()) {
+            const ClusterIndex tx{todo.back()};
+            todo.pop_back();
+            ancestors[i].push_back(tx);
+            for (const ClusterIndex parent : depgraph.Parents(tx)) {
+                if (visited[parent] == i) continue;
+                visited[parent] = i;
+                todo.push_back(parent);
+            }
+        }
+        for (const ClusterIndex ancestor : ancestors[i]) {
+            if (ancestor != i) descendants[ancestor].push_back(i);
+        }
+    }
+
+    // An ancestor has fewer ancestors than any of its descendants, so ordering a set by
+    // ancestor count is topologically valid.
+    const auto topological{[&](ClusterIndex a, ClusterIndex b) {
+        if (ancestors[a].size() != ancestors[b].size()) return ancestors[a].size() < ancestors[b].size();
+        return a < b;
+    }};
+
+    // The feerates of the remaining ancestor sets, best last.
+    std::vector<FeeFrac> ancestor_feerates(count);
+    std::set<std::pair<FeeFrac, ClusterIndex>> candidates;
+    for (ClusterIndex i{0}; i < count; ++i) {
+        for (const ClusterIndex ancestor : ancestors[i]) ancestor_feerates[i] += depgraph.FeeRate(ancestor);
+        candidates.emplace(ancestor_feerates[i], i);
+    }
+
+    std::vector<bool> done(count, false);
+    std::vector<ClusterIndex> selected;
+    while (!candidates.empty()) {
+        const ClusterIndex best{std::prev(candidates.end())->second};
+        selected.clear();
+        for (const ClusterIndex ancestor : ancestors[best]) {
+            if (!done[ancestor]) selected.push_back(ancestor);
+        }
+        std::sort(selected.begin(), selected.end(), topological);
+        for (const ClusterIndex tx : selected) {
+            done[tx] = true;
+            candidates.erase({ancestor_feerates[tx], tx});
+            linearization.push_back(tx);
+        }
+        // The remaining descendants no longer need the selected transactions.
+        for (const ClusterIndex tx : selected) {
+            for (const ClusterIndex descendant : descendants[tx]) {
+                if (done[descendant]) continue;
+                candidates.erase({ancestor_feerates[descendant], descendant});
+                ancestor_feerates[descendant] -= depgraph.FeeRate(tx);
+                candidates.emplace(ancestor_feerates[descendant], descendant);
+            }
+        }
+    }
+    return linearization;
+}
+
+/** Split a linearization into chunks: the groups of consecutive transactions that would be mined
+ * together, because a later transaction pays for an earlier one. The chunk feerates are
+ * decreasing, and together they form the feerate diagram of the linearization. This overload
+ * takes the feerates of the transactions in linearization order. */
+inline std::vector<Chunk> ChunkLinearization(Span<const FeeFrac> feerates)
+{
+    std::vector<Chunk> chunks;
+    chunks.reserve(feerates.size());
+    for (size_t pos{0}; pos < feerates.size(); ++pos) {
+        Chunk chunk{feerates[pos], pos + 1};
+        // Merge with previous chunks as long as this one has a higher feerate
+        while (!chunks.empty() && chunk.feerate >> chunks.back().feerate) {
+            chunk.feerate += chunks.back().feerate;
+            chunks.pop_back();
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+inline std::vector<Chunk> ChunkLinearization(const DepGraph& depgraph, Span<const ClusterIndex> linearization)
+{
+    std::vector<FeeFrac> feerates;
+    feerates.reserve(linearization.size());
+    for (const ClusterIndex tx : linearization) feerates.push_back(depgraph.FeeRate(tx));
+    return ChunkLinearization(feerates);
+}
+
+} // namespace cluster_linearize
+
+#endif // BITCOIN_CLUSTER_LINEARIZE_H
@@ -11,15 +11,14 @@
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
-#include <support/allocators/pool.h>
 #include <uint256.h>
+#include <util/densehashmap.h>
 #include <util/hasher.h>
 
 #include <assert.h>
 #include <stdint.h>
 
 #include <functional>
-#include <unordered_map>
 
 /**
  * A UTXO entry.
@@ -103,7 +102,12 @@ public:
  */
 struct CCoinsCacheEntry
 {
-    Coin coin; // The actual cached data.
+    /**
+     * The actual cached data. Coin ends in 4 bytes of tail padding, which
+     * allows the flags below to be packed into it rather than growing the
+     * entry by another 8 bytes (on platforms whose ABI permits this).
+     */
+    [[no_unique_address]] Coin coin;
     unsigned char flags;
 
     enum Flags {
@@ -133,21 +137,14 @@ struct CCoinsCacheEntry
 };
 
 /**
- * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and adds the size
- * of 4 pointers. We do not know the exact node size used in the std::unordered_node implementation
- * because it is implementation defined. Most implementations have an overhead of 1 or 2 pointers,
- * so nodes can be connected in a linked list, and in some cases the hash value is stored as well.
- * Using an additional sizeof(void*)*4 for MAX_BLOCK_SIZE_BYTES should thus be sufficient so that
- * all implementations can allocate the nodes from the PoolAllocator.
+ * The coins cache map. An open-addressing index with entries stored densely
+ * in a segmented array (see DenseHashMap) avoids the per-node pointer and
+ * allocation overhead of a node-based map, so more coins fit in -dbcache.
+ *
+ * Iterating while erasing (it = map.erase(it)) is supported, which is what
+ * CCoinsView::BatchWrite implementations rely on when flushing.
  */
-using CCoinsMap = std::unordered_map<COutPoint,
-                                     CCoinsCacheEntry,
-                                     SaltedOutpointHasher,
-                                     std::equal_to<COutPoint>,
-                                     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
-                                                   sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
-
-using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
+using CCoinsMap = DenseHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -227,16 +224,12 @@ public:
 /** CCoinsView that adds a memory cache for transactions to another CCoinsView */
 class CCoinsViewCache : public CCoinsViewBacked
 {
-private:
-    const bool m_deterministic;
-
 protected:
     /**
      * Make mutable so that we can "fill the cache" even from Get-methods
      * declared as "const".
      */
     mutable uint256 hashBlock;
-    mutable CCoinsMapMemoryResource m_cache_coins_memory_resource{};
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
@@ -272,10 +265,9 @@ public:
      * more efficient than GetCoin.
      *
      * Generally, do not hold the reference returned for more than a short scope.
-     * While the current implementation allows for modifications to the contents
-     * of the cache while holding the reference, this behavior should not be relied
-     * on! To be safe, best to not hold the returned reference through any other
-     * calls to this cache.
+     * Erasing entries from the cache (e.g. through SpendCoin or Uncache) may
+     * move other entries, invalidating the reference. To be safe, best to not
+     * hold the returned reference through any other calls to this cache.
      */
     const Coin& AccessCoin(const COutPoint &output) const;
 
@@ -294,6 +286,14 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Add a coin that was read from the backing view on behalf of this cache,
+     * e.g. by another thread, as if it had been fetched on a cache miss. Has no
+     * effect if the coin is spent or the cache already has an entry for it.
+     * @sa PrefetchBlockInputs()
+     */
+    void EmplaceFetchedCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -333,11 +333,8 @@ public:
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
-    //! Force a reallocation of the cache map. This is required when downsizing
-    //! the cache because the map's allocator may be hanging onto a lot of
-    //! memory despite having called .clear().
-    //!
-    //! See: https://stackoverflow.com/questions/42114044/how-to-release-unordered-map-memory
+    //! Force a reallocation of the cache map, releasing all memory held by
+    //! it. This is required when downsizing the cache.
     void ReallocateCache();
 
     //! Run an internal sanity check on the cache data structure. */
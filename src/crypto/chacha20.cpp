@@ -5,15 +5,34 @@
 // Based on the public domain implementation 'merged' by D. J. Bernstein
 // See https://cr.yp.to/chacha.html.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
 #include <support/cleanse.h>
 #include <span.h>
 
 #include <algorithm>
+#include <array>
 #include <bit>
+#include <cassert>
+#include <limits>
 #include <string.h>
 
+#include <compat/cpuid.h>
+
+namespace chacha20_sse41
+{
+void Crypt_4way(const uint32_t* input, unsigned char* out, const unsigned char* in);
+}
+
+namespace chacha20_avx2
+{
+void Crypt_8way(const uint32_t* input, unsigned char* out, const unsigned char* in);
+}
+
 #define QUARTERROUND(a,b,c,d) \
   a += b; d = std::rotl(d ^ a, 16); \
   c += d; b = std::rotl(b ^ c, 12); \
@@ -22,6 +41,101 @@
 
 #define REPEAT10(a) do { {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; } while(0)
 
+namespace
+{
+/** Encrypt several consecutive blocks at once, starting at the block counter in input. Writes the
+ *  keystream to out if in is nullptr. */
+typedef void (*CryptMultiType)(const uint32_t* input, unsigned char* out, const unsigned char* in);
+
+CryptMultiType Crypt_4way = nullptr;
+CryptMultiType Crypt_8way = nullptr;
+
+/** Process as many blocks as possible with the multi-block implementations, advancing the block
+ *  counter in input. Returns the number of blocks processed. */
+size_t CryptMulti(uint32_t* input, unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    // The multi-block implementations don't carry a block counter overflow into the nonce, so the
+    // blocks around one are left to the caller.
+    constexpr uint32_t MAX_COUNTER{std::numeric_limits<uint32_t>::max()};
+    size_t done = 0;
+    if (Crypt_8way) {
+        while (blocks - done >= 8 && input[8] <= MAX_COUNTER - 8) {
+            Crypt_8way(input, out + done * ChaCha20Aligned::BLOCKLEN, in ? in + done * ChaCha20Aligned::BLOCKLEN : nullptr);
+            input[8] += 8;
+            done += 8;
+        }
+    }
+    if (Crypt_4way) {
+        while (blocks - done >= 4 && input[8] <= MAX_COUNTER - 4) {
+            Crypt_4way(input, out + done * ChaCha20Aligned::BLOCKLEN, in ? in + done * ChaCha20Aligned::BLOCKLEN : nullptr);
+            input[8] += 4;
+            done += 4;
+        }
+    }
+    return done;
+}
+
+/** Check the multi-block implementations against the standard one, across a block counter overflow. */
+bool SelfTest()
+{
+    std::array<std::byte, ChaCha20Aligned::KEYLEN> key;
+    for (size_t i = 0; i < key.size(); ++i) key[i] = std::byte(i);
+    ChaCha20Aligned cipher{key};
+    std::array<std::byte, 24 * ChaCha20Aligned::BLOCKLEN> multi, single;
+    for (const uint32_t counter : {0U, 0xfffffff0U}) {
+        cipher.Seek({0x03020100, 0x0b0a090807060504}, counter);
+        cipher.Keystream(multi);
+        cipher.Seek({0x03020100, 0x0b0a090807060504}, counter);
+        for (size_t i = 0; i < single.size(); i += ChaCha20Aligned::BLOCKLEN) {
+            cipher.Keystream(Span{single}.subspan(i, ChaCha20Aligned::BLOCKLEN));
+        }
+        if (multi != single) return false;
+    }
+    return true;
+}
+} // namespace
+
+std::string ChaCha20AutoDetect(chacha20_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    Crypt_4way = nullptr;
+    Crypt_8way = nullptr;
+
+#if defined(HAVE_GETCPUID)
+    [[maybe_unused]] bool have_sse41 = false;
+    [[maybe_unused]] bool have_avx2 = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    if (use_implementation & chacha20_implementation::USE_SSE41) {
+        have_sse41 = (ecx >> 19) & 1;
+    }
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if ((use_implementation & chacha20_implementation::USE_AVX2) && have_xsave && have_avx && AVXEnabled()) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_SSE41)
+    if (have_sse41) {
+        Crypt_4way = chacha20_sse41::Crypt_4way;
+        ret += ",sse41(4way)";
+    }
+#endif
+
+#if defined(ENABLE_AVX2)
+    if (have_avx2) {
+        Crypt_8way = chacha20_avx2::Crypt_8way;
+        ret += ",avx2(8way)";
+    }
+#endif
+#endif // defined(HAVE_GETCPUID)
+
+    assert(SelfTest());
+    return ret;
+}
+
 void ChaCha20Aligned::SetKey(Span<const std::byte> key) noexcept
 {
     assert(key.size() == KEYLEN);
@@ -66,6 +180,9 @@ inline void ChaCha20Aligned::Keystream(Span<std::byte> output) noexcept
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    const size_t done = CryptMulti(input, c, nullptr, blocks);
+    blocks -= done;
+    c += done * BLOCKLEN;
     if (!blocks) return;
 
     j4 = input[0];
@@ -169,6 +286,10 @@ inline void ChaCha20Aligned::Crypt(Span<const std::byte> in_bytes, Span<std::byt
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    const size_t done = CryptMulti(input, c, m, blocks);
+    blocks -= done;
+    c += done * BLOCKLEN;
+    m += done * BLOCKLEN;
     if (!blocks) return;
 
     j4 = input[0];
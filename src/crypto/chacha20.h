@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <cstdlib>
 #include <stdint.h>
+#include <string>
 #include <utility>
 
 // classes for ChaCha20 256-bit stream cipher developed by Daniel J. Bernstein
@@ -21,6 +22,20 @@
 // the first 32-bit part of the nonce is automatically incremented, making it
 // conceptually compatible with variants that use a 64/64 split instead.
 
+namespace chacha20_implementation {
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_SSE41 = 1 << 0,
+    USE_AVX2 = 1 << 1,
+    USE_ALL = USE_SSE41 | USE_AVX2,
+};
+}
+
+/** Autodetect the best available implementation for encrypting several ChaCha20 blocks at once.
+ *  Returns the name of the implementation.
+ */
+std::string ChaCha20AutoDetect(chacha20_implementation::UseImplementation use_implementation = chacha20_implementation::USE_ALL);
+
 /** ChaCha20 cipher that only operates on multiples of 64 bytes. */
 class ChaCha20Aligned
 {
@@ -68,7 +83,8 @@ public:
 
     /** en/deciphers the message <input> and write the result into <output>
      *
-     * The size of input and output must be equal, and be a multiple of BLOCKLEN.
+     * The size of input and output must be equal, and be a multiple of BLOCKLEN. They may be the
+     * same buffer (to encrypt in place), but must not overlap otherwise.
      */
     void Crypt(Span<const std::byte> input, Span<std::byte> output) noexcept;
 };
@@ -109,7 +125,8 @@ public:
 
     /** en/deciphers the message <in_bytes> and write the result into <out_bytes>
      *
-     * The size of in_bytes and out_bytes must be equal.
+     * The size of in_bytes and out_bytes must be equal. They may be the same buffer (to encrypt in
+     * place), but must not overlap otherwise.
      */
     void Crypt(Span<const std::byte> in_bytes, Span<std::byte> out_bytes) noexcept;
 
@@ -0,0 +1,95 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline RotL(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+__m256i inline RotL8(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_broadcastsi128_si256(_mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3))); }
+__m256i inline RotL16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_broadcastsi128_si256(_mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2))); }
+
+/** One ChaCha20 quarter round on 8 blocks at once. */
+void ALWAYS_INLINE QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = RotL16(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 12);
+    a = Add(a, b); d = RotL8(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 7);
+}
+
+/** Write 32 bytes of output, xoring them with the input if there is one. */
+void ALWAYS_INLINE Write(unsigned char* out, const unsigned char* in, __m256i v)
+{
+    if (in) v = Xor(v, _mm256_loadu_si256((const __m256i*)in));
+    _mm256_storeu_si256((__m256i*)out, v);
+}
+
+}
+
+void Crypt_8way(const uint32_t* input, unsigned char* out, const unsigned char* in)
+{
+    // Lane i of every vector holds a state word of block i.
+    __m256i j[16] = {
+        K(0x61707865), K(0x3320646e), K(0x79622d32), K(0x6b206574),
+        K(input[0]), K(input[1]), K(input[2]), K(input[3]),
+        K(input[4]), K(input[5]), K(input[6]), K(input[7]),
+        Add(K(input[8]), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)), K(input[9]), K(input[10]), K(input[11]),
+    };
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+
+    for (int round = 0; round < 10; ++round) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+
+    // Transpose every group of 4 words within each 128-bit half, so that the low half of v[g][k]
+    // holds 16 consecutive bytes of block k, and its high half those of block k + 4.
+    __m256i v[4][4];
+    for (int g = 0; g < 4; ++g) {
+        __m256i a = Add(x[4 * g + 0], j[4 * g + 0]);
+        __m256i b = Add(x[4 * g + 1], j[4 * g + 1]);
+        __m256i c = Add(x[4 * g + 2], j[4 * g + 2]);
+        __m256i d = Add(x[4 * g + 3], j[4 * g + 3]);
+        __m256i t0 = _mm256_unpacklo_epi32(a, b);
+        __m256i t1 = _mm256_unpacklo_epi32(c, d);
+        __m256i t2 = _mm256_unpackhi_epi32(a, b);
+        __m256i t3 = _mm256_unpackhi_epi32(c, d);
+        v[g][0] = _mm256_unpacklo_epi64(t0, t1);
+        v[g][1] = _mm256_unpackhi_epi64(t0, t1);
+        v[g][2] = _mm256_unpacklo_epi64(t2, t3);
+        v[g][3] = _mm256_unpackhi_epi64(t2, t3);
+    }
+
+    // Combine the halves of two consecutive groups into 32 consecutive bytes of a block.
+    for (int g = 0; g < 4; g += 2) {
+        for (int k = 0; k < 4; ++k) {
+            const int lo = 64 * k + 16 * g;
+            const int hi = 64 * (k + 4) + 16 * g;
+            Write(out + lo, in ? in + lo : nullptr, _mm256_permute2x128_si256(v[g][k], v[g + 1][k], 0x20));
+            Write(out + hi, in ? in + hi : nullptr, _mm256_permute2x128_si256(v[g][k], v[g + 1][k], 0x31));
+        }
+    }
+}
+
+}
+
+#endif
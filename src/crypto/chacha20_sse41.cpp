@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace chacha20_sse41 {
+namespace {
+
+__m128i inline K(uint32_t x) { return _mm_set1_epi32(x); }
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+__m128i inline RotL(__m128i x, int n) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+__m128i inline RotL8(__m128i x) { return _mm_shuffle_epi8(x, _mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3)); }
+__m128i inline RotL16(__m128i x) { return _mm_shuffle_epi8(x, _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2)); }
+
+/** One ChaCha20 quarter round on 4 blocks at once. */
+void ALWAYS_INLINE QuarterRound(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    a = Add(a, b); d = RotL16(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 12);
+    a = Add(a, b); d = RotL8(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 7);
+}
+
+/** Write 16 bytes of output, xoring them with the input if there is one. */
+void ALWAYS_INLINE Write(unsigned char* out, const unsigned char* in, __m128i v)
+{
+    if (in) v = Xor(v, _mm_loadu_si128((const __m128i*)in));
+    _mm_storeu_si128((__m128i*)out, v);
+}
+
+}
+
+void Crypt_4way(const uint32_t* input, unsigned char* out, const unsigned char* in)
+{
+    // Lane i of every vector holds a state word of block i.
+    __m128i j[16] = {
+        K(0x61707865), K(0x3320646e), K(0x79622d32), K(0x6b206574),
+        K(input[0]), K(input[1]), K(input[2]), K(input[3]),
+        K(input[4]), K(input[5]), K(input[6]), K(input[7]),
+        Add(K(input[8]), _mm_set_epi32(3, 2, 1, 0)), K(input[9]), K(input[10]), K(input[11]),
+    };
+    __m128i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+
+    for (int round = 0; round < 10; ++round) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+
+    // Transpose every group of 4 words, so that each vector holds 16 consecutive bytes of a block.
+    for (int g = 0; g < 4; ++g) {
+        __m128i a = Add(x[4 * g + 0], j[4 * g + 0]);
+        __m128i b = Add(x[4 * g + 1], j[4 * g + 1]);
+        __m128i c = Add(x[4 * g + 2], j[4 * g + 2]);
+        __m128i d = Add(x[4 * g + 3], j[4 * g + 3]);
+        __m128i t0 = _mm_unpacklo_epi32(a, b);
+        __m128i t1 = _mm_unpacklo_epi32(c, d);
+        __m128i t2 = _mm_unpackhi_epi32(a, b);
+        __m128i t3 = _mm_unpackhi_epi32(c, d);
+        const int offset = 16 * g;
+        Write(out + offset, in ? in + offset : nullptr, _mm_unpacklo_epi64(t0, t1));
+        Write(out + 64 + offset, in ? in + 64 + offset : nullptr, _mm_unpackhi_epi64(t0, t1));
+        Write(out + 128 + offset, in ? in + 128 + offset : nullptr, _mm_unpacklo_epi64(t2, t3));
+        Write(out + 192 + offset, in ? in + 192 + offset : nullptr, _mm_unpackhi_epi64(t2, t3));
+    }
+}
+
+}
+
+#endif
@@ -45,7 +45,8 @@ public:
 
     /** Encrypt a message (given split into plain1 + plain2) with a specified 96-bit nonce and aad.
      *
-     * Requires cipher.size() = plain1.size() + plain2.size() + EXPANSION.
+     * Requires cipher.size() = plain1.size() + plain2.size() + EXPANSION. plain2 may be where its
+     * ciphertext goes in cipher (to encrypt in place), but must not overlap cipher otherwise.
      */
     void Encrypt(Span<const std::byte> plain1, Span<const std::byte> plain2, Span<const std::byte> aad, Nonce96 nonce, Span<std::byte> cipher) noexcept;
 
@@ -2,11 +2,36 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <crypto/common.h>
 #include <crypto/poly1305.h>
 
+#include <compat/cpuid.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <string.h>
 
+namespace poly1305_avx2
+{
+void Blocks(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t blocks);
+}
+
+namespace
+{
+/** Process a multiple of 4 non-final blocks at once, updating the 26-bit limbs of h. */
+typedef void (*BlocksMultiType)(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t blocks);
+
+BlocksMultiType Blocks_4way = nullptr;
+
+/** Use Blocks_4way for runs of at least this many blocks, which amortizes computing r^2 to r^4. */
+constexpr size_t MIN_BLOCKS_4WAY{16};
+} // namespace
+
 namespace poly1305_donna {
 
 // Based on the public domain implementation by Andrew Moon
@@ -45,6 +70,13 @@ static void poly1305_blocks(poly1305_context *st, const unsigned char *m, size_t
     uint64_t d0,d1,d2,d3,d4;
     uint32_t c;
 
+    if (Blocks_4way && !st->final && bytes >= MIN_BLOCKS_4WAY * POLY1305_BLOCK_SIZE) {
+        const size_t blocks = (bytes / POLY1305_BLOCK_SIZE) & ~size_t{3};
+        Blocks_4way(st->h, st->r, m, blocks);
+        m += blocks * POLY1305_BLOCK_SIZE;
+        bytes -= blocks * POLY1305_BLOCK_SIZE;
+    }
+
     r0 = st->r[0];
     r1 = st->r[1];
     r2 = st->r[2];
@@ -221,3 +253,55 @@ void poly1305_update(poly1305_context *st, const unsigned char *m, size_t bytes)
 }
 
 }  // namespace poly1305_donna
+
+namespace {
+/** Check the multi-block implementation against the standard one on 37 blocks, with a final partial block. */
+bool SelfTest()
+{
+    std::array<unsigned char, 32> key;
+    std::array<unsigned char, 37 * POLY1305_BLOCK_SIZE + 7> msg;
+    for (size_t i = 0; i < key.size(); ++i) key[i] = 0xff - i;
+    for (size_t i = 0; i < msg.size(); ++i) msg[i] = i * 7 + 3;
+
+    std::array<unsigned char, 16> multi, single;
+    poly1305_donna::poly1305_context ctx;
+    poly1305_donna::poly1305_init(&ctx, key.data());
+    poly1305_donna::poly1305_update(&ctx, msg.data(), msg.size());
+    poly1305_donna::poly1305_finish(&ctx, multi.data());
+    poly1305_donna::poly1305_init(&ctx, key.data());
+    for (size_t i = 0; i < msg.size(); i += POLY1305_BLOCK_SIZE) {
+        poly1305_donna::poly1305_update(&ctx, msg.data() + i, std::min<size_t>(POLY1305_BLOCK_SIZE, msg.size() - i));
+    }
+    poly1305_donna::poly1305_finish(&ctx, single.data());
+    return multi == single;
+}
+} // namespace
+
+std::string Poly1305AutoDetect(poly1305_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    Blocks_4way = nullptr;
+
+#if defined(HAVE_GETCPUID)
+    [[maybe_unused]] bool have_avx2 = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if ((use_implementation & poly1305_implementation::USE_AVX2) && have_xsave && have_avx && AVXEnabled()) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2)
+    if (have_avx2) {
+        Blocks_4way = poly1305_avx2::Blocks;
+        ret += ",avx2(4way)";
+    }
+#endif
+#endif // defined(HAVE_GETCPUID)
+
+    assert(SelfTest());
+    return ret;
+}
@@ -10,9 +10,23 @@
 #include <cassert>
 #include <cstdlib>
 #include <stdint.h>
+#include <string>
 
 #define POLY1305_BLOCK_SIZE 16
 
+namespace poly1305_implementation {
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_AVX2 = 1 << 0,
+    USE_ALL = USE_AVX2,
+};
+}
+
+/** Autodetect the best available implementation for processing several Poly1305 blocks at once.
+ *  Returns the name of the implementation.
+ */
+std::string Poly1305AutoDetect(poly1305_implementation::UseImplementation use_implementation = poly1305_implementation::USE_ALL);
+
 namespace poly1305_donna {
 
 // Based on the public domain implementation by Andrew Moon
@@ -0,0 +1,141 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace poly1305_avx2 {
+namespace {
+
+constexpr uint32_t MASK26{0x3ffffff};
+
+/** Compute a * b modulo 2^130 - 5 with a partial reduction, on numbers in 26-bit limbs. */
+void Multiply(uint32_t out[5], const uint32_t a[5], const uint32_t b[5])
+{
+    const uint64_t s1 = b[1] * 5ULL, s2 = b[2] * 5ULL, s3 = b[3] * 5ULL, s4 = b[4] * 5ULL;
+    uint64_t d0 = (uint64_t)a[0] * b[0] + a[1] * s4 + a[2] * s3 + a[3] * s2 + a[4] * s1;
+    uint64_t d1 = (uint64_t)a[0] * b[1] + (uint64_t)a[1] * b[0] + a[2] * s4 + a[3] * s3 + a[4] * s2;
+    uint64_t d2 = (uint64_t)a[0] * b[2] + (uint64_t)a[1] * b[1] + (uint64_t)a[2] * b[0] + a[3] * s4 + a[4] * s3;
+    uint64_t d3 = (uint64_t)a[0] * b[3] + (uint64_t)a[1] * b[2] + (uint64_t)a[2] * b[1] + (uint64_t)a[3] * b[0] + a[4] * s4;
+    uint64_t d4 = (uint64_t)a[0] * b[4] + (uint64_t)a[1] * b[3] + (uint64_t)a[2] * b[2] + (uint64_t)a[3] * b[1] + (uint64_t)a[4] * b[0];
+
+    d1 += d0 >> 26; d0 &= MASK26;
+    d2 += d1 >> 26; d1 &= MASK26;
+    d3 += d2 >> 26; d2 &= MASK26;
+    d4 += d3 >> 26; d3 &= MASK26;
+    d0 += (d4 >> 26) * 5; d4 &= MASK26;
+    d1 += d0 >> 26; d0 &= MASK26;
+
+    out[0] = d0;
+    out[1] = d1;
+    out[2] = d2;
+    out[3] = d3;
+    out[4] = d4;
+}
+
+__m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Mul(__m256i x, __m256i y) { return _mm256_mul_epu32(x, y); }
+__m256i inline And(__m256i x, __m256i y) { return _mm256_and_si256(x, y); }
+__m256i inline Or(__m256i x, __m256i y) { return _mm256_or_si256(x, y); }
+__m256i inline ShR(__m256i x, int n) { return _mm256_srli_epi64(x, n); }
+__m256i inline ShL(__m256i x, int n) { return _mm256_slli_epi64(x, n); }
+
+/** A power of r per 64-bit lane, in 26-bit limbs, and those limbs multiplied by 5. */
+struct Powers {
+    __m256i r[5];
+    __m256i s[5];
+};
+
+Powers MakePowers(const uint32_t* lane0, const uint32_t* lane1, const uint32_t* lane2, const uint32_t* lane3)
+{
+    Powers p;
+    for (int i = 0; i < 5; ++i) {
+        p.r[i] = _mm256_set_epi64x(lane3[i], lane2[i], lane1[i], lane0[i]);
+        p.s[i] = _mm256_set_epi64x(lane3[i] * 5ULL, lane2[i] * 5ULL, lane1[i] * 5ULL, lane0[i] * 5ULL);
+    }
+    return p;
+}
+
+/** Multiply the accumulator in every lane by the lane's power of r, with a partial reduction. */
+void ALWAYS_INLINE MultiplyLanes(__m256i h[5], const Powers& p)
+{
+    __m256i d0 = Add(Add(Add(Mul(h[0], p.r[0]), Mul(h[1], p.s[4])), Add(Mul(h[2], p.s[3]), Mul(h[3], p.s[2]))), Mul(h[4], p.s[1]));
+    __m256i d1 = Add(Add(Add(Mul(h[0], p.r[1]), Mul(h[1], p.r[0])), Add(Mul(h[2], p.s[4]), Mul(h[3], p.s[3]))), Mul(h[4], p.s[2]));
+    __m256i d2 = Add(Add(Add(Mul(h[0], p.r[2]), Mul(h[1], p.r[1])), Add(Mul(h[2], p.r[0]), Mul(h[3], p.s[4]))), Mul(h[4], p.s[3]));
+    __m256i d3 = Add(Add(Add(Mul(h[0], p.r[3]), Mul(h[1], p.r[2])), Add(Mul(h[2], p.r[1]), Mul(h[3], p.r[0]))), Mul(h[4], p.s[4]));
+    __m256i d4 = Add(Add(Add(Mul(h[0], p.r[4]), Mul(h[1], p.r[3])), Add(Mul(h[2], p.r[2]), Mul(h[3], p.r[1]))), Mul(h[4], p.r[0]));
+
+    const __m256i mask = K(MASK26);
+    d1 = Add(d1, ShR(d0, 26)); h[0] = And(d0, mask);
+    d2 = Add(d2, ShR(d1, 26)); h[1] = And(d1, mask);
+    d3 = Add(d3, ShR(d2, 26)); h[2] = And(d2, mask);
+    d4 = Add(d4, ShR(d3, 26)); h[3] = And(d3, mask);
+    const __m256i c = ShR(d4, 26); h[4] = And(d4, mask);
+    h[0] = Add(h[0], Add(c, ShL(c, 2)));
+    h[1] = Add(h[1], ShR(h[0], 26)); h[0] = And(h[0], mask);
+}
+
+}
+
+void Blocks(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t blocks)
+{
+    // Every lane accumulates every 4th block, multiplying by r^4 in between. The lanes are
+    // multiplied by the remaining powers of r after their last block and added up, which gives
+    // the same result as processing the blocks one by one.
+    uint32_t r2[5], r3[5], r4[5];
+    Multiply(r2, r, r);
+    Multiply(r3, r2, r);
+    Multiply(r4, r3, r);
+    // The lanes hold blocks 0, 2, 1 and 3 of every group of 4 (see below).
+    const Powers step = MakePowers(r4, r4, r4, r4);
+    const Powers last = MakePowers(r4, r2, r3, r);
+
+    __m256i acc[5];
+    for (int i = 0; i < 5; ++i) acc[i] = _mm256_set_epi64x(0, 0, 0, h[i]);
+
+    const __m256i mask = K(MASK26);
+    const __m256i hibit = K(1 << 24); /* 1 << 128 */
+    for (size_t i = 0; i < blocks; i += 4) {
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(m + 16 * i));
+        const __m256i b = _mm256_loadu_si256((const __m256i*)(m + 16 * i + 32));
+        // The first and last 8 bytes of blocks 0, 2, 1 and 3.
+        const __m256i lo = _mm256_unpacklo_epi64(a, b);
+        const __m256i hi = _mm256_unpackhi_epi64(a, b);
+
+        /* h += m[i] */
+        acc[0] = Add(acc[0], And(lo, mask));
+        acc[1] = Add(acc[1], And(ShR(lo, 26), mask));
+        acc[2] = Add(acc[2], And(Or(ShR(lo, 52), ShL(hi, 12)), mask));
+        acc[3] = Add(acc[3], And(ShR(hi, 14), mask));
+        acc[4] = Add(acc[4], Or(ShR(hi, 40), hibit));
+
+        MultiplyLanes(acc, i + 4 < blocks ? step : last);
+    }
+
+    // Add up the lanes, and carry like the partial reduction does.
+    alignas(32) uint64_t lanes[4];
+    uint64_t d[5];
+    for (int i = 0; i < 5; ++i) {
+        _mm256_store_si256((__m256i*)lanes, acc[i]);
+        d[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    d[1] += d[0] >> 26; d[0] &= MASK26;
+    d[2] += d[1] >> 26; d[1] &= MASK26;
+    d[3] += d[2] >> 26; d[2] &= MASK26;
+    d[4] += d[3] >> 26; d[3] &= MASK26;
+    d[0] += (d[4] >> 26) * 5; d[4] &= MASK26;
+    d[1] += d[0] >> 26; d[0] &= MASK26;
+    for (int i = 0; i < 5; ++i) h[i] = d[i];
+}
+
+}
+
+#endif
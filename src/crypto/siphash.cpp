@@ -4,6 +4,8 @@
 
 #include <crypto/siphash.h>
 
+#include <crypto/common.h>
+
 #include <bit>
 
 #define SIPROUND do { \
@@ -52,6 +54,18 @@ CSipHasher& CSipHasher::Write(Span<const unsigned char> data)
     uint8_t c = count;
 
     while (data.size() > 0) {
+        if ((c & 7) == 0 && data.size() >= 8) {
+            // Process a whole little-endian word at once.
+            t = ReadLE64(data.data());
+            c += 8;
+            v3 ^= t;
+            SIPROUND;
+            SIPROUND;
+            v0 ^= t;
+            t = 0;
+            data = data.subspan(8);
+            continue;
+        }
         t |= uint64_t{data.front()} << (8 * (c % 8));
         c++;
         if ((c & 7) == 0) {
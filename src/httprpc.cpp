@@ -9,6 +9,7 @@
 #include <httpserver.h>
 #include <logging.h>
 #include <netaddress.h>
+#include <rpc/json_stream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -21,6 +22,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
@@ -145,6 +147,95 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** Work class of a JSON-RPC call, given the cost of its method. Malformed calls
+ * are left for the handler to reject.
+ */
+static HTTPWorkClass RPCMethodWorkClass(const UniValue& request)
+{
+    if (!request.isObject()) return HTTPWorkClass::MEDIUM;
+    const UniValue& method{request.find_value("method")};
+    if (!method.isStr()) return HTTPWorkClass::MEDIUM;
+    switch (tableRPC.GetCost(method.get_str())) {
+    case RPCCost::CHEAP: return HTTPWorkClass::CHEAP;
+    case RPCCost::MEDIUM: return HTTPWorkClass::MEDIUM;
+    case RPCCost::HEAVY: return HTTPWorkClass::HEAVY;
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+/** Determine the work class of a JSON-RPC request from the methods it calls. */
+static HTTPWorkClass JSONRPCWorkClass(const UniValue& request)
+{
+    if (!request.isArray()) return RPCMethodWorkClass(request);
+    // A batch is never cheap, and as expensive as its most expensive call
+    HTTPWorkClass work_class{HTTPWorkClass::MEDIUM};
+    for (const UniValue& call : request.getValues()) {
+        work_class = std::max(work_class, RPCMethodWorkClass(call));
+    }
+    return work_class;
+}
+
+/** Execute a parsed and authorized JSON-RPC request and send the reply. */
+static bool ExecuteJSONRPC(HTTPRequest* req, JSONRPCRequest& jreq, const UniValue& valRequest)
+{
+    try {
+        std::string strReply;
+        // singleton request
+        if (valRequest.isObject()) {
+            // Let the method stream a large result into a chunked reply. The
+            // reply is started once the first chunk is ready, so that errors
+            // raised before that can still be reported normally.
+            bool reply_started{false};
+            JSONStreamWriter result_stream{[&](std::string_view chunk) {
+                if (!reply_started) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartChunkedReply(HTTP_OK);
+                    req->WriteReplyChunk(MakeByteSpan(std::string_view{"{\"result\":"}));
+                    reply_started = true;
+                }
+                req->WriteReplyChunk(MakeByteSpan(chunk));
+            }};
+            jreq.result_stream = &result_stream;
+
+            UniValue result;
+            try {
+                result = tableRPC.execute(jreq);
+            } catch (...) {
+                if (!reply_started) throw;
+                // The status has been sent already, so the error can't be reported anymore
+                LogPrintf("RPC method %s failed after sending part of its result\n", jreq.strMethod);
+                req->EndChunkedReply();
+                return false;
+            }
+
+            if (result_stream.Started()) {
+                // Finish the reply the way JSONRPCReply would
+                result_stream.Flush();
+                req->WriteReplyChunk(MakeByteSpan(",\"error\":null,\"id\":" + jreq.id.write() + "}\n"));
+                req->EndChunkedReply();
+                return true;
+            }
+
+            // Send reply
+            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+
+        // array of requests
+        } else {
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+        }
+
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strReply);
+    } catch (const UniValue& objError) {
+        JSONErrorReply(req, objError, jreq.id);
+        return false;
+    } catch (const std::exception& e) {
+        JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        return false;
+    }
+    return true;
+}
+
 static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
 {
     // JSONRPC handles only POST
@@ -176,16 +267,15 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         return false;
     }
 
+    UniValue valRequest;
     try {
         // Parse request
-        UniValue valRequest;
         if (!valRequest.read(req->ReadBody()))
             throw JSONRPCError(RPC_PARSE_ERROR, "Parse error");
 
         // Set the URI
         jreq.URI = req->GetURI();
 
-        std::string strReply;
         bool user_has_whitelist = g_rpc_whitelist.count(jreq.authUser);
         if (!user_has_whitelist && g_rpc_whitelist_default) {
             LogPrintf("RPC User %s not allowed to call any methods\n", jreq.authUser);
@@ -200,10 +290,6 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
-            UniValue result = tableRPC.execute(jreq);
-
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -223,13 +309,9 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
-
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
@@ -237,6 +319,14 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
+
+    // Requests are authorized and parsed by the workers for cheap calls. Any
+    // other call is passed on to the workers for its cost class.
+    const HTTPWorkClass work_class{JSONRPCWorkClass(valRequest)};
+    if (work_class == HTTPWorkClass::CHEAP) return ExecuteJSONRPC(req, jreq, valRequest);
+    req->Defer(work_class, [jreq = std::move(jreq), valRequest = std::move(valRequest)](HTTPRequest* req, const std::string&) mutable {
+        return ExecuteJSONRPC(req, jreq, valRequest);
+    });
     return true;
 }
 
@@ -300,9 +390,9 @@ bool StartHTTPRPC(const std::any& context)
         return false;
 
     auto handle_rpc = [context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
-    RegisterHTTPHandler("/", true, handle_rpc);
+    RegisterHTTPHandler("/", true, handle_rpc, HTTPWorkClass::CHEAP);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, handle_rpc);
+        RegisterHTTPHandler("/wallet/", false, handle_rpc, HTTPWorkClass::CHEAP);
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -20,16 +20,21 @@
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
+#include <util/mpmcqueue.h>
+#include <util/time.h>
 #include <util/translation.h>
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
-#include <deque>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -51,8 +56,8 @@ static const size_t MAX_HEADERS_SIZE = 8192;
 class HTTPWorkItem final : public HTTPClosure
 {
 public:
-    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func):
-        req(std::move(_req)), path(_path), func(_func)
+    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, HTTPRequestHandler _func):
+        req(std::move(_req)), path(_path), func(std::move(_func))
     {
     }
     void operator()() override
@@ -60,79 +65,153 @@ public:
         func(req.get(), path);
     }
 
+    const std::string& GetPath() const { return path; }
+
     std::unique_ptr<HTTPRequest> req;
+    //! When the item was queued, to measure queueing latency
+    SteadyClock::time_point m_queued;
 
 private:
     std::string path;
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Queue item for handling on the worker threads of work_class, or reject the request if it is full. */
+static void DispatchWorkItem(std::unique_ptr<HTTPWorkItem> item, HTTPWorkClass work_class);
+
+/** Work queue and worker threads for requests of one HTTPWorkClass.
+ *
+ * Work items are passed through a lock-free queue, so producers and consumers
+ * do not serialize on a mutex. The mutex and condition variable only let idle
+ * workers sleep until an item is queued or they have to exit.
  */
-template <typename WorkItem>
-class WorkQueue
+class HTTPWorkQueue
 {
 private:
-    Mutex cs;
-    std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
-    bool running GUARDED_BY(cs){true};
-    const size_t maxDepth;
-
-public:
-    explicit WorkQueue(size_t _maxDepth) : maxDepth(_maxDepth)
+    const HTTPWorkClass m_class;
+    const size_t m_max_depth;
+    MPMCQueue<std::unique_ptr<HTTPWorkItem>> m_queue;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Number of queued items, including those whose push is in progress
+    std::atomic<size_t> m_depth{0};
+    std::atomic<bool> m_running{true};
+    std::vector<std::thread> m_workers;
+
+    std::atomic<uint64_t> m_processed{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<int64_t> m_total_wait_us{0};
+    std::atomic<int64_t> m_max_wait_us{0};
+    std::atomic<int64_t> m_total_run_us{0};
+
+    void Run(int worker_num)
     {
+        util::ThreadRename(strprintf("http%s.%i", m_class == HTTPWorkClass::MEDIUM ? "worker" : HTTPWorkClassString(m_class), worker_num));
+        while (true) {
+            std::optional<std::unique_ptr<HTTPWorkItem>> item;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                // Items are pushed before the mutex is taken to notify about
+                // them, so none can be missed between a check and the wait.
+                m_cv.wait(lock, [&] { return (item = m_queue.TryPop()) || (!m_running && m_depth == 0); });
+                if (!item) return;
+            }
+            --m_depth;
+
+            const auto start{SteadyClock::now()};
+            const int64_t wait_us{Ticks<std::chrono::microseconds>(start - (*item)->m_queued)};
+            (**item)();
+            if (auto deferred{(*item)->req->TakeDeferred()}) {
+                DispatchWorkItem(std::make_unique<HTTPWorkItem>(std::move((*item)->req), (*item)->GetPath(), std::move(deferred->second)), deferred->first);
+            }
+            item->reset();
+            const int64_t run_us{Ticks<std::chrono::microseconds>(SteadyClock::now() - start)};
+
+            ++m_processed;
+            m_total_wait_us += wait_us;
+            m_total_run_us += run_us;
+            int64_t max_wait_us{m_max_wait_us.load()};
+            while (wait_us > max_wait_us && !m_max_wait_us.compare_exchange_weak(max_wait_us, wait_us)) {}
+        }
     }
-    /** Precondition: worker threads have all stopped (they have been joined).
-     */
-    ~WorkQueue() = default;
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+
+public:
+    HTTPWorkQueue(HTTPWorkClass work_class, size_t max_depth) : m_class{work_class}, m_max_depth{max_depth}, m_queue{max_depth} {}
+
+    /** Precondition: worker threads have all stopped (they have been joined). */
+    ~HTTPWorkQueue() = default;
+
+    /** Enqueue a work item. Takes ownership of item only if successful. */
+    bool Enqueue(std::unique_ptr<HTTPWorkItem>& item)
     {
-        LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!m_running) return false;
+        if (++m_depth > m_max_depth) {
+            --m_depth;
+            ++m_rejected;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        item->m_queued = SteadyClock::now();
+        // Cannot fail, as the queue has room for at least m_max_depth items
+        const bool pushed{m_queue.TryPush(item)};
+        Assume(pushed);
+        WITH_LOCK(m_mutex, m_cv.notify_one());
         return true;
     }
-    /** Thread function */
-    void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+
+    void Start(int threads)
     {
-        while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running && queue.empty())
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
-            }
-            (*i)();
+        for (int i = 0; i < threads; i++) {
+            m_workers.emplace_back(&HTTPWorkQueue::Run, this, i);
+        }
+    }
+
+    /** Let the worker threads exit once the queue is empty */
+    void Interrupt()
+    {
+        WITH_LOCK(m_mutex, m_running = false);
+        m_cv.notify_all();
+    }
+
+    /** Wait for the worker threads to exit, and drop the requests that were
+     * queued concurrently with Interrupt(), which makes them reply with an error.
+     */
+    void Join()
+    {
+        for (auto& thread : m_workers) {
+            thread.join();
+        }
+        m_workers.clear();
+        while (m_queue.TryPop()) {
+            --m_depth;
         }
     }
-    /** Interrupt and exit loops */
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+
+    HTTPWorkQueueStats GetStats() const
     {
-        LOCK(cs);
-        running = false;
-        cond.notify_all();
+        return HTTPWorkQueueStats{
+            .work_class = m_class,
+            .threads = int(m_workers.size()),
+            .depth = m_depth,
+            .max_depth = m_max_depth,
+            .processed = m_processed,
+            .rejected = m_rejected,
+            .total_wait = std::chrono::microseconds{m_total_wait_us},
+            .max_wait = std::chrono::microseconds{m_max_wait_us},
+            .total_run = std::chrono::microseconds{m_total_run_us},
+        };
     }
 };
 
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPWorkClass _work_class):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), work_class(_work_class)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPWorkClass work_class;
 };
 
 /** HTTP module state */
@@ -143,8 +222,8 @@ static struct event_base* eventBase = nullptr;
 static struct evhttp* eventHTTP = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static std::unique_ptr<WorkQueue<HTTPClosure>> g_work_queue{nullptr};
+//! Work queues for handling longer requests off the event loop thread, indexed by HTTPWorkClass
+static std::array<std::unique_ptr<HTTPWorkQueue>, 3> g_work_queues;
 //! Handlers for (sub)paths
 static GlobalMutex g_httppathhandlers_mutex;
 static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_mutex);
@@ -258,6 +337,19 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     assert(false);
 }
 
+std::string HTTPWorkClassString(HTTPWorkClass work_class)
+{
+    switch (work_class) {
+    case HTTPWorkClass::CHEAP:
+        return "cheap";
+    case HTTPWorkClass::MEDIUM:
+        return "medium";
+    case HTTPWorkClass::HEAVY:
+        return "heavy";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
@@ -325,19 +417,21 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
-        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
-        assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
-            item.release(); /* if true, queue took ownership */
-        } else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
-            item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
-        }
+        DispatchWorkItem(std::make_unique<HTTPWorkItem>(std::move(hreq), path, i->handler), i->work_class);
     } else {
         hreq->WriteReply(HTTP_NOT_FOUND);
     }
 }
 
+static void DispatchWorkItem(std::unique_ptr<HTTPWorkItem> item, HTTPWorkClass work_class)
+{
+    HTTPWorkQueue& queue{*Assert(g_work_queues[static_cast<size_t>(work_class)])};
+    if (!queue.Enqueue(item)) {
+        LogPrintf("WARNING: %s request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n", HTTPWorkClassString(work_class));
+        item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
+    }
+}
+
 /** Callback to reject HTTP requests after shutdown. */
 static void http_reject_request_cb(struct evhttp_request* req, void*)
 {
@@ -397,13 +491,6 @@ static bool HTTPBindAddresses(struct evhttp* http)
     return !boundSockets.empty();
 }
 
-/** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
-{
-    util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    queue->Run();
-}
-
 /** libevent event log callback */
 static void libevent_log_cb(int severity, const char *msg)
 {
@@ -463,9 +550,11 @@ bool InitHTTPServer(const util::SignalInterrupt& interrupt)
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogDebug(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
+    LogDebug(BCLog::HTTP, "creating work queues of depth %d\n", workQueueDepth);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    for (const HTTPWorkClass work_class : {HTTPWorkClass::CHEAP, HTTPWorkClass::MEDIUM, HTTPWorkClass::HEAVY}) {
+        g_work_queues[static_cast<size_t>(work_class)] = std::make_unique<HTTPWorkQueue>(work_class, workQueueDepth);
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -481,17 +570,23 @@ void UpdateHTTPServerLogging(bool enable) {
 }
 
 static std::thread g_thread_http;
-static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer()
 {
-    int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogInfo("Starting HTTP server with %d worker threads\n", rpcThreads);
+    // -rpcthreads is the total number of worker threads. A quarter of them,
+    // but at least one, serve cheap requests, so those stay fast however busy
+    // the others are. Another quarter, at least one, serve heavy requests, so
+    // those cannot occupy every thread. Medium requests get the rest.
+    const int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), long{MIN_HTTP_THREADS});
+    const int cheap_threads{std::max(1, rpcThreads / 4)};
+    const int heavy_threads{std::max(1, rpcThreads / 4)};
+    const int medium_threads{rpcThreads - cheap_threads - heavy_threads};
+    LogInfo("Starting HTTP server with %d worker threads (%d for cheap, %d for medium and %d for heavy requests)\n", rpcThreads, cheap_threads, medium_threads, heavy_threads);
     g_thread_http = std::thread(ThreadHTTP, eventBase);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, g_work_queue.get(), i);
-    }
+    g_work_queues[static_cast<size_t>(HTTPWorkClass::CHEAP)]->Start(cheap_threads);
+    g_work_queues[static_cast<size_t>(HTTPWorkClass::MEDIUM)]->Start(medium_threads);
+    g_work_queues[static_cast<size_t>(HTTPWorkClass::HEAVY)]->Start(heavy_threads);
 }
 
 void InterruptHTTPServer()
@@ -501,20 +596,17 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
-    if (g_work_queue) {
-        g_work_queue->Interrupt();
+    for (const auto& queue : g_work_queues) {
+        if (queue) queue->Interrupt();
     }
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (g_work_queue) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto& thread : g_thread_http_workers) {
-            thread.join();
-        }
-        g_thread_http_workers.clear();
+    LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
+    for (const auto& queue : g_work_queues) {
+        if (queue) queue->Join();
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
@@ -543,10 +635,21 @@ void StopHTTPServer()
         event_base_free(eventBase);
         eventBase = nullptr;
     }
-    g_work_queue.reset();
+    for (auto& queue : g_work_queues) {
+        queue.reset();
+    }
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    std::vector<HTTPWorkQueueStats> stats;
+    for (const auto& queue : g_work_queues) {
+        if (queue) stats.push_back(queue->GetStats());
+    }
+    return stats;
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -585,7 +688,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, const util::SignalInterrup
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (m_chunked && !replySent) {
+        // The status was sent already, so all that can be done is to end the reply
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -624,6 +731,12 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+void HTTPRequest::Defer(HTTPWorkClass work_class, HTTPRequestHandler handler)
+{
+    assert(!replySent && !m_deferred);
+    m_deferred.emplace(work_class, std::move(handler));
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -631,12 +744,28 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket once a reply has been sent. This is the
+ * second part of the libevent workaround in http_request_cb.
+ */
+static void ReenableReading(evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
-void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+void HTTPRequest::WriteReply(int nStatus, Span<const std::byte> reply)
 {
     assert(!replySent && req);
     if (m_interrupt) {
@@ -645,21 +774,54 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    evbuffer_add(evb, reply.data(), reply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
-        }
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && !m_chunked && req);
+    if (m_interrupt) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    m_chunked = true;
+}
+
+void HTTPRequest::WriteReplyChunk(Span<const std::byte> chunk)
+{
+    assert(!replySent && m_chunked && req);
+    if (chunk.empty()) return;
+    // The chunk is copied here, as it is only sent once the main http thread gets to it
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb]{
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && m_chunked && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        evhttp_send_reply_end(req_copy);
+        ReenableReading(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -741,11 +903,11 @@ std::optional<std::string> GetQueryParameterFromUri(const char* uri, const std::
     return result;
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, HTTPWorkClass work_class)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
     LOCK(g_httppathhandlers_mutex);
-    pathHandlers.emplace_back(prefix, exactMatch, handler);
+    pathHandlers.emplace_back(prefix, exactMatch, handler, work_class);
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -5,15 +5,25 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <span.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace util {
 class SignalInterrupt;
 } // namespace util
 
 static const int DEFAULT_HTTP_THREADS=4;
+/** One worker thread for each HTTPWorkClass */
+static const int MIN_HTTP_THREADS=3;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
@@ -39,16 +49,47 @@ void StopHTTPServer();
 /** Change logging level for libevent. */
 void UpdateHTTPServerLogging(bool enable);
 
+/** Cost class of a request. Each class is served by its own pool of worker
+ * threads and its own work queue, so cheap requests do not have to wait behind
+ * expensive ones.
+ */
+enum class HTTPWorkClass {
+    CHEAP,
+    MEDIUM,
+    HEAVY,
+};
+std::string HTTPWorkClassString(HTTPWorkClass work_class);
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
  * be invoked.
+ * The handler is run by the worker threads of work_class. A handler that can
+ * only tell the cost of a request once it has looked at it can pass it on to
+ * another class with HTTPRequest::Defer.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, HTTPWorkClass work_class = HTTPWorkClass::MEDIUM);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+struct HTTPWorkQueueStats {
+    HTTPWorkClass work_class;
+    int threads;
+    //! Number of queued requests that are not being handled yet
+    size_t depth;
+    size_t max_depth;
+    uint64_t processed;
+    //! Number of requests rejected because the queue was full
+    uint64_t rejected;
+    //! Time requests spent in the queue, and being handled
+    std::chrono::microseconds total_wait;
+    std::chrono::microseconds max_wait;
+    std::chrono::microseconds total_run;
+};
+/** Statistics of the work queues of the HTTP server, empty if it has not been initialized. */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -63,6 +104,8 @@ private:
     struct evhttp_request* req;
     const util::SignalInterrupt& m_interrupt;
     bool replySent;
+    bool m_chunked{false};
+    std::optional<std::pair<HTTPWorkClass, HTTPRequestHandler>> m_deferred;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, const util::SignalInterrupt& interrupt, bool replySent = false);
@@ -123,12 +166,42 @@ public:
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
-     * strReply is the body of the reply. Keep it empty to send a standard message.
+     * reply is the body of the reply. Keep it empty to send a standard message.
      *
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
-    void WriteReply(int nStatus, const std::string& strReply = "");
+    void WriteReply(int nStatus, std::string_view reply = "")
+    {
+        WriteReply(nStatus, MakeByteSpan(reply));
+    }
+    void WriteReply(int nStatus, Span<const std::byte> reply);
+
+    /**
+     * Start an HTTP reply whose body is sent in chunks, for large replies that
+     * are produced incrementally. Use instead of WriteReply, followed by any
+     * number of WriteReplyChunk calls and a final EndChunkedReply.
+     */
+    void StartChunkedReply(int nStatus);
+    void WriteReplyChunk(Span<const std::byte> chunk);
+    /**
+     * Finish a chunked HTTP reply.
+     *
+     * @note Like WriteReply, do not call any other HTTPRequest methods after calling this.
+     */
+    void EndChunkedReply();
+
+    /**
+     * Let handler finish the request on the worker threads of work_class,
+     * once the current handler has returned. The request is rejected if the
+     * work queue of that class is full.
+     *
+     * @note Call this from a request handler instead of replying.
+     */
+    void Defer(HTTPWorkClass work_class, HTTPRequestHandler handler);
+
+    /** Take the handler passed to Defer, if any. */
+    std::optional<std::pair<HTTPWorkClass, HTTPRequestHandler>> TakeDeferred() { return std::exchange(m_deferred, std::nullopt); }
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -3,8 +3,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <index/base.h>
+#include <index/syncblockreader.h>
 #include <interfaces/chain.h>
 #include <kernel/chain.h>
 #include <logging.h>
@@ -19,6 +22,8 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -27,6 +32,31 @@ constexpr uint8_t DB_BEST_BLOCK{'B'};
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
 
+//! Maximum number of worker threads processing blocks during a parallel sync
+constexpr int MAX_SYNC_WORKERS{15};
+//! Number of blocks per thread that a parallel sync processes before appending them
+constexpr size_t SYNC_BLOCKS_PER_THREAD{16};
+
+struct BaseIndex::ProcessBlockJob {
+    BaseIndex* index;
+    SyncBlockReader* reader;
+    const CBlockIndex* block_index;
+    std::any* entries;
+
+    bool operator()()
+    {
+        // Leave the rest of the batch undone so that shutdown doesn't wait for it.
+        if (index->m_interrupt) return false;
+        const auto block{reader->Read(*block_index)};
+        if (!block) {
+            LogError("%s: Failed to read block %s from disk\n", index->GetName(), block_index->GetBlockHash().ToString());
+            return false;
+        }
+        *entries = index->CustomProcessBlock(kernel::MakeBlockInfo(block_index, block.get()));
+        return entries->has_value();
+    }
+};
+
 template <typename... Args>
 void BaseIndex::FatalErrorf(const char* fmt, const Args&... args)
 {
@@ -145,6 +175,13 @@ void BaseIndex::Sync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        const auto reader{GetSyncBlockReader(*m_chainstate)};
+        // The sync thread takes part in processing blocks as well.
+        std::unique_ptr<CCheckQueue<ProcessBlockJob>> workers;
+        const int worker_count{std::clamp(m_sync_workers.value_or(GetNumCores() - 1), 0, MAX_SYNC_WORKERS)};
+        if (AllowParallelSync()) {
+            workers = std::make_unique<CCheckQueue<ProcessBlockJob>>(/*batch_size=*/1, worker_count, "idxsync");
+        }
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -179,26 +216,65 @@ void BaseIndex::Sync()
                     break;
                 }
             }
-            if (pindex_next->pprev != pindex && !Rewind(pindex, pindex_next->pprev)) {
-                FatalErrorf("%s: Failed to rewind index %s to a previous chain tip", __func__, GetName());
-                return;
+            if (pindex_next->pprev != pindex) {
+                // Rewind from the last block appended, which the best block may lag behind.
+                SetBestBlockIndex(pindex);
+                if (!Rewind(pindex, pindex_next->pprev)) {
+                    FatalErrorf("%s: Failed to rewind index %s to a previous chain tip", __func__, GetName());
+                    return;
+                }
             }
-            pindex = pindex_next;
 
-
-            CBlock block;
-            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
-                FatalErrorf("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+            if (workers) {
+                // The index may have been rewound, and is only advanced once the batch is appended.
+                pindex = pindex_next->pprev;
+                // Process the next blocks of the chain concurrently, then append them in order.
+                std::vector<const CBlockIndex*> batch{pindex_next};
+                {
+                    LOCK(cs_main);
+                    while (batch.size() < SYNC_BLOCKS_PER_THREAD * (worker_count + 1)) {
+                        const CBlockIndex* next{m_chainstate->m_chain.Next(batch.back())};
+                        if (!next) break;
+                        batch.push_back(next);
+                    }
+                }
+                std::vector<std::any> entries(batch.size());
+                std::vector<ProcessBlockJob> jobs;
+                jobs.reserve(batch.size());
+                for (size_t i{0}; i < batch.size(); ++i) jobs.push_back({this, reader.get(), batch[i], &entries[i]});
+                CCheckQueueControl<ProcessBlockJob> control{workers.get()};
+                control.Add(std::move(jobs));
+                if (!control.Wait()) {
+                    if (m_interrupt) continue;
+                    FatalErrorf("%s: Failed to process blocks %s to %s for index",
+                               __func__, batch.front()->GetBlockHash().ToString(), batch.back()->GetBlockHash().ToString());
+                    return;
+                }
+                for (size_t i{0}; i < batch.size(); ++i) {
+                    if (!CustomPostProcessBlock(kernel::MakeBlockInfo(batch[i]), entries[i])) {
+                        FatalErrorf("%s: Failed to write block %s to index database",
+                                   __func__, batch[i]->GetBlockHash().ToString());
+                        return;
+                    }
+                    pindex = batch[i];
+                }
             } else {
-                block_info.data = &block;
-            }
-            if (!CustomAppend(block_info)) {
-                FatalErrorf("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+                pindex = pindex_next;
+
+                const auto block{reader->Read(*pindex)};
+                interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
+                if (!block) {
+                    FatalErrorf("%s: Failed to read block %s from disk",
+                               __func__, pindex->GetBlockHash().ToString());
+                    return;
+                } else {
+                    block_info.data = block.get();
+                }
+                if (!CustomAppend(block_info)) {
+                    FatalErrorf("%s: Failed to write block %s to index database",
+                               __func__, pindex->GetBlockHash().ToString());
+                    return;
+                }
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -10,6 +10,8 @@
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <any>
+#include <optional>
 #include <string>
 
 class CBlock;
@@ -78,6 +80,12 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Number of threads besides the sync thread processing blocks during a parallel sync.
+    std::optional<int> m_sync_workers;
+
+    /// Work item of the threads processing blocks during a parallel sync, see AllowParallelSync.
+    struct ProcessBlockJob;
+
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
     ///
     /// Recommendations for error handling:
@@ -111,6 +119,18 @@ protected:
     /// Write update index entries for a newly connected block.
     [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
 
+    /// Whether the work of CustomAppend is split into CustomProcessBlock, which only depends on
+    /// the block itself, and CustomPostProcessBlock. During the initial sync such an index
+    /// processes many blocks at once on worker threads, and post-processes them in chain order.
+    virtual bool AllowParallelSync() const { return false; }
+
+    /// Compute the index entries for a block without touching the index state. May be called from
+    /// several threads at once. An empty result means failure.
+    [[nodiscard]] virtual std::any CustomProcessBlock(const interfaces::BlockInfo& block) { return {}; }
+
+    /// Write the entries computed by CustomProcessBlock for the next block of the chain.
+    [[nodiscard]] virtual bool CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries) { return false; }
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CustomCommit(CDBBatch& batch) { return true; }
@@ -145,6 +165,10 @@ public:
     /// validation interface so that it stays in sync with blockchain updates.
     [[nodiscard]] bool Init();
 
+    /// Set the number of threads besides the sync thread that process blocks during a parallel
+    /// sync, instead of one less than the number of cores. Must be called before the sync starts.
+    void SetSyncWorkers(int count) { m_sync_workers = count; }
+
     /// Starts the initial sync process on a background thread.
     [[nodiscard]] bool StartBackgroundSync();
 
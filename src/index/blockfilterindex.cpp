@@ -10,6 +10,7 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <logging.h>
+#include <memusage.h>
 #include <node/blockstorage.h>
 #include <undo.h>
 #include <util/fs_helpers.h>
@@ -98,9 +99,11 @@ struct DBHashKey {
 static std::map<BlockFilterType, BlockFilterIndex> g_filter_indexes;
 
 BlockFilterIndex::BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, BlockFilterType filter_type,
-                                   size_t n_cache_size, bool f_memory, bool f_wipe)
+                                   size_t n_cache_size, bool f_memory, bool f_wipe,
+                                   size_t decoded_cache_size)
     : BaseIndex(std::move(chain), BlockFilterTypeName(filter_type) + " block filter index")
     , m_filter_type(filter_type)
+    , m_decoded_cache_max_bytes(decoded_cache_size)
 {
     const std::string& filter_name = BlockFilterTypeName(filter_type);
     if (filter_name.empty()) throw std::invalid_argument("unknown filter_type");
@@ -249,6 +252,12 @@ std::optional<uint256> BlockFilterIndex::ReadFilterHeader(int height, const uint
 }
 
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    const std::any filter{CustomProcessBlock(block)};
+    return filter.has_value() && CustomPostProcessBlock(block, filter);
+}
+
+std::any BlockFilterIndex::CustomProcessBlock(const interfaces::BlockInfo& block)
 {
     CBlockUndo block_undo;
 
@@ -257,11 +266,16 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         // will be removed in upcoming commit
         const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
         if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
+            return {};
         }
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
+    return BlockFilter(m_filter_type, *Assert(block.data), block_undo);
+}
+
+bool BlockFilterIndex::CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries)
+{
+    const BlockFilter& filter{std::any_cast<const BlockFilter&>(entries)};
 
     const uint256& header = filter.ComputeHeader(m_last_header);
     bool res = Write(filter, block.height, header);
@@ -318,6 +332,20 @@ bool BlockFilterIndex::Write(const BlockFilter& filter, uint32_t block_height, c
 
 bool BlockFilterIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
 {
+    {
+        // Drop the decoded filters of the disconnected blocks, which are unlikely to be scanned again.
+        LOCK(m_cs_decoded_cache);
+        for (auto it = m_decoded_cache.begin(); it != m_decoded_cache.end();) {
+            if (it->height > new_tip.height) {
+                m_decoded_cache_bytes -= it->bytes;
+                m_decoded_cache_index.erase(it->block_hash);
+                it = m_decoded_cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     CDBBatch batch(*m_db);
     std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
 
@@ -357,8 +385,7 @@ static bool LookupOne(const CDBWrapper& db, const CBlockIndex* block_index, DBVa
     return db.Read(DBHashKey(block_index->GetBlockHash()), result);
 }
 
-static bool LookupRange(CDBWrapper& db, const std::string& index_name, int start_height,
-                        const CBlockIndex* stop_index, std::vector<DBVal>& results)
+static bool CheckRange(int start_height, const CBlockIndex* stop_index)
 {
     if (start_height < 0) {
         LogError("%s: start height (%d) is negative\n", __func__, start_height);
@@ -369,6 +396,15 @@ static bool LookupRange(CDBWrapper& db, const std::string& index_name, int start
                      __func__, start_height, stop_index->nHeight);
         return false;
     }
+    return true;
+}
+
+static bool LookupRange(CDBWrapper& db, const std::string& index_name, int start_height,
+                        const CBlockIndex* stop_index, std::vector<DBVal>& results)
+{
+    if (!CheckRange(start_height, stop_index)) {
+        return false;
+    }
 
     size_t results_size = static_cast<size_t>(stop_index->nHeight - start_height + 1);
     std::vector<std::pair<uint256, DBVal>> values(results_size);
@@ -476,6 +512,85 @@ bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* st
     return true;
 }
 
+std::shared_ptr<const DecodedGCSFilter> BlockFilterIndex::GetCachedDecodedFilter(const uint256& block_hash)
+{
+    LOCK(m_cs_decoded_cache);
+    const auto it{m_decoded_cache_index.find(block_hash)};
+    if (it == m_decoded_cache_index.end()) return nullptr;
+    m_decoded_cache.splice(m_decoded_cache.begin(), m_decoded_cache, it->second);
+    return it->second->filter;
+}
+
+void BlockFilterIndex::CacheDecodedFilter(const uint256& block_hash, int height, std::shared_ptr<const DecodedGCSFilter> filter)
+{
+    // Besides the decoded values, count the filter object and its shared_ptr control block, the
+    // list node, and the index node with its share of the bucket array.
+    const size_t bytes{filter->DynamicMemoryUsage() + memusage::DynamicUsage(filter) +
+                       memusage::MallocUsage(sizeof(memusage::list_node<DecodedFilterEntry>)) +
+                       memusage::MallocUsage(sizeof(memusage::unordered_node<decltype(m_decoded_cache_index)::value_type>)) +
+                       sizeof(void*)};
+    if (bytes > m_decoded_cache_max_bytes) return;
+
+    LOCK(m_cs_decoded_cache);
+    if (m_decoded_cache_index.count(block_hash)) return;
+    while (m_decoded_cache_bytes + bytes > m_decoded_cache_max_bytes) {
+        const DecodedFilterEntry& evict{m_decoded_cache.back()};
+        m_decoded_cache_bytes -= evict.bytes;
+        m_decoded_cache_index.erase(evict.block_hash);
+        m_decoded_cache.pop_back();
+    }
+    m_decoded_cache_bytes += bytes;
+    m_decoded_cache.push_front(DecodedFilterEntry{block_hash, height, std::move(filter), bytes});
+    m_decoded_cache_index.emplace(block_hash, m_decoded_cache.begin());
+}
+
+bool BlockFilterIndex::LookupDecodedFilterRange(int start_height, const CBlockIndex* stop_index,
+                                                std::vector<std::shared_ptr<const DecodedGCSFilter>>& filters_out)
+{
+    if (!CheckRange(start_height, stop_index)) {
+        return false;
+    }
+
+    const size_t results_size = static_cast<size_t>(stop_index->nHeight - start_height + 1);
+    filters_out.assign(results_size, nullptr);
+    std::vector<uint256> block_hashes(results_size);
+    bool all_cached{true};
+    for (const CBlockIndex* block_index = stop_index;
+         block_index && block_index->nHeight >= start_height;
+         block_index = block_index->pprev) {
+        size_t i = static_cast<size_t>(block_index->nHeight - start_height);
+        block_hashes[i] = block_index->GetBlockHash();
+        filters_out[i] = GetCachedDecodedFilter(block_hashes[i]);
+        all_cached &= filters_out[i] != nullptr;
+    }
+    if (all_cached) return true;
+
+    std::vector<DBVal> entries;
+    if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < results_size; ++i) {
+        if (filters_out[i]) continue;
+
+        BlockFilter filter;
+        if (!ReadFilterFromDisk(entries[i].pos, entries[i].hash, filter)) {
+            return false;
+        }
+        std::shared_ptr<const DecodedGCSFilter> decoded;
+        try {
+            decoded = std::make_shared<const DecodedGCSFilter>(filter.GetFilter());
+        } catch (const std::exception& e) {
+            LogError("%s: Failed to decode block filter for %s: %s\n", __func__, block_hashes[i].ToString(), e.what());
+            return false;
+        }
+        CacheDecodedFilter(block_hashes[i], start_height + static_cast<int>(i), decoded);
+        filters_out[i] = std::move(decoded);
+    }
+
+    return true;
+}
+
 bool BlockFilterIndex::LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
                                              std::vector<uint256>& hashes_out) const
 
@@ -505,12 +620,13 @@ void ForEachBlockFilterIndex(std::function<void (BlockFilterIndex&)> fn)
 }
 
 bool InitBlockFilterIndex(std::function<std::unique_ptr<interfaces::Chain>()> make_chain, BlockFilterType filter_type,
-                          size_t n_cache_size, bool f_memory, bool f_wipe)
+                          size_t n_cache_size, bool f_memory, bool f_wipe, size_t decoded_cache_size)
 {
     auto result = g_filter_indexes.emplace(std::piecewise_construct,
                                            std::forward_as_tuple(filter_type),
                                            std::forward_as_tuple(make_chain(), filter_type,
-                                                                 n_cache_size, f_memory, f_wipe));
+                                                                 n_cache_size, f_memory, f_wipe,
+                                                                 decoded_cache_size));
     return result.second;
 }
 
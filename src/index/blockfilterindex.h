@@ -10,12 +10,18 @@
 #include <chain.h>
 #include <flatfile.h>
 #include <index/base.h>
+#include <sync.h>
 #include <util/hasher.h>
 
+#include <list>
+#include <memory>
 #include <unordered_map>
 
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 
+/** Default for -blockfiltercachesize, in MiB */
+static constexpr int64_t DEFAULT_BLOCKFILTER_CACHE_SIZE{0};
+
 /** Interval between compact filter checkpoints. See BIP 157. */
 static constexpr int CFCHECKPT_INTERVAL = 1000;
 
@@ -45,6 +51,27 @@ private:
     // Last computed header to avoid disk reads on every new block.
     uint256 m_last_header{};
 
+    struct DecodedFilterEntry {
+        uint256 block_hash;
+        int height;
+        std::shared_ptr<const DecodedGCSFilter> filter;
+        //! Memory counted against m_decoded_cache_max_bytes for this entry
+        size_t bytes;
+    };
+
+    Mutex m_cs_decoded_cache;
+    const size_t m_decoded_cache_max_bytes;
+    /**
+     * Least-recently-used cache of decoded filters by block hash, most recently used first, to
+     * serve repeated scans of the same blocks from memory.
+     */
+    std::list<DecodedFilterEntry> m_decoded_cache GUARDED_BY(m_cs_decoded_cache);
+    std::unordered_map<uint256, std::list<DecodedFilterEntry>::iterator, BlockHasher> m_decoded_cache_index GUARDED_BY(m_cs_decoded_cache);
+    size_t m_decoded_cache_bytes GUARDED_BY(m_cs_decoded_cache){0};
+
+    std::shared_ptr<const DecodedGCSFilter> GetCachedDecodedFilter(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_decoded_cache);
+    void CacheDecodedFilter(const uint256& block_hash, int height, std::shared_ptr<const DecodedGCSFilter> filter) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_decoded_cache);
+
     bool AllowPrune() const override { return true; }
 
     bool Write(const BlockFilter& filter, uint32_t block_height, const uint256& filter_header);
@@ -58,14 +85,26 @@ protected:
 
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
-    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+    bool AllowParallelSync() const override { return true; }
+
+    /** Build the filter of a block, reading its undo data from disk. */
+    std::any CustomProcessBlock(const interfaces::BlockInfo& block) override;
+
+    /** Write the filter of the next block and extend the filter header chain. */
+    bool CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override EXCLUSIVE_LOCKS_REQUIRED(!m_cs_decoded_cache);
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
 
 public:
-    /** Constructs the index, which becomes available to be queried. */
+    /**
+     * Constructs the index, which becomes available to be queried. Up to decoded_cache_size bytes
+     * of decoded filters are kept in memory for LookupDecodedFilterRange.
+     */
     explicit BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, BlockFilterType filter_type,
-                              size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+                              size_t n_cache_size, bool f_memory = false, bool f_wipe = false,
+                              size_t decoded_cache_size = 0);
 
     BlockFilterType GetFilterType() const { return m_filter_type; }
 
@@ -79,6 +118,14 @@ public:
     bool LookupFilterRange(int start_height, const CBlockIndex* stop_index,
                            std::vector<BlockFilter>& filters_out) const;
 
+    /**
+     * Get a range of filters between two heights on a chain, decoded for matching. Filters are
+     * served from and added to the decoded filter cache.
+     */
+    bool LookupDecodedFilterRange(int start_height, const CBlockIndex* stop_index,
+                                  std::vector<std::shared_ptr<const DecodedGCSFilter>>& filters_out)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_decoded_cache);
+
     /** Get a range of filter hashes between two heights on a chain. */
     bool LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
                                std::vector<uint256>& hashes_out) const;
@@ -98,7 +145,8 @@ void ForEachBlockFilterIndex(std::function<void (BlockFilterIndex&)> fn);
  * a new index is created and false if one has already been initialized.
  */
 bool InitBlockFilterIndex(std::function<std::unique_ptr<interfaces::Chain>()> make_chain, BlockFilterType filter_type,
-                          size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+                          size_t n_cache_size, bool f_memory = false, bool f_wipe = false,
+                          size_t decoded_cache_size = 0);
 
 /**
  * Destroy the block filter index with the given type. Returns false if no such index exists. This
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/syncblockreader.h>
+
+#include <chain.h>
+#include <core_memusage.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <util/thread.h>
+#include <validation.h>
+
+#include <vector>
+
+SyncBlockReader::SyncBlockReader(Chainstate& chainstate, size_t cache_bytes, size_t read_ahead_blocks)
+    : m_chainstate{chainstate}, m_cache_bytes{cache_bytes}, m_read_ahead_blocks{read_ahead_blocks}
+{
+    if (m_read_ahead_blocks > 0) {
+        m_thread = std::thread(&util::TraceThread, "idxread", [this] { ReadAhead(); });
+    }
+}
+
+SyncBlockReader::~SyncBlockReader()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::shared_ptr<const CBlock> SyncBlockReader::Read(const CBlockIndex& block_index)
+{
+    {
+        LOCK(m_mutex);
+        if (!m_read_ahead_from || block_index.nHeight > m_read_ahead_from->nHeight) {
+            m_read_ahead_from = &block_index;
+            m_cv.notify_all();
+        }
+        if (auto block{Find(block_index)}) return block;
+    }
+    auto block{std::make_shared<CBlock>()};
+    if (!m_chainstate.m_blockman.ReadBlockFromDisk(*block, block_index)) return nullptr;
+    WITH_LOCK(m_mutex, Insert(block_index, block));
+    return block;
+}
+
+bool SyncBlockReader::IsCached(const CBlockIndex& block_index) const
+{
+    return WITH_LOCK(m_mutex, return m_blocks.contains(&block_index));
+}
+
+size_t SyncBlockReader::GetCacheUsage() const
+{
+    return WITH_LOCK(m_mutex, return m_bytes);
+}
+
+std::shared_ptr<const CBlock> SyncBlockReader::Find(const CBlockIndex& block_index)
+{
+    const auto it{m_blocks.find(&block_index)};
+    if (it == m_blocks.end()) return nullptr;
+    m_lru.splice(m_lru.end(), m_lru, it->second.second);
+    return it->second.first;
+}
+
+void SyncBlockReader::Insert(const CBlockIndex& block_index, std::shared_ptr<const CBlock> block)
+{
+    const size_t usage{RecursiveDynamicUsage(*block)};
+    if (!m_blocks.try_emplace(&block_index, std::move(block), m_lru.end()).second) return;
+    m_blocks.at(&block_index).second = m_lru.insert(m_lru.end(), &block_index);
+    m_bytes += usage;
+    while (m_bytes > m_cache_bytes && m_lru.size() > 1) {
+        const auto evict{m_blocks.find(m_lru.front())};
+        m_bytes -= RecursiveDynamicUsage(*evict->second.first);
+        m_blocks.erase(evict);
+        m_lru.pop_front();
+    }
+}
+
+void SyncBlockReader::ReadAhead()
+{
+    while (true) {
+        const CBlockIndex* from;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || m_read_ahead_from != m_read_ahead_done; });
+            if (m_stop) return;
+            from = m_read_ahead_done = m_read_ahead_from;
+        }
+        std::vector<const CBlockIndex*> next;
+        {
+            LOCK(cs_main);
+            for (const CBlockIndex* block_index{m_chainstate.m_chain.Next(from)};
+                 block_index && next.size() < m_read_ahead_blocks;
+                 block_index = m_chainstate.m_chain.Next(block_index)) {
+                next.push_back(block_index);
+            }
+        }
+        for (const CBlockIndex* block_index : next) {
+            {
+                LOCK(m_mutex);
+                // Start over from the new furthest block once the syncs moved on.
+                if (m_stop || m_read_ahead_from != from) break;
+                if (m_blocks.contains(block_index)) continue;
+            }
+            auto block{std::make_shared<CBlock>()};
+            if (!m_chainstate.m_blockman.ReadBlockFromDisk(*block, *block_index)) break;
+            WITH_LOCK(m_mutex, Insert(*block_index, block));
+        }
+    }
+}
+
+static GlobalMutex g_sync_block_reader_mutex;
+static std::weak_ptr<SyncBlockReader> g_sync_block_reader GUARDED_BY(g_sync_block_reader_mutex);
+static size_t g_sync_block_cache_bytes GUARDED_BY(g_sync_block_reader_mutex){MAX_SYNC_BLOCK_CACHE << 20};
+
+std::shared_ptr<SyncBlockReader> GetSyncBlockReader(Chainstate& chainstate)
+{
+    LOCK(g_sync_block_reader_mutex);
+    auto reader{g_sync_block_reader.lock()};
+    if (!reader || &reader->GetChainstate() != &chainstate) {
+        reader = std::make_shared<SyncBlockReader>(chainstate, g_sync_block_cache_bytes);
+        g_sync_block_reader = reader;
+    }
+    return reader;
+}
+
+void SetSyncBlockCacheSize(size_t cache_bytes)
+{
+    LOCK(g_sync_block_reader_mutex);
+    g_sync_block_cache_bytes = cache_bytes;
+}
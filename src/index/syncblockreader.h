@@ -0,0 +1,82 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SYNCBLOCKREADER_H
+#define BITCOIN_INDEX_SYNCBLOCKREADER_H
+
+#include <sync.h>
+#include <threadsafety.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+class CBlock;
+class CBlockIndex;
+class Chainstate;
+
+//! Maximum memory for the blocks read by syncing indexes, in MiB. Taken from -dbcache.
+static constexpr int64_t MAX_SYNC_BLOCK_CACHE{128};
+//! Number of blocks read ahead of the furthest block a syncing index asked for
+static constexpr size_t SYNC_READ_AHEAD_BLOCKS{16};
+
+/**
+ * Reads the blocks for the initial sync of the indexes. Blocks are kept in memory after being
+ * read, up to a number of bytes, so that indexes syncing at the same time share one pass over
+ * the block files. A background thread reads ahead of the furthest block asked for.
+ */
+class SyncBlockReader
+{
+public:
+    SyncBlockReader(Chainstate& chainstate, size_t cache_bytes, size_t read_ahead_blocks = SYNC_READ_AHEAD_BLOCKS);
+    ~SyncBlockReader();
+
+    const Chainstate& GetChainstate() const { return m_chainstate; }
+
+    /** Get a block, from memory if possible. Returns nullptr if it cannot be read from disk. */
+    std::shared_ptr<const CBlock> Read(const CBlockIndex& block_index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Whether a block is in memory. Does not count as a use of the block. */
+    bool IsCached(const CBlockIndex& block_index) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Memory used by the blocks in memory. */
+    size_t GetCacheUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    Chainstate& m_chainstate;
+    const size_t m_cache_bytes;
+    const size_t m_read_ahead_blocks;
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Blocks in memory, each with its position in m_lru
+    std::unordered_map<const CBlockIndex*, std::pair<std::shared_ptr<const CBlock>, std::list<const CBlockIndex*>::iterator>> m_blocks GUARDED_BY(m_mutex);
+    //! The blocks in m_blocks, least recently used first
+    std::list<const CBlockIndex*> m_lru GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+    //! The furthest block asked for, and the one reading ahead last started from
+    const CBlockIndex* m_read_ahead_from GUARDED_BY(m_mutex){nullptr};
+    const CBlockIndex* m_read_ahead_done GUARDED_BY(m_mutex){nullptr};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    std::shared_ptr<const CBlock> Find(const CBlockIndex& block_index) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Insert(const CBlockIndex& block_index, std::shared_ptr<const CBlock> block) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void ReadAhead() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/**
+ * Get the block reader shared by all indexes syncing with the same chainstate. It is created on
+ * first use and destroyed once no index uses it anymore.
+ */
+std::shared_ptr<SyncBlockReader> GetSyncBlockReader(Chainstate& chainstate);
+
+/** Set the memory for the blocks of the block readers created from now on. */
+void SetSyncBlockCacheSize(size_t cache_bytes);
+
+#endif // BITCOIN_INDEX_SYNCBLOCKREADER_H
@@ -56,17 +56,29 @@ TxIndex::~TxIndex() = default;
 
 bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
+    return CustomPostProcessBlock(block, CustomProcessBlock(block));
+}
+
+std::any TxIndex::CustomProcessBlock(const interfaces::BlockInfo& block)
+{
+    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
     // Exclude genesis block transaction because outputs are not spendable.
-    if (block.height == 0) return true;
+    if (block.height == 0) return vPos;
 
     assert(block.data);
     CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
     vPos.reserve(block.data->vtx.size());
     for (const auto& tx : block.data->vtx) {
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
     }
+    return vPos;
+}
+
+bool TxIndex::CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries)
+{
+    const auto& vPos{std::any_cast<const std::vector<std::pair<uint256, CDiskTxPos>>&>(entries)};
+    if (vPos.empty()) return true;
     return m_db->WriteTxs(vPos);
 }
 
@@ -27,6 +27,13 @@ private:
 protected:
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool AllowParallelSync() const override { return true; }
+
+    /// Compute the disk positions of the transactions in a block.
+    std::any CustomProcessBlock(const interfaces::BlockInfo& block) override;
+
+    bool CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries) override;
+
     BaseIndex::DB& GetDB() const override;
 
 public:
@@ -14,6 +14,8 @@ class CChainParams;
 
 namespace kernel {
 
+static constexpr bool DEFAULT_BLOCK_MMAP{false};
+
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
  * `BlockManager::Options` due to the using-declaration in `BlockManager`.
@@ -22,6 +24,8 @@ struct BlockManagerOpts {
     const CChainParams& chainparams;
     uint64_t prune_target{0};
     bool fast_prune{false};
+    //! Serve blocks from memory mappings of the block files instead of copying them out
+    bool use_mmap{DEFAULT_BLOCK_MMAP};
     const fs::path blocks_dir;
     Notifications& notifications;
 };
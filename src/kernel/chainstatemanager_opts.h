@@ -48,6 +48,12 @@ struct ChainstateManagerOpts {
     ValidationSignals* signals{nullptr};
     //! Number of script check worker threads. Zero means no parallel verification.
     int worker_threads_num{0};
+    //! Number of threads reading block inputs from the coins database ahead of ConnectBlock. Zero means no prefetching.
+    int prefetch_threads_num{0};
+    //! Number of blocks read and checked in the background ahead of the one being connected. Zero means no lookahead.
+    int block_lookahead{0};
+    //! Number of consecutive blocks whose script checks may run concurrently. One means a barrier after every block.
+    int script_check_window{1};
 };
 
 } // namespace kernel
@@ -4,6 +4,8 @@
 
 #include <kernel/context.h>
 
+#include <crypto/chacha20.h>
+#include <crypto/poly1305.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <logging.h>
@@ -18,6 +20,10 @@ Context::Context()
 {
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string chacha20_algo = ChaCha20AutoDetect();
+    LogPrintf("Using the '%s' ChaCha20 implementation\n", chacha20_algo);
+    std::string poly1305_algo = Poly1305AutoDetect();
+    LogPrintf("Using the '%s' Poly1305 implementation\n", poly1305_algo);
     RandomInit();
     ECC_Start();
 }
@@ -10,10 +10,12 @@
 #include <core_memusage.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <util/epochguard.h>
 #include <util/overflow.h>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -50,6 +52,58 @@ struct CompareIteratorByHash {
     }
 };
 
+/**
+ * Set of references to mempool entries, ordered by txid like a
+ * std::set<std::reference_wrapper<const Entry>, CompareIteratorByHash>.
+ *
+ * Most mempool transactions have no more than one in-mempool parent or
+ * child, so a single reference is stored inline, and larger sets in one
+ * sorted array rather than a tree node per element.
+ */
+template <typename Entry>
+class EntryRefSet
+{
+public:
+    using value_type = std::reference_wrapper<const Entry>;
+
+private:
+    prevector<1, value_type> m_refs;
+
+    auto LowerBound(const value_type& ref) const { return std::lower_bound(m_refs.begin(), m_refs.end(), ref, CompareIteratorByHash{}); }
+
+public:
+    using const_iterator = typename prevector<1, value_type>::const_iterator;
+
+    const_iterator begin() const { return m_refs.begin(); }
+    const_iterator end() const { return m_refs.end(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    size_t size() const { return m_refs.size(); }
+    bool empty() const { return m_refs.empty(); }
+
+    /** Add ref unless an entry with the same txid is present. Returns whether it was added. */
+    bool insert(const value_type& ref)
+    {
+        const auto it{LowerBound(ref)};
+        if (it != end() && !CompareIteratorByHash{}(ref, *it)) return false;
+        m_refs.insert(m_refs.begin() + (it - begin()), ref);
+        return true;
+    }
+
+    /** Remove the entry with ref's txid. Returns the number of entries removed. */
+    size_t erase(const value_type& ref)
+    {
+        const auto it{LowerBound(ref)};
+        if (it == end() || CompareIteratorByHash{}(ref, *it)) return 0;
+        m_refs.erase(m_refs.begin() + (it - begin()));
+        // Go back to inline storage, prevector keeps its heap buffer otherwise.
+        if (m_refs.size() <= 1) m_refs.shrink_to_fit();
+        return 1;
+    }
+
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_refs); }
+};
+
 /** \class CTxMemPoolEntry
  *
  * CTxMemPoolEntry stores data about the corresponding transaction, as well
@@ -67,8 +121,8 @@ class CTxMemPoolEntry
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
     // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    typedef EntryRefSet<CTxMemPoolEntry> Parents;
+    typedef EntryRefSet<CTxMemPoolEntry> Children;
 
 private:
     CTxMemPoolEntry(const CTxMemPoolEntry&) = default;
@@ -185,6 +239,8 @@ public:
     Children& GetMemPoolChildren() const { return m_children; }
 
     mutable size_t idx_randomized; //!< Index in mempool's txns_randomized
+    mutable uint64_t m_cluster_id{0}; //!< Id of the mempool cluster (connected component) containing this entry
+    mutable size_t m_cluster_pos{0}; //!< Index in that cluster's linearization
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
 };
 
@@ -24,6 +24,10 @@ struct MemPoolLimits {
     int64_t descendant_count{DEFAULT_DESCENDANT_LIMIT};
     //! The maximum allowed size in virtual bytes of an entry and its descendants within a package.
     int64_t descendant_size_vbytes{DEFAULT_DESCENDANT_SIZE_LIMIT_KVB * 1'000};
+    //! The maximum allowed number of transactions in a cluster including the entry.
+    int64_t cluster_count{DEFAULT_CLUSTER_LIMIT};
+    //! The maximum allowed size in virtual bytes of the transactions in a cluster including the entry.
+    int64_t cluster_size_vbytes{DEFAULT_CLUSTER_SIZE_LIMIT_KVB * 1'000};
 
     /**
      * @return MemPoolLimits with all the limits set to the maximum
@@ -31,7 +35,7 @@ struct MemPoolLimits {
     static constexpr MemPoolLimits NoLimits()
     {
         int64_t no_limit{std::numeric_limits<int64_t>::max()};
-        return {no_limit, no_limit, no_limit, no_limit};
+        return {no_limit, no_limit, no_limit, no_limit, no_limit, no_limit};
     }
 };
 } // namespace kernel
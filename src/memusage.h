@@ -8,6 +8,7 @@
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
+#include <util/densehashmap.h>
 
 #include <cassert>
 #include <cstdlib>
@@ -202,6 +203,14 @@ static inline size_t DynamicUsage(const std::unordered_map<Key,
     return usage_resource + usage_chunks + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template <class Key, class T, class Hash, class Pred>
+static inline size_t DynamicUsage(const DenseHashMap<Key, T, Hash, Pred>& m)
+{
+    size_t usage{0};
+    m.ForEachAllocation([&](size_t bytes) { usage += MallocUsage(bytes); });
+    return usage;
+}
+
 } // namespace memusage
 
 #endif // BITCOIN_MEMUSAGE_H
@@ -814,12 +814,23 @@ CNetMessage V1Transport::GetReceivedMessage(const std::chrono::microseconds time
     return msg;
 }
 
+namespace {
+
+/** Message type of bytes that are not sent on behalf of any message. */
+const std::string NO_MESSAGE_TYPE;
+
+} // namespace
+
 bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     // Determine whether a new message can be set.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    const size_t size{CMessageHeader::HEADER_SIZE + msg.data.size()};
+    if (!m_messages_to_send.empty() &&
+        (m_messages_to_send.size() >= MAX_SEND_BATCH_MESSAGES || m_messages_to_send_size + size > MAX_SEND_BATCH_BYTES)) {
+        return false;
+    }
 
     // create dbl-sha256 checksum
     uint256 hash = Hash(msg.data);
@@ -829,13 +840,17 @@ bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
-    m_header_to_send.clear();
-    VectorWriter{m_header_to_send, 0, hdr};
+    std::vector<uint8_t> header;
+    header.reserve(CMessageHeader::HEADER_SIZE);
+    VectorWriter{header, 0, hdr};
 
     // update state
-    m_message_to_send = std::move(msg);
-    m_sending_header = true;
-    m_bytes_sent = 0;
+    if (m_messages_to_send.empty()) {
+        m_sending_header = true;
+        m_bytes_sent = 0;
+    }
+    m_messages_to_send.push_back({std::move(header), std::move(msg)});
+    m_messages_to_send_size += size;
     return true;
 }
 
@@ -843,36 +858,76 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
+    if (m_messages_to_send.empty()) return {{}, have_next_message, NO_MESSAGE_TYPE};
+    const auto& [header, msg] = m_messages_to_send.front();
+    // We have more to send after this part if another message is queued behind it, or if there
+    // is a next message after that.
+    const bool more{have_next_message || m_messages_to_send.size() > 1};
     if (m_sending_header) {
-        return {Span{m_header_to_send}.subspan(m_bytes_sent),
-                // We have more to send after the header if the message has payload, or if there
-                // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
-                m_message_to_send.m_type
+        return {Span{header}.subspan(m_bytes_sent),
+                // We also have more to send after the header if the message has payload.
+                more || !msg.data.empty(),
+                msg.m_type
                };
     } else {
-        return {Span{m_message_to_send.data}.subspan(m_bytes_sent),
-                // We only have more to send after this message's payload if there is another
-                // message.
-                have_next_message,
-                m_message_to_send.m_type
-               };
+        return {Span{msg.data}.subspan(m_bytes_sent), more, msg.m_type};
     }
 }
 
-void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
+bool V1Transport::GetSendBuffers(bool have_next_message, std::vector<SendBuffer>& buffers) const noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
-    m_bytes_sent += bytes_sent;
-    if (m_sending_header && m_bytes_sent == m_header_to_send.size()) {
-        // We're done sending a message's header. Switch to sending its data bytes.
+    buffers.clear();
+    // The header and data of every message are sent from where they are, without copying them
+    // into one buffer.
+    for (size_t i{0}; i < m_messages_to_send.size(); ++i) {
+        const auto& [header, msg] = m_messages_to_send[i];
+        Span<const uint8_t> header_to_send{header};
+        Span<const uint8_t> data_to_send{msg.data};
+        if (i == 0) {
+            if (m_sending_header) {
+                header_to_send = header_to_send.subspan(m_bytes_sent);
+            } else {
+                header_to_send = {};
+                data_to_send = data_to_send.subspan(m_bytes_sent);
+            }
+        }
+        if (!header_to_send.empty()) buffers.push_back({header_to_send, msg.m_type});
+        if (!data_to_send.empty()) buffers.push_back({data_to_send, msg.m_type});
+    }
+    return have_next_message;
+}
+
+void V1Transport::NextPartToSend() noexcept
+{
+    AssertLockHeld(m_send_mutex);
+    m_bytes_sent = 0;
+    if (m_sending_header) {
+        // We're done sending a message's header. Switch to sending its data bytes, unless it has
+        // none.
         m_sending_header = false;
-        m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
-        // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
-        ClearShrink(m_message_to_send.data);
-        m_bytes_sent = 0;
+        if (!m_messages_to_send.front().msg.data.empty()) return;
+    }
+    // We're done sending a message's data. Drop it to reduce memory consumption, and switch to
+    // sending the header of the next one.
+    const auto& msg{m_messages_to_send.front().msg};
+    m_messages_to_send_size -= CMessageHeader::HEADER_SIZE + msg.data.size();
+    m_messages_to_send.pop_front();
+    m_sending_header = !m_messages_to_send.empty();
+}
+
+void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    while (bytes_sent > 0 && Assume(!m_messages_to_send.empty())) {
+        const auto& [header, msg] = m_messages_to_send.front();
+        const size_t part_size{m_sending_header ? header.size() : msg.data.size()};
+        const size_t sent{std::min(bytes_sent, part_size - m_bytes_sent)};
+        m_bytes_sent += sent;
+        bytes_sent -= sent;
+        if (m_bytes_sent == part_size) NextPartToSend();
     }
 }
 
@@ -880,8 +935,10 @@ size_t V1Transport::GetSendMemoryUsage() const noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
-    // Don't count sending-side fields besides m_message_to_send, as they're all small and bounded.
-    return m_message_to_send.GetMemoryUsage();
+    // Don't count the headers, as they're all small and bounded.
+    size_t usage{0};
+    for (const auto& [_header, msg] : m_messages_to_send) usage += msg.GetMemoryUsage();
+    return usage;
 }
 
 namespace {
@@ -1460,27 +1517,41 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     LOCK(m_send_mutex);
     if (m_send_state == SendState::V1) return m_v1_fallback.SetMessageToSend(msg);
     // We only allow adding a new message to be sent when in the READY state (so the packet cipher
-    // is available) and the send buffer is empty. This limits the number of messages in the send
-    // buffer to just one, and leaves the responsibility for queueing them up to the caller.
-    if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
-    // Construct contents (encoding message type + payload).
-    std::vector<uint8_t> contents;
+    // is available) and all handshake bytes have been sent, so that the send buffer only holds
+    // packets. Messages beyond the batch limits are left for the caller to queue up.
+    if (m_send_state != SendState::READY) return false;
+    if (!m_send_buffer.empty() && m_send_packets.empty()) return false;
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
+    const size_t contents_size{(short_message_id ? 1 : 1 + CMessageHeader::COMMAND_SIZE) + msg.data.size()};
+    const size_t packet_size{contents_size + BIP324Cipher::EXPANSION};
+    if (!m_send_packets.empty() &&
+        (m_send_packets.size() >= MAX_SEND_BATCH_MESSAGES || m_send_buffer.size() - m_send_pos + packet_size > MAX_SEND_BATCH_BYTES)) {
+        return false;
+    }
+    // Drop the bytes that have been sent already, so that they don't take up space.
+    if (m_send_pos > 0) {
+        m_send_buffer.erase(m_send_buffer.begin(), m_send_buffer.begin() + m_send_pos);
+        for (auto& [end, _type] : m_send_packets) end -= m_send_pos;
+        m_send_pos = 0;
+    }
+    // Construct contents (encoding message type + payload) at the end of the send buffer, where
+    // their ciphertext goes, so that they can be encrypted in place. The send buffer is
+    // initialized with zeroes, so contents[0] and the unused positions in contents[1..13] remain
+    // 0x00 for a message type string.
+    const size_t packet_start{m_send_buffer.size()};
+    const size_t contents_start{packet_start + BIP324Cipher::LENGTH_LEN + BIP324Cipher::HEADER_LEN};
+    m_send_buffer.resize(packet_start + packet_size);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
-        contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        m_send_buffer[contents_start] = *short_message_id;
+        std::copy(msg.data.begin(), msg.data.end(), m_send_buffer.begin() + contents_start + 1);
     } else {
-        // Initialize with zeroes, and then write the message type string starting at offset 1.
-        // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::COMMAND_SIZE + msg.data.size(), 0);
-        std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::COMMAND_SIZE);
-    }
-    // Construct ciphertext in send buffer.
-    m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
-    m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(m_send_buffer));
-    m_send_type = msg.m_type;
+        std::copy(msg.m_type.begin(), msg.m_type.end(), m_send_buffer.begin() + contents_start + 1);
+        std::copy(msg.data.begin(), msg.data.end(), m_send_buffer.begin() + contents_start + 1 + CMessageHeader::COMMAND_SIZE);
+    }
+    const auto packet{MakeWritableByteSpan(m_send_buffer).subspan(packet_start)};
+    const auto contents{MakeByteSpan(m_send_buffer).subspan(contents_start, contents_size)};
+    m_cipher.Encrypt(contents, {}, false, packet);
+    m_send_packets.emplace_back(m_send_buffer.size(), msg.m_type);
     // Release memory
     ClearShrink(msg.data);
     return true;
@@ -1494,15 +1565,40 @@ Transport::BytesToSend V2Transport::GetBytesToSend(bool have_next_message) const
 
     if (m_send_state == SendState::MAYBE_V1) Assume(m_send_buffer.empty());
     Assume(m_send_pos <= m_send_buffer.size());
+    if (m_send_packets.empty()) {
+        return {
+            Span{m_send_buffer}.subspan(m_send_pos),
+            // We only have more to send after the current m_send_buffer if there is a (next)
+            // message to be sent, and we're capable of sending packets. */
+            have_next_message && m_send_state == SendState::READY,
+            NO_MESSAGE_TYPE
+        };
+    }
+    // Return one packet at a time, so that bytes are accounted to the right message type.
+    const auto& [end, msg_type] = m_send_packets.front();
     return {
-        Span{m_send_buffer}.subspan(m_send_pos),
-        // We only have more to send after the current m_send_buffer if there is a (next)
-        // message to be sent, and we're capable of sending packets. */
-        have_next_message && m_send_state == SendState::READY,
-        m_send_type
+        Span{m_send_buffer}.first(end).subspan(m_send_pos),
+        have_next_message || m_send_packets.size() > 1,
+        msg_type
     };
 }
 
+bool V2Transport::GetSendBuffers(bool have_next_message, std::vector<SendBuffer>& buffers) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    if (m_send_state == SendState::V1) return m_v1_fallback.GetSendBuffers(have_next_message, buffers);
+
+    buffers.clear();
+    uint32_t pos{m_send_pos};
+    for (const auto& [end, msg_type] : m_send_packets) {
+        buffers.push_back({Span{m_send_buffer}.first(end).subspan(pos), msg_type});
+        pos = end;
+    }
+    if (pos < m_send_buffer.size()) buffers.push_back({Span{m_send_buffer}.subspan(pos), NO_MESSAGE_TYPE});
+    return have_next_message && m_send_state == SendState::READY;
+}
+
 void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -1518,10 +1614,18 @@ void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
     if (m_send_pos >= CMessageHeader::HEADER_SIZE) {
         m_sent_v1_header_worth = true;
     }
-    // Wipe the buffer when everything is sent.
+    while (!m_send_packets.empty() && m_send_packets.front().first <= m_send_pos) {
+        m_send_packets.pop_front();
+    }
+    // Empty the buffer when everything is sent, but keep its memory for the next packets unless
+    // a large message made it grow.
     if (m_send_pos == m_send_buffer.size()) {
         m_send_pos = 0;
-        ClearShrink(m_send_buffer);
+        if (m_send_buffer.capacity() > MAX_SEND_BATCH_BYTES) {
+            ClearShrink(m_send_buffer);
+        } else {
+            m_send_buffer.clear();
+        }
     }
 }
 
@@ -1578,28 +1682,37 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
     size_t nSentSize = 0;
     bool data_left{false}; //!< second return value (whether unsent data remains)
     std::optional<bool> expected_more;
+    std::array<Span<const uint8_t>, 2 * Transport::MAX_SEND_BATCH_MESSAGES> data;
+    static_assert(data.size() <= Sock::SEND_MANY_MAX_BUFFERS);
 
     while (true) {
-        if (it != node.vSendMsg.end()) {
-            // If possible, move one message from the send queue to the transport. This fails when
-            // there is an existing message still being sent, or (for v2 transports) when the
-            // handshake has not yet completed.
+        // Move as many messages from the send queue to the transport as possible, so that they
+        // are sent with a single write. This stops when the transport has as many messages as it
+        // batches, or (for v2 transports) when the handshake has not yet completed.
+        while (it != node.vSendMsg.end()) {
             size_t memusage = it->GetMemoryUsage();
-            if (node.m_transport->SetMessageToSend(*it)) {
-                // Update memory usage of send buffer (as *it will be deleted).
-                node.m_send_memusage -= memusage;
-                ++it;
-            }
+            if (!node.m_transport->SetMessageToSend(*it)) break;
+            // Update memory usage of send buffer (as *it will be deleted).
+            node.m_send_memusage -= memusage;
+            ++it;
         }
-        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(it != node.vSendMsg.end());
-        // We rely on the 'more' value returned by GetBytesToSend to correctly predict whether more
+        bool more{node.m_transport->GetSendBuffers(it != node.vSendMsg.end(), node.m_send_buffers)};
+        // A transport doesn't return more buffers than two per message it batches.
+        const size_t num_buffers{std::min(node.m_send_buffers.size(), data.size())};
+        if (!Assume(num_buffers == node.m_send_buffers.size())) more = true;
+        size_t data_size{0};
+        for (size_t i{0}; i < num_buffers; ++i) {
+            data[i] = node.m_send_buffers[i].data;
+            data_size += data[i].size();
+        }
+        // We rely on the 'more' value returned by GetSendBuffers to correctly predict whether more
         // bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
         // verify that the previously returned 'more' was correct.
-        if (expected_more.has_value()) Assume(!data.empty() == *expected_more);
+        if (expected_more.has_value()) Assume((data_size > 0) == *expected_more);
         expected_more = more;
-        data_left = !data.empty(); // will be overwritten on next loop if all of data gets sent
-        int nBytes = 0;
-        if (!data.empty()) {
+        data_left = data_size > 0; // will be overwritten on next loop if all of data gets sent
+        ssize_t nBytes = 0;
+        if (data_size > 0) {
             LOCK(node.m_sock_mutex);
             // There is no socket in case we've already disconnected, or in test cases without
             // real connections. In these cases, we bail out immediately and just leave things
@@ -1613,20 +1726,26 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 flags |= MSG_MORE;
             }
 #endif
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()), data.size(), flags);
+            nBytes = node.m_sock->SendMany(Span{data}.first(num_buffers), flags);
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
             node.nSendBytes += nBytes;
+            // Update statistics per message type, before the transport drops the sent bytes.
+            size_t accounted{0};
+            for (size_t i{0}; i < num_buffers && accounted < (size_t)nBytes; ++i) {
+                const auto& [buffer, msg_type] = node.m_send_buffers[i];
+                const size_t sent{std::min(buffer.size(), nBytes - accounted)};
+                if (!msg_type.empty()) { // don't report v2 handshake bytes for now
+                    node.AccountForSentBytes(msg_type, sent);
+                }
+                accounted += sent;
+            }
             // Notify transport that bytes have been processed.
             node.m_transport->MarkBytesSent(nBytes);
-            // Update statistics per message type.
-            if (!msg_type.empty()) { // don't report v2 handshake bytes for now
-                node.AccountForSentBytes(msg_type, nBytes);
-            }
             nSentSize += nBytes;
-            if ((size_t)nBytes != data.size()) {
-                // could not send full message; stop sending more
+            if ((size_t)nBytes != data_size) {
+                // could not send all data; stop sending more
                 break;
             }
         } else {
@@ -1702,7 +1821,7 @@ bool CConnman::AttemptToEvictConnection()
     return false;
 }
 
-void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
+bool CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     struct sockaddr_storage sockaddr;
     socklen_t len = sizeof(sockaddr);
     auto sock = hListenSocket.sock->Accept((struct sockaddr*)&sockaddr, &len);
@@ -1713,7 +1832,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         if (nErr != WSAEWOULDBLOCK) {
             LogPrintf("socket error accept failed: %s\n", NetworkErrorString(nErr));
         }
-        return;
+        return false;
     }
 
     if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr)) {
@@ -1728,6 +1847,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     hListenSocket.AddSocketPermissionFlags(permission_flags);
 
     CreateNodeFromAcceptedSocket(std::move(sock), permission_flags, addr_bind, addr);
+    return true;
 }
 
 void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
@@ -1820,6 +1940,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
     {
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
+        AddNodeToSocketShard(*pnode);
     }
 
     // We received a new connection, harvest entropy from the time (and our peer count)
@@ -1910,6 +2031,9 @@ void CConnman::DisconnectNodes()
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
 
+                // stop waiting for events on the socket, which releases its last reference
+                RemoveNodeFromSocketShard(*pnode);
+
                 // close socket and cleanup
                 pnode->CloseSocketDisconnect();
 
@@ -1994,96 +2118,185 @@ bool CConnman::InactivityCheck(const CNode& node) const
     return false;
 }
 
-Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
+void CConnman::CheckInactiveNodes()
 {
-    Sock::EventsPerSock events_per_sock;
+    const auto now{SteadyClock::now()};
+    if (now < m_sock_next_inactivity_check) return;
+    m_sock_next_inactivity_check = now + 1s;
 
-    for (const ListenSocket& hListenSocket : vhListenSocket) {
-        events_per_sock.emplace(hListenSocket.sock, Sock::Events{Sock::RECV});
+    LOCK(m_nodes_mutex);
+    for (CNode* pnode : m_nodes) {
+        if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
     }
+}
 
-    for (CNode* pnode : nodes) {
-        bool select_recv = !pnode->fPauseRecv;
-        bool select_send;
-        {
-            LOCK(pnode->cs_vSend);
-            // Sending is possible if either there are bytes to send right now, or if there will be
-            // once a potential message from vSendMsg is handed to the transport. GetBytesToSend
-            // determines both of these in a single call.
-            const auto& [to_send, more, _msg_type] = pnode->m_transport->GetBytesToSend(!pnode->vSendMsg.empty());
-            select_send = !to_send.empty() || more;
+/** The key of a listening socket in the events of the first socket handler shard, which doesn't collide with node ids. */
+static SockEvents::Key ListenSockKey(size_t index)
+{
+    return std::numeric_limits<SockEvents::Key>::max() - index;
+}
+
+void CConnman::AddNodeToSocketShard(CNode& node)
+{
+    node.m_sock_shard = static_cast<size_t>(node.GetId()) % m_sock_shards.size();
+    SocketHandlerShard& shard{*m_sock_shards[node.m_sock_shard]};
+    node.AddRef();
+    LOCK(shard.m_mutex);
+    shard.m_to_register.push_back(&node);
+}
+
+void CConnman::RemoveNodeFromSocketShard(const CNode& node)
+{
+    SocketHandlerShard& shard{*m_sock_shards[node.m_sock_shard]};
+    LOCK(shard.m_mutex);
+    shard.m_to_unregister.push_back(node.GetId());
+}
+
+void CConnman::ClearSocketShards()
+{
+    for (const auto& shard : m_sock_shards) {
+        UpdateShardSockets(*shard);
+        for (const auto& [id, pnode] : shard->m_nodes) {
+            shard->m_events.Remove(id);
+            pnode->m_sock_pending = false;
+            pnode->Release();
         }
-        if (!select_recv && !select_send) continue;
+        shard->m_nodes.clear();
+        shard->m_pending_nodes.clear();
+        shard->m_busy = false;
+    }
+}
 
-        LOCK(pnode->m_sock_mutex);
-        if (pnode->m_sock) {
-            Sock::Event event = (select_send ? Sock::SEND : 0) | (select_recv ? Sock::RECV : 0);
-            events_per_sock.emplace(pnode->m_sock, Sock::Events{event});
+void CConnman::UpdateShardSockets(SocketHandlerShard& shard)
+{
+    std::vector<CNode*> to_register;
+    std::vector<NodeId> to_unregister;
+    std::vector<NodeId> to_send;
+    {
+        LOCK(shard.m_mutex);
+        to_register.swap(shard.m_to_register);
+        to_unregister.swap(shard.m_to_unregister);
+        to_send.swap(shard.m_to_send);
+    }
+
+    // Register first, as a node can be removed before its shard got to register it.
+    for (CNode* pnode : to_register) {
+        std::shared_ptr<const Sock> sock{WITH_LOCK(pnode->m_sock_mutex, return pnode->m_sock)};
+        if (!sock) {
+            pnode->Release();
+            continue;
+        }
+        shard.m_events.Add(pnode->GetId(), std::move(sock));
+        shard.m_nodes.emplace(pnode->GetId(), pnode);
+    }
+
+    // The socket may not be reported as writable again, if it was reported before and nothing was
+    // left to send then. Visiting the node sends the rest, or waits until it is writable.
+    for (const NodeId id : to_send) {
+        const auto it{shard.m_nodes.find(id)};
+        if (it != shard.m_nodes.end()) QueuePendingNode(shard, *it->second);
+    }
+
+    for (const NodeId id : to_unregister) {
+        const auto it{shard.m_nodes.find(id)};
+        if (it == shard.m_nodes.end()) continue;
+        CNode* pnode{it->second};
+        // Stop waiting for events on the socket, which releases its last reference
+        shard.m_events.Remove(id);
+        shard.m_nodes.erase(it);
+        if (pnode->m_sock_pending) {
+            shard.m_pending_nodes.erase(std::remove(shard.m_pending_nodes.begin(), shard.m_pending_nodes.end(), pnode), shard.m_pending_nodes.end());
+            pnode->m_sock_pending = false;
         }
+        pnode->Release();
     }
+}
 
-    return events_per_sock;
+void CConnman::QueuePendingNode(SocketHandlerShard& shard, CNode& node)
+{
+    if (node.m_sock_pending) return;
+    node.m_sock_pending = true;
+    shard.m_pending_nodes.push_back(&node);
 }
 
-void CConnman::SocketHandler()
+void CConnman::SocketHandler(SocketHandlerShard& shard)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
-    Sock::EventsPerSock events_per_sock;
+    UpdateShardSockets(shard);
 
-    {
-        const NodesSnapshot snap{*this, /*shuffle=*/false};
+    const bool listening{&shard == m_sock_shards.front().get()};
+    if (listening) {
+        for (size_t i{m_sock_listen_ready.size()}; i < vhListenSocket.size(); ++i) {
+            shard.m_events.Add(ListenSockKey(i), vhListenSocket[i].sock);
+            m_sock_listen_ready.push_back(false);
+        }
+    }
 
-        const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
+    // Only block waiting for new events if all sockets that were reported as ready before have
+    // been served until they would block.
+    const bool busy{shard.m_busy || (listening && std::find(m_sock_listen_ready.begin(), m_sock_listen_ready.end(), true) != m_sock_listen_ready.end())};
+    const auto timeout = busy ? std::chrono::milliseconds{0} : std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
 
-        // Check for the readiness of the already connected sockets and the
-        // listening sockets in one call ("readiness" as in poll(2) or
-        // select(2)). If none are ready, wait for a short while and return
-        // empty sets.
-        events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
-            interruptNet.sleep_for(timeout);
-        }
+    std::vector<SockEvents::Ready> ready;
+    if (!shard.m_events.Wait(timeout, ready) && !busy) {
+        interruptNet.sleep_for(timeout);
+    }
 
-        // Service (send/receive) each of the already connected nodes.
-        SocketHandlerConnected(snap.Nodes(), events_per_sock);
+    for (const auto& [key, occurred] : ready) {
+        const SockEvents::Key listen_index{ListenSockKey(0) - key};
+        if (listening && listen_index < m_sock_listen_ready.size()) {
+            if (occurred & (Sock::RECV | Sock::ERR)) m_sock_listen_ready[listen_index] = true;
+            continue;
+        }
+        const auto it{shard.m_nodes.find(key)};
+        if (it == shard.m_nodes.end()) continue;
+        CNode& node{*it->second};
+        if (occurred & Sock::RECV) node.m_sock_readable = true;
+        if (occurred & Sock::SEND) node.m_sock_writable = true;
+        if (occurred & Sock::ERR) node.m_sock_error = true;
+        QueuePendingNode(shard, node);
     }
 
+    // Service (send/receive) each of the connected nodes that are ready.
+    std::vector<CNode*> nodes;
+    nodes.swap(shard.m_pending_nodes);
+    shard.m_busy = SocketHandlerConnected(shard, nodes);
+
     // Accept new connections from listening sockets.
-    SocketHandlerListening(events_per_sock);
+    if (listening) SocketHandlerListening(shard);
 }
 
-void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
-                                      const Sock::EventsPerSock& events_per_sock)
+bool CConnman::SocketHandlerConnected(SocketHandlerShard& shard, const std::vector<CNode*>& nodes)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
+    bool busy{false};
     for (CNode* pnode : nodes) {
-        if (interruptNet)
-            return;
+        pnode->m_sock_pending = false;
+        if (interruptNet) {
+            QueuePendingNode(shard, *pnode);
+            continue;
+        }
 
-        //
-        // Receive
-        //
-        bool recvSet = false;
-        bool sendSet = false;
-        bool errorSet = false;
         {
             LOCK(pnode->m_sock_mutex);
             if (!pnode->m_sock) {
                 continue;
             }
-            const auto it = events_per_sock.find(pnode->m_sock);
-            if (it != events_per_sock.end()) {
-                recvSet = it->second.occurred & Sock::RECV;
-                sendSet = it->second.occurred & Sock::SEND;
-                errorSet = it->second.occurred & Sock::ERR;
-            }
         }
 
-        if (sendSet) {
+        bool recvSet = (pnode->m_sock_readable && !pnode->fPauseRecv) || pnode->m_sock_error;
+
+        if (pnode->m_sock_writable) {
             // Send data
             auto [bytes_sent, data_left] = WITH_LOCK(pnode->cs_vSend, return SocketSendData(*pnode));
+            if (data_left) {
+                // The send buffer of the socket is full, it is reported as writable again once
+                // there is room.
+                pnode->m_sock_writable = false;
+                shard.m_events.Rearm(pnode->GetId(), Sock::SEND);
+            }
             if (bytes_sent) {
                 RecordBytesSent(bytes_sent);
 
@@ -2098,7 +2311,7 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
             }
         }
 
-        if (recvSet || errorSet)
+        if (recvSet)
         {
             // typical socket buffer is 8K-64K
             uint8_t pchBuf[0x10000];
@@ -2112,14 +2325,24 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
             }
             if (nBytes > 0)
             {
+                // A read that doesn't fill the buffer empties the socket, and new data is
+                // reported as a new event. An error stays set until reading fails, so that
+                // the end of the stream is still read after the remaining data.
+                if ((size_t)nBytes < sizeof(pchBuf)) {
+                    pnode->m_sock_readable = false;
+                    shard.m_events.Rearm(pnode->GetId(), Sock::RECV);
+                }
                 bool notify = false;
                 if (!pnode->ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
                     pnode->CloseSocketDisconnect();
                 }
                 RecordBytesRecv(nBytes);
                 if (notify) {
-                    pnode->MarkReceivedMsgsForProcessing();
+                    const bool concurrent{pnode->MarkReceivedMsgsForProcessing([this](const std::string& msg_type) {
+                        return m_msg_pool_active && m_msgproc->IsConcurrentMessage(msg_type);
+                    })};
                     WakeMessageHandler();
+                    if (concurrent) QueueForMessagePool(*pnode);
                 }
             }
             else if (nBytes == 0)
@@ -2134,8 +2357,11 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
             {
                 // error
                 int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                {
+                if (nErr == WSAEWOULDBLOCK) {
+                    pnode->m_sock_readable = false;
+                    pnode->m_sock_error = false;
+                    shard.m_events.Rearm(pnode->GetId(), Sock::RECV);
+                } else if (nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
                     if (!pnode->fDisconnect) {
                         LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
                     }
@@ -2144,19 +2370,35 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
             }
         }
 
-        if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
+        if (WITH_LOCK(pnode->m_sock_mutex, return !pnode->m_sock)) continue;
+
+        // Visit the node again in the next iteration if it can make progress without waiting for
+        // a new event. This includes data that became ready to send while receiving, such as a v2
+        // handshake response. A node that could only receive while receiving is paused is
+        // retried without hurrying, until the message handler has caught up.
+        bool send_ready{false};
+        if (pnode->m_sock_writable) {
+            LOCK(pnode->cs_vSend);
+            const auto& [to_send, more, _msg_type] = pnode->m_transport->GetBytesToSend(!pnode->vSendMsg.empty());
+            send_ready = !to_send.empty() || more;
+        }
+        const bool recv_ready{(pnode->m_sock_readable && !pnode->fPauseRecv) || pnode->m_sock_error};
+        if (send_ready || recv_ready) busy = true;
+        if (send_ready || recv_ready || pnode->m_sock_readable) QueuePendingNode(shard, *pnode);
     }
+    return busy;
 }
 
-void CConnman::SocketHandlerListening(const Sock::EventsPerSock& events_per_sock)
+void CConnman::SocketHandlerListening(SocketHandlerShard& shard)
 {
-    for (const ListenSocket& listen_socket : vhListenSocket) {
+    for (size_t i{0}; i < m_sock_listen_ready.size(); ++i) {
         if (interruptNet) {
             return;
         }
-        const auto it = events_per_sock.find(listen_socket.sock);
-        if (it != events_per_sock.end() && it->second.occurred & Sock::RECV) {
-            AcceptConnection(listen_socket);
+        if (m_sock_listen_ready[i] && !AcceptConnection(vhListenSocket[i])) {
+            // There are no more connections to accept, until the socket is reported as ready again.
+            m_sock_listen_ready[i] = false;
+            shard.m_events.Rearm(ListenSockKey(i), Sock::RECV);
         }
     }
 }
@@ -2169,7 +2411,17 @@ void CConnman::ThreadSocketHandler()
     {
         DisconnectNodes();
         NotifyNumConnectionsChanged();
-        SocketHandler();
+        CheckInactiveNodes();
+        SocketHandler(*m_sock_shards.front());
+    }
+}
+
+void CConnman::ThreadSocketHandlerShard(SocketHandlerShard& shard)
+{
+    AssertLockNotHeld(m_total_bytes_sent_mutex);
+
+    while (!interruptNet) {
+        SocketHandler(shard);
     }
 }
 
@@ -2891,6 +3143,7 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
     {
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
+        AddNodeToSocketShard(*pnode);
 
         // update connection count by network
         if (pnode->IsManualOrFullOutboundConn()) ++m_network_conn_counts[pnode->addr.GetNetwork()];
@@ -2918,7 +3171,7 @@ void CConnman::ThreadMessageHandler()
                     continue;
 
                 // Receive messages
-                bool fMoreNodeWork = m_msgproc->ProcessMessages(pnode, flagInterruptMsgProc);
+                bool fMoreNodeWork = WITH_LOCK(pnode->m_msg_process_mutex, return m_msgproc->ProcessMessages(pnode, flagInterruptMsgProc));
                 fMoreWork |= (fMoreNodeWork && !pnode->fPauseSend);
                 if (flagInterruptMsgProc)
                     return;
@@ -2938,6 +3191,43 @@ void CConnman::ThreadMessageHandler()
     }
 }
 
+void CConnman::QueueForMessagePool(CNode& node)
+{
+    if (!m_msg_pool_active || node.m_msg_pool_queued.exchange(true)) return;
+    node.AddRef();
+    WITH_LOCK(m_msg_pool_mutex, m_msg_pool_queue.push_back(&node));
+    m_msg_pool_cond.notify_one();
+}
+
+void CConnman::ThreadMessagePool()
+{
+    while (!flagInterruptMsgProc) {
+        CNode* pnode;
+        {
+            WAIT_LOCK(m_msg_pool_mutex, lock);
+            m_msg_pool_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_msg_pool_mutex) { return flagInterruptMsgProc || !m_msg_pool_queue.empty(); });
+            if (flagInterruptMsgProc) return;
+            pnode = m_msg_pool_queue.front();
+            m_msg_pool_queue.pop_front();
+        }
+        // Cleared first, so that messages received from now on queue the node again
+        pnode->m_msg_pool_queued = false;
+
+        bool processed{false};
+        {
+            // If the lock is taken, the message handler thread is processing the node's messages,
+            // and it processes the next one in line itself.
+            TRY_LOCK(pnode->m_msg_process_mutex, lock_node);
+            if (lock_node && !pnode->fDisconnect) {
+                processed = m_msgproc->ProcessMessageConcurrently(pnode);
+            }
+        }
+        // Take turns with other nodes for any further messages.
+        if (processed) QueueForMessagePool(*pnode);
+        pnode->Release();
+    }
+}
+
 void CConnman::ThreadI2PAcceptIncoming()
 {
     static constexpr auto err_wait_begin = 1s;
@@ -3123,6 +3413,7 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In, AddrMan& addrman_in,
     , m_params(params)
 {
     SetTryNewOutboundPeer(false);
+    m_sock_shards.push_back(std::make_unique<SocketHandlerShard>());
 
     Options connOptions;
     Init(connOptions);
@@ -3247,7 +3538,14 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Send and receive from sockets, accept connections
+    while (m_sock_shards.size() < static_cast<size_t>(m_socket_threads)) {
+        m_sock_shards.push_back(std::make_unique<SocketHandlerShard>());
+    }
     threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
+    for (size_t i{1}; i < m_sock_shards.size(); ++i) {
+        SocketHandlerShard& shard{*m_sock_shards[i]};
+        shard.m_thread = std::thread(&util::TraceThread, strprintf("net.%d", i), [this, &shard] { ThreadSocketHandlerShard(shard); });
+    }
 
     if (!gArgs.GetBoolArg("-dnsseed", DEFAULT_DNSSEED))
         LogPrintf("DNS seeding disabled\n");
@@ -3273,6 +3571,10 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
     // Process messages
     threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    m_msg_pool_active = true;
+    for (int i{0}; i < MESSAGE_POOL_THREADS; ++i) {
+        m_msg_pool_threads.emplace_back(&util::TraceThread, strprintf("msgpool.%d", i), [this] { ThreadMessagePool(); });
+    }
 
     if (m_i2p_sam_session) {
         threadI2PAcceptIncoming =
@@ -3314,6 +3616,11 @@ void CConnman::Interrupt()
     }
     condMsgProc.notify_all();
 
+    {
+        LOCK(m_msg_pool_mutex);
+    }
+    m_msg_pool_cond.notify_all();
+
     interruptNet();
     g_socks5_interrupt();
 
@@ -3345,6 +3652,22 @@ void CConnman::StopThreads()
         threadDNSAddressSeed.join();
     if (threadSocketHandler.joinable())
         threadSocketHandler.join();
+    for (const auto& shard : m_sock_shards) {
+        if (shard->m_thread.joinable()) shard->m_thread.join();
+    }
+    for (auto& thread : m_msg_pool_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    m_msg_pool_threads.clear();
+    m_msg_pool_active = false;
+    {
+        LOCK(m_msg_pool_mutex);
+        for (CNode* pnode : m_msg_pool_queue) {
+            pnode->m_msg_pool_queued = false;
+            pnode->Release();
+        }
+        m_msg_pool_queue.clear();
+    }
 }
 
 void CConnman::StopNodes()
@@ -3366,6 +3689,7 @@ void CConnman::StopNodes()
     // Delete peer connections.
     std::vector<CNode*> nodes;
     WITH_LOCK(m_nodes_mutex, nodes.swap(m_nodes));
+    ClearSocketShards();
     for (CNode* pnode : nodes) {
         pnode->CloseSocketDisconnect();
         DeleteNode(pnode);
@@ -3375,6 +3699,10 @@ void CConnman::StopNodes()
         DeleteNode(pnode);
     }
     m_nodes_disconnected.clear();
+    for (size_t i{0}; i < m_sock_listen_ready.size(); ++i) {
+        m_sock_shards.front()->m_events.Remove(ListenSockKey(i));
+    }
+    m_sock_listen_ready.clear();
     vhListenSocket.clear();
     semOutbound.reset();
     semAddnode.reset();
@@ -3715,27 +4043,31 @@ CNode::CNode(NodeId idIn,
     }
 }
 
-void CNode::MarkReceivedMsgsForProcessing()
+bool CNode::MarkReceivedMsgsForProcessing(const std::function<bool(const std::string& msg_type)>& filter)
 {
     AssertLockNotHeld(m_msg_process_queue_mutex);
 
     size_t nSizeAdded = 0;
+    bool matched{false};
     for (const auto& msg : vRecvMsg) {
         // vRecvMsg contains only completed CNetMessage
         // the single possible partially deserialized message are held by TransportDeserializer
         nSizeAdded += msg.m_raw_message_size;
+        if (filter && !matched) matched = filter(msg.m_type);
     }
 
     LOCK(m_msg_process_queue_mutex);
     m_msg_process_queue.splice(m_msg_process_queue.end(), vRecvMsg);
     m_msg_process_queue_size += nSizeAdded;
     fPauseRecv = m_msg_process_queue_size > m_recv_flood_size;
+    return matched;
 }
 
-std::optional<std::pair<CNetMessage, bool>> CNode::PollMessage()
+std::optional<std::pair<CNetMessage, bool>> CNode::PollMessage(const std::function<bool(const std::string& msg_type)>& filter)
 {
     LOCK(m_msg_process_queue_mutex);
     if (m_msg_process_queue.empty()) return std::nullopt;
+    if (filter && !filter(m_msg_process_queue.front().m_type)) return std::nullopt;
 
     std::list<CNetMessage> msgs;
     // Just take one message
@@ -3770,6 +4102,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
     );
 
     size_t nBytesSent = 0;
+    bool data_left{false};
     {
         LOCK(pnode->cs_vSend);
         // Check if the transport still has unsent bytes, and indicate to it that we're about to
@@ -3792,10 +4125,16 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         // results in sendable bytes there, but with V2Transport this is not the case (it may
         // still be in the handshake).
         if (queue_was_empty && more) {
-            std::tie(nBytesSent, std::ignore) = SocketSendData(*pnode);
+            std::tie(nBytesSent, data_left) = SocketSendData(*pnode);
         }
     }
     if (nBytesSent) RecordBytesSent(nBytesSent);
+    if (data_left) {
+        // Only the socket handler thread of the node can wait for its socket to become writable.
+        SocketHandlerShard& shard{*m_sock_shards[pnode->m_sock_shard]};
+        LOCK(shard.m_mutex);
+        shard.m_to_send.push_back(pnode->GetId());
+    }
 }
 
 bool CConnman::ForNode(NodeId id, std::function<bool(CNode* pnode)> func)
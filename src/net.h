@@ -30,8 +30,10 @@
 #include <uint256.h>
 #include <util/check.h>
 #include <util/sock.h>
+#include <util/sockevents.h>
 #include <util/threadinterrupt.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -43,6 +45,7 @@
 #include <optional>
 #include <queue>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -81,6 +84,12 @@ static const std::string DEFAULT_MAX_UPLOAD_TARGET{"0M"};
 static const bool DEFAULT_BLOCKSONLY = false;
 /** -peertimeout default */
 static const int64_t DEFAULT_PEER_CONNECT_TIMEOUT = 60;
+/** Number of threads processing messages that don't need the message handler thread */
+static constexpr int MESSAGE_POOL_THREADS{2};
+/** -socketthreads default */
+static constexpr int DEFAULT_SOCKET_THREADS{1};
+/** Maximum number of threads doing network IO for connected peers */
+static constexpr int MAX_SOCKET_THREADS{16};
 /** Number of file descriptors required for message capture **/
 static const int NUM_FDS_MESSAGE_CAPTURE = 1;
 /** Interval for ASMap Health Check **/
@@ -288,9 +297,19 @@ public:
 
     // 2. Sending side functions, for converting messages into bytes to be sent over the wire.
 
+    /** Maximum number of messages that a transport queues for sending at once. */
+    static constexpr size_t MAX_SEND_BATCH_MESSAGES{64};
+    /** Maximum number of bytes of messages that a transport queues for sending at once, unless it
+     *  is a single message. */
+    static constexpr size_t MAX_SEND_BATCH_BYTES{64 * 1024};
+
     /** Set the next message to send.
      *
-     * If no message can currently be set (perhaps because the previous one is not yet done being
+     * A transport accepts messages while earlier ones are still being sent, so that several of
+     * them can be sent at once (see GetSendBuffers()), up to MAX_SEND_BATCH_MESSAGES messages or
+     * MAX_SEND_BATCH_BYTES bytes.
+     *
+     * If no message can currently be set (perhaps because too many bytes are not yet done being
      * sent), returns false, and msg will be unmodified. Otherwise msg is enqueued (and
      * possibly moved-from) and true is returned.
      */
@@ -346,9 +365,32 @@ public:
      */
     virtual BytesToSend GetBytesToSend(bool have_next_message) const noexcept = 0;
 
-    /** Report how many bytes returned by the last GetBytesToSend() have been sent.
+    /** A part of the bytes to send, and the message type on behalf of which it is being sent
+     *  ("" for bytes that are not on behalf of any message). */
+    struct SendBuffer {
+        Span<const uint8_t> data;
+        const std::string& m_type;
+    };
+
+    /** Get all bytes to send on the wire, to send them with a single scatter/gather write.
      *
-     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result.
+     * The buffers start with the to_send bytes of GetBytesToSend(), and continue with the bytes of
+     * all other messages that are queued. Sending them all and reporting it with one MarkBytesSent()
+     * call is equivalent to sending them one GetBytesToSend() result at a time.
+     *
+     * @param[in]  have_next_message See GetBytesToSend().
+     * @param[out] buffers           The non-empty buffers to send, in order. Like to_send, they refer
+     *                               to data that is internal to the transport.
+     * @return whether there will be more bytes to send after all the buffers are sent, like the
+     *         'more' value of GetBytesToSend().
+     */
+    virtual bool GetSendBuffers(bool have_next_message, std::vector<SendBuffer>& buffers) const noexcept = 0;
+
+    /** Report how many bytes returned by the last GetBytesToSend() or GetSendBuffers() have been
+     *  sent.
+     *
+     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result, or the total
+     * size of the buffers of the last GetSendBuffers() result.
      *
      * If bytes_sent=0, this call has no effect.
      */
@@ -401,17 +443,26 @@ private:
         return hdr.nMessageSize == nDataPos;
     }
 
+    /** A message to send, and its serialized header. */
+    struct MessageToSend {
+        std::vector<uint8_t> header;
+        CSerializedNetMsg msg;
+    };
+
     /** Lock for sending state. */
     mutable Mutex m_send_mutex;
-    /** The header of the message currently being sent. */
-    std::vector<uint8_t> m_header_to_send GUARDED_BY(m_send_mutex);
-    /** The data of the message currently being sent. */
-    CSerializedNetMsg m_message_to_send GUARDED_BY(m_send_mutex);
-    /** Whether we're currently sending header bytes or message bytes. */
+    /** The messages to send. Only the first one may have been partially sent. */
+    std::deque<MessageToSend> m_messages_to_send GUARDED_BY(m_send_mutex);
+    /** Number of header and data bytes of the messages in m_messages_to_send. */
+    size_t m_messages_to_send_size GUARDED_BY(m_send_mutex) {0};
+    /** Whether we're currently sending header bytes or message bytes of the first message. */
     bool m_sending_header GUARDED_BY(m_send_mutex) {false};
-    /** How many bytes have been sent so far (from m_header_to_send, or from m_message_to_send.data). */
+    /** How many bytes have been sent so far (from the first message's header or data). */
     size_t m_bytes_sent GUARDED_BY(m_send_mutex) {0};
 
+    /** Move on to the next part to send, after the current header or data is sent. */
+    void NextPartToSend() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_send_mutex);
+
 public:
     explicit V1Transport(const NodeId node_id) noexcept;
 
@@ -440,6 +491,7 @@ public:
 
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    bool GetSendBuffers(bool have_next_message, std::vector<SendBuffer>& buffers) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     bool ShouldReconnectV1() const noexcept override { return false; }
@@ -597,14 +649,17 @@ private:
     /** Lock for sending-side fields. If both sending and receiving fields are accessed,
      *  m_recv_mutex must be acquired before m_send_mutex. */
     mutable Mutex m_send_mutex ACQUIRED_AFTER(m_recv_mutex);
-    /** The send buffer; meaning is determined by m_send_state. */
+    /** The send buffer; meaning is determined by m_send_state. In READY state, packets are
+     *  appended to it while earlier ones are still being sent, and its memory is kept for reuse
+     *  once everything is sent, unless it has grown larger than MAX_SEND_BATCH_BYTES. */
     std::vector<uint8_t> m_send_buffer GUARDED_BY(m_send_mutex);
     /** How many bytes from the send buffer have been sent so far. */
     uint32_t m_send_pos GUARDED_BY(m_send_mutex) {0};
     /** The garbage sent, or to be sent (MAYBE_V1 and AWAITING_KEY state only). */
     std::vector<uint8_t> m_send_garbage GUARDED_BY(m_send_mutex);
-    /** Type of the message being sent. */
-    std::string m_send_type GUARDED_BY(m_send_mutex);
+    /** For the packets in the send buffer that are not completely sent yet, in order: where in the
+     *  send buffer they end, and the type of the message they hold. */
+    std::deque<std::pair<uint32_t, std::string>> m_send_packets GUARDED_BY(m_send_mutex);
     /** Current sender state. */
     SendState m_send_state GUARDED_BY(m_send_mutex);
     /** Whether we've sent at least 24 bytes (which would trigger disconnect for V1 peers). */
@@ -650,6 +705,7 @@ public:
     // Send side functions.
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    bool GetSendBuffers(bool have_next_message, std::vector<SendBuffer>& buffers) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
 
@@ -693,6 +749,8 @@ public:
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
     /** Messages still to be fed to m_transport->SetMessageToSend. */
     std::deque<CSerializedNetMsg> vSendMsg GUARDED_BY(cs_vSend);
+    /** The buffers that SocketSendData() gets from the transport, kept to reuse their memory. */
+    std::vector<Transport::SendBuffer> m_send_buffers GUARDED_BY(cs_vSend);
     Mutex cs_vSend;
     Mutex m_sock_mutex;
     Mutex cs_vRecv;
@@ -736,18 +794,39 @@ public:
     std::atomic_bool fPauseRecv{false};
     std::atomic_bool fPauseSend{false};
 
+    // Readiness of m_sock as last reported to the socket handler, which acts on it until reading
+    // or writing would block. Used only by the socket handler thread that serves the node
+    bool m_sock_readable{false};
+    bool m_sock_writable{false};
+    bool m_sock_error{false};
+    // Whether the node is in the pending nodes of its socket handler shard. Used only by the
+    // socket handler thread that serves the node
+    bool m_sock_pending{false};
+    // Index of the socket handler shard that serves the node, set before it is handed to it
+    size_t m_sock_shard{0};
+
+    /** Held while one of the received messages is processed, so that they are processed one at a
+     * time and in order, by the message handler thread or the message processing pool. */
+    Mutex m_msg_process_mutex;
+    // Whether the node is in CConnman's message processing pool queue
+    std::atomic_bool m_msg_pool_queued{false};
+
     const ConnectionType m_conn_type;
 
-    /** Move all messages from the received queue to the processing queue. */
-    void MarkReceivedMsgsForProcessing()
+    /** Move all messages from the received queue to the processing queue.
+     *
+     * Returns whether the type of any of the moved messages is accepted by
+     * `filter`, if one is given. */
+    bool MarkReceivedMsgsForProcessing(const std::function<bool(const std::string& msg_type)>& filter = {})
         EXCLUSIVE_LOCKS_REQUIRED(!m_msg_process_queue_mutex);
 
     /** Poll the next message from the processing queue of this connection.
      *
-     * Returns std::nullopt if the processing queue is empty, or a pair
-     * consisting of the message and a bool that indicates if the processing
-     * queue has more entries. */
-    std::optional<std::pair<CNetMessage, bool>> PollMessage()
+     * Returns std::nullopt if the processing queue is empty, or if a `filter`
+     * is given and doesn't accept the type of the next message. Otherwise
+     * returns a pair consisting of the message and a bool that indicates if
+     * the processing queue has more entries. */
+    std::optional<std::pair<CNetMessage, bool>> PollMessage(const std::function<bool(const std::string& msg_type)>& filter = {})
         EXCLUSIVE_LOCKS_REQUIRED(!m_msg_process_queue_mutex);
 
     /** Account for the total size of a sent message in the per msg type connection stats. */
@@ -1015,6 +1094,23 @@ public:
     */
     virtual bool ProcessMessages(CNode* pnode, std::atomic<bool>& interrupt) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
 
+    /**
+    * Whether messages of a type can be processed by ProcessMessageConcurrently(), because
+    * processing them neither affects nor waits for validation.
+    */
+    virtual bool IsConcurrentMessage(const std::string& msg_type) const = 0;
+
+    /**
+    * Process the next protocol message received from a given node, if it is of a type that
+    * IsConcurrentMessage() accepts and nothing else is due for the node first. Called by the
+    * message processing pool, concurrently with ProcessMessages() and SendMessages() for
+    * other nodes, and with SendMessages() for the same node.
+    *
+    * @param[in]   pnode           The node which we have received messages from.
+    * @return                      True if a message was processed
+    */
+    virtual bool ProcessMessageConcurrently(CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(!g_msgproc_mutex) = 0;
+
     /**
     * Send queued protocol messages to a given node.
     *
@@ -1047,6 +1143,7 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundLimit = 0;
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
+        int socket_threads = DEFAULT_SOCKET_THREADS;
         std::vector<std::string> vSeedNodes;
         std::vector<NetWhitelistPermissions> vWhitelistedRangeIncoming;
         std::vector<NetWhitelistPermissions> vWhitelistedRangeOutgoing;
@@ -1081,6 +1178,7 @@ public:
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
         m_peer_connect_timeout = std::chrono::seconds{connOptions.m_peer_connect_timeout};
+        m_socket_threads = std::clamp(connOptions.socket_threads, 1, MAX_SOCKET_THREADS);
         {
             LOCK(m_total_bytes_sent_mutex);
             nMaxOutboundLimit = connOptions.nMaxOutboundLimit;
@@ -1106,7 +1204,7 @@ public:
 
     ~CConnman();
 
-    bool Start(CScheduler& scheduler, const Options& options) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !m_added_nodes_mutex, !m_addr_fetches_mutex, !mutexMsgProc);
+    bool Start(CScheduler& scheduler, const Options& options) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !m_added_nodes_mutex, !m_addr_fetches_mutex, !mutexMsgProc, !m_msg_pool_mutex);
 
     void StopThreads();
     void StopNodes();
@@ -1116,7 +1214,7 @@ public:
         StopNodes();
     };
 
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc, !m_msg_pool_mutex);
     bool GetNetworkActive() const { return fNetworkActive; };
     bool GetUseAddrmanOutgoing() const { return m_use_addrman_outgoing; };
     void SetNetworkActive(bool active);
@@ -1275,8 +1373,16 @@ private:
     void ProcessAddrFetch() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_unused_i2p_sessions_mutex);
     void ThreadOpenConnections(std::vector<std::string> connect) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex, !m_unused_i2p_sessions_mutex, !m_reconnections_mutex);
     void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    void ThreadMessagePool() EXCLUSIVE_LOCKS_REQUIRED(!m_msg_pool_mutex);
+
+    /** Let the message processing pool look at a node's messages, see NetEventsInterface::ProcessMessageConcurrently(). */
+    void QueueForMessagePool(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_pool_mutex);
     void ThreadI2PAcceptIncoming();
-    void AcceptConnection(const ListenSocket& hListenSocket);
+    /**
+     * Accept a connection from a listening socket.
+     * @return false if there was no connection to accept or accepting it failed
+     */
+    bool AcceptConnection(const ListenSocket& hListenSocket);
 
     /**
      * Create a `CNode` object from a socket that has just been accepted and add the node to
@@ -1297,33 +1403,84 @@ private:
     bool InactivityCheck(const CNode& node) const;
 
     /**
-     * Generate a collection of sockets to check for IO readiness.
-     * @param[in] nodes Select from these nodes' sockets.
-     * @return sockets to check for readiness
+     * The sockets of a share of the connected nodes, which a socket handler thread waits on and
+     * does the IO for, including the transport's decryption of received data. Each node is served
+     * by a single shard, which keeps its data in order.
+     *
+     * Sockets are added once, keyed by node id (or ListenSockKey() for the listening sockets, which
+     * belong to the first shard), and waiting only reports the ones that became ready, so an
+     * iteration doesn't visit idle nodes.
      */
-    Sock::EventsPerSock GenerateWaitSockets(Span<CNode* const> nodes);
+    struct SocketHandlerShard {
+        Mutex m_mutex;
+        //! Nodes to start serving. The shard holds a reference to each of them until it stops.
+        std::vector<CNode*> m_to_register GUARDED_BY(m_mutex);
+        //! Ids of nodes to stop serving
+        std::vector<NodeId> m_to_unregister GUARDED_BY(m_mutex);
+        //! Ids of nodes that a send from another thread left unsent data for
+        std::vector<NodeId> m_to_send GUARDED_BY(m_mutex);
+
+        // Used only by the thread of the shard:
+        SockEvents m_events;
+        std::unordered_map<NodeId, CNode*> m_nodes;
+        //! Nodes with readiness left to act on in the next iteration
+        std::vector<CNode*> m_pending_nodes;
+        //! Whether the nodes in m_pending_nodes can make progress without waiting for new events
+        bool m_busy{false};
+
+        //! Runs ThreadSocketHandlerShard(), except for the first shard
+        std::thread m_thread;
+    };
+
+    /** Hand a new node to a socket handler shard, which starts serving it in its next iteration. */
+    void AddNodeToSocketShard(CNode& node);
+
+    /** Make the socket handler shard of a node that is being removed stop serving it. */
+    void RemoveNodeFromSocketShard(const CNode& node);
 
     /**
-     * Check connected and listening sockets for IO readiness and process them accordingly.
+     * Stop serving all nodes, releasing the references held by the shards. Only to be called while
+     * no socket handler thread is running.
      */
-    void SocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
+    void ClearSocketShards();
+
+    /**
+     * Start and stop waiting for events on the sockets of the nodes handed to a shard, and queue
+     * the nodes that have data left to send after a send from another thread.
+     */
+    void UpdateShardSockets(SocketHandlerShard& shard);
+
+    /** Make a shard visit a node in its next iteration, if it isn't going to already. */
+    void QueuePendingNode(SocketHandlerShard& shard, CNode& node);
 
     /**
-     * Do the read/write for connected sockets that are ready for IO.
-     * @param[in] nodes Nodes to process. The socket of each node is checked against `what`.
-     * @param[in] events_per_sock Sockets that are ready for IO.
+     * Check the connected sockets of a shard (and the listening sockets, for the first shard) for
+     * IO readiness and process them accordingly.
      */
-    void SocketHandlerConnected(const std::vector<CNode*>& nodes,
-                                const Sock::EventsPerSock& events_per_sock)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
+    void SocketHandler(SocketHandlerShard& shard) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_msg_pool_mutex);
+
+    /**
+     * Do the read/write for connected sockets that are ready for IO, as far as they are ready
+     * according to their `m_sock_*` flags. Nodes that are still ready afterwards are queued to be
+     * visited again in the next iteration.
+     * @param[in] shard The shard serving the nodes.
+     * @param[in] nodes Nodes to process.
+     * @return whether any of the queued nodes can make progress without waiting for new events
+     */
+    bool SocketHandlerConnected(SocketHandlerShard& shard, const std::vector<CNode*>& nodes)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_msg_pool_mutex);
 
     /**
      * Accept incoming connections, one from each read-ready listening socket.
-     * @param[in] events_per_sock Sockets that are ready for IO.
+     * @param[in] shard The first shard, which waits on the listening sockets.
      */
-    void SocketHandlerListening(const Sock::EventsPerSock& events_per_sock);
+    void SocketHandlerListening(SocketHandlerShard& shard);
 
-    void ThreadSocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_nodes_mutex, !m_reconnections_mutex);
+    /** Disconnect nodes that have been inactive for too long, checking all of them once a second. */
+    void CheckInactiveNodes() EXCLUSIVE_LOCKS_REQUIRED(!m_nodes_mutex);
+
+    void ThreadSocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_msg_pool_mutex, !m_nodes_mutex, !m_reconnections_mutex);
+    void ThreadSocketHandlerShard(SocketHandlerShard& shard) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_msg_pool_mutex);
     void ThreadDNSAddressSeed() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_nodes_mutex);
 
     uint64_t CalculateKeyedNetGroup(const CAddress& ad) const;
@@ -1421,6 +1578,20 @@ private:
     std::vector<CNode*> m_nodes GUARDED_BY(m_nodes_mutex);
     std::list<CNode*> m_nodes_disconnected;
     mutable RecursiveMutex m_nodes_mutex;
+
+    /**
+     * Socket handler shards, which the connected nodes are spread over. The first one is served by
+     * threadSocketHandler, the others by a thread of their own. Shards are only added before
+     * threads are started.
+     */
+    std::vector<std::unique_ptr<SocketHandlerShard>> m_sock_shards;
+    //! Number of socket handler threads to run, see -socketthreads
+    int m_socket_threads{DEFAULT_SOCKET_THREADS};
+    // Used only by threadSocketHandler:
+    //! Whether each listening socket may have connections left to accept
+    std::vector<bool> m_sock_listen_ready;
+    //! When to next check all nodes for inactivity
+    SteadyClock::time_point m_sock_next_inactivity_check{};
     std::atomic<NodeId> nLastNodeId{0};
     unsigned int nPrevNodeCount{0};
 
@@ -1515,6 +1686,19 @@ private:
     Mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc{false};
 
+    /**
+     * The message processing pool, whose threads process the messages that can be processed
+     * concurrently as long as they are next in line for their node, instead of leaving them to
+     * wait behind other nodes' messages for the message handler thread.
+     */
+    Mutex m_msg_pool_mutex;
+    std::condition_variable m_msg_pool_cond;
+    //! Nodes that may have a message for the pool, each with a reference held for it
+    std::deque<CNode*> m_msg_pool_queue GUARDED_BY(m_msg_pool_mutex);
+    std::vector<std::thread> m_msg_pool_threads;
+    //! Whether the pool threads are running
+    std::atomic_bool m_msg_pool_active{false};
+
     /**
      * This is signaled when network activity should cease.
      * A pointer to it is saved in `m_i2p_sam_session`, so make sure that
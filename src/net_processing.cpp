@@ -22,6 +22,7 @@
 #include <merkleblock.h>
 #include <netbase.h>
 #include <netmessagemaker.h>
+#include <node/blockcache.h>
 #include <node/blockstorage.h>
 #include <node/txreconciliation.h>
 #include <policy/fees.h>
@@ -504,6 +505,9 @@ public:
     bool HasAllDesirableServiceFlags(ServiceFlags services) const override;
     bool ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
+    bool IsConcurrentMessage(const std::string& msg_type) const override;
+    bool ProcessMessageConcurrently(CNode* pfrom) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !g_msgproc_mutex);
     bool SendMessages(CNode* pto) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, g_msgproc_mutex);
 
@@ -610,6 +614,16 @@ private:
     bool ProcessOrphanTx(Peer& peer)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex);
 
+    /** Trace and capture a message taken from a peer's processing queue. */
+    void TraceReceivedMessage(const CNode& pfrom, const CNetMessage& msg);
+
+    /**
+     * Process a message of a type that IsConcurrentMessage() accepts, after the version handshake.
+     * These messages only use state of the peer that is safe to access concurrently, and cs_main
+     * at most for lookups, so this can run without g_msgproc_mutex.
+     */
+    void ProcessConcurrentMessage(CNode& pfrom, Peer& peer, const std::string& msg_type, DataStream& vRecv);
+
     /** Process a single headers message from a peer.
      *
      * @param[in]   pfrom     CNode of the peer
@@ -2368,14 +2382,23 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     std::shared_ptr<const CBlock> pblock;
     if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
+    } else if (m_opts.block_cache && (inv.IsMsgBlk() || inv.IsMsgWitnessBlk())) {
+        // Serve the block from the serialized blocks shared with other peers, without
+        // reading it from disk again if it was requested recently
+        const auto block_data{m_opts.block_cache->GetOrRead(m_chainman.m_blockman, *pindex, /*witness=*/inv.IsMsgWitnessBlk())};
+        if (!block_data) {
+            assert(!"cannot load block from disk");
+        }
+        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{*block_data});
+        // Don't set pblock as we've sent the block
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
         // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
+        node::RawBlock block_data;
         if (!m_chainman.m_blockman.ReadRawBlockFromDisk(block_data, pindex->GetBlockPos())) {
             assert(!"cannot load block from disk");
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
+        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, block_data.data());
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
@@ -3457,6 +3480,65 @@ void PeerManagerImpl::ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const Bl
     return;
 }
 
+bool PeerManagerImpl::IsConcurrentMessage(const std::string& msg_type) const
+{
+    return msg_type == NetMsgType::PING ||
+           msg_type == NetMsgType::FEEFILTER ||
+           msg_type == NetMsgType::GETCFILTERS ||
+           msg_type == NetMsgType::GETCFHEADERS ||
+           msg_type == NetMsgType::GETCFCHECKPT;
+}
+
+void PeerManagerImpl::ProcessConcurrentMessage(CNode& pfrom, Peer& peer, const std::string& msg_type, DataStream& vRecv)
+{
+    if (msg_type == NetMsgType::PING) {
+        if (pfrom.GetCommonVersion() > BIP0031_VERSION) {
+            uint64_t nonce = 0;
+            vRecv >> nonce;
+            // Echo the message back with the nonce. This allows for two useful features:
+            //
+            // 1) A remote node can quickly check if the connection is operational
+            // 2) Remote nodes can measure the latency of the network thread. If this node
+            //    is overloaded it won't respond to pings quickly and the remote node can
+            //    avoid sending us more work, like chain download requests.
+            //
+            // The nonce stops the remote getting confused between different pings: without
+            // it, if the remote node sends a ping once per second and this node takes 5
+            // seconds to respond to each, the 5th ping the remote sends would appear to
+            // return very quickly.
+            MakeAndPushMessage(pfrom, NetMsgType::PONG, nonce);
+        }
+        return;
+    }
+
+    if (msg_type == NetMsgType::FEEFILTER) {
+        CAmount newFeeFilter = 0;
+        vRecv >> newFeeFilter;
+        if (MoneyRange(newFeeFilter)) {
+            if (auto tx_relay = peer.GetTxRelay(); tx_relay != nullptr) {
+                tx_relay->m_fee_filter_received = newFeeFilter;
+            }
+            LogPrint(BCLog::NET, "received: feefilter of %s from peer=%d\n", CFeeRate(newFeeFilter).ToString(), pfrom.GetId());
+        }
+        return;
+    }
+
+    if (msg_type == NetMsgType::GETCFILTERS) {
+        ProcessGetCFilters(pfrom, peer, vRecv);
+        return;
+    }
+
+    if (msg_type == NetMsgType::GETCFHEADERS) {
+        ProcessGetCFHeaders(pfrom, peer, vRecv);
+        return;
+    }
+
+    if (msg_type == NetMsgType::GETCFCHECKPT) {
+        ProcessGetCFCheckPt(pfrom, peer, vRecv);
+        return;
+    }
+}
+
 void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type, DataStream& vRecv,
                                      const std::chrono::microseconds time_received,
                                      const std::atomic<bool>& interruptMsgProc)
@@ -3867,6 +3949,11 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (IsConcurrentMessage(msg_type)) {
+        ProcessConcurrentMessage(pfrom, *peer, msg_type, vRecv);
+        return;
+    }
+
     if (msg_type == NetMsgType::ADDR || msg_type == NetMsgType::ADDRV2) {
         const auto ser_params{
             msg_type == NetMsgType::ADDRV2 ?
@@ -4173,8 +4260,14 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
             if (pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_BLOCKTXN_DEPTH) {
                 CBlock block;
-                const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pindex)};
-                assert(ret);
+                if (m_opts.block_cache) {
+                    const auto block_data{m_opts.block_cache->GetOrRead(m_chainman.m_blockman, *pindex, /*witness=*/true)};
+                    assert(block_data);
+                    SpanReader{*block_data} >> TX_WITH_WITNESS(block);
+                } else {
+                    const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pindex)};
+                    assert(ret);
+                }
 
                 SendBlockTransactions(pfrom, *peer, block, req);
                 return;
@@ -4842,26 +4935,6 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
-    if (msg_type == NetMsgType::PING) {
-        if (pfrom.GetCommonVersion() > BIP0031_VERSION) {
-            uint64_t nonce = 0;
-            vRecv >> nonce;
-            // Echo the message back with the nonce. This allows for two useful features:
-            //
-            // 1) A remote node can quickly check if the connection is operational
-            // 2) Remote nodes can measure the latency of the network thread. If this node
-            //    is overloaded it won't respond to pings quickly and the remote node can
-            //    avoid sending us more work, like chain download requests.
-            //
-            // The nonce stops the remote getting confused between different pings: without
-            // it, if the remote node sends a ping once per second and this node takes 5
-            // seconds to respond to each, the 5th ping the remote sends would appear to
-            // return very quickly.
-            MakeAndPushMessage(pfrom, NetMsgType::PONG, nonce);
-        }
-        return;
-    }
-
     if (msg_type == NetMsgType::PONG) {
         const auto ping_end = time_received;
         uint64_t nonce = 0;
@@ -4989,33 +5062,6 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
-    if (msg_type == NetMsgType::FEEFILTER) {
-        CAmount newFeeFilter = 0;
-        vRecv >> newFeeFilter;
-        if (MoneyRange(newFeeFilter)) {
-            if (auto tx_relay = peer->GetTxRelay(); tx_relay != nullptr) {
-                tx_relay->m_fee_filter_received = newFeeFilter;
-            }
-            LogPrint(BCLog::NET, "received: feefilter of %s from peer=%d\n", CFeeRate(newFeeFilter).ToString(), pfrom.GetId());
-        }
-        return;
-    }
-
-    if (msg_type == NetMsgType::GETCFILTERS) {
-        ProcessGetCFilters(pfrom, *peer, vRecv);
-        return;
-    }
-
-    if (msg_type == NetMsgType::GETCFHEADERS) {
-        ProcessGetCFHeaders(pfrom, *peer, vRecv);
-        return;
-    }
-
-    if (msg_type == NetMsgType::GETCFCHECKPT) {
-        ProcessGetCFCheckPt(pfrom, *peer, vRecv);
-        return;
-    }
-
     if (msg_type == NetMsgType::NOTFOUND) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
@@ -5116,18 +5162,7 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     CNetMessage& msg{poll_result->first};
     bool fMoreWork = poll_result->second;
 
-    TRACE6(net, inbound_message,
-        pfrom->GetId(),
-        pfrom->m_addr_name.c_str(),
-        pfrom->ConnectionTypeAsString().c_str(),
-        msg.m_type.c_str(),
-        msg.m_recv.size(),
-        msg.m_recv.data()
-    );
-
-    if (m_opts.capture_messages) {
-        CaptureMessage(pfrom->addr, msg.m_type, MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
-    }
+    TraceReceivedMessage(*pfrom, msg);
 
     try {
         ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
@@ -5151,6 +5186,55 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     return fMoreWork;
 }
 
+bool PeerManagerImpl::ProcessMessageConcurrently(CNode* pfrom)
+{
+    AssertLockNotHeld(g_msgproc_mutex);
+
+    PeerRef peer = GetPeerRef(pfrom->GetId());
+    if (peer == nullptr) return false;
+
+    // Only take a message ahead of the message handler thread if nothing that it does before
+    // processing the next message is due: completing the handshake, responding to earlier getdata
+    // requests and reconsidering orphans. Like ProcessMessages(), don't respond if the send buffer
+    // is full.
+    if (!pfrom->fSuccessfullyConnected || pfrom->fDisconnect || pfrom->fPauseSend) return false;
+    if (WITH_LOCK(peer->m_getdata_requests_mutex, return !peer->m_getdata_requests.empty())) return false;
+    if (m_orphanage.HaveTxToReconsider(peer->m_id)) return false;
+
+    auto poll_result{pfrom->PollMessage([this](const std::string& msg_type) { return IsConcurrentMessage(msg_type); })};
+    if (!poll_result) return false;
+
+    CNetMessage& msg{poll_result->first};
+    TraceReceivedMessage(*pfrom, msg);
+    LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(msg.m_type), msg.m_recv.size(), pfrom->GetId());
+
+    try {
+        ProcessConcurrentMessage(*pfrom, *peer, msg.m_type, msg.m_recv);
+    } catch (const std::exception& e) {
+        LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' (%s) caught\n", __func__, SanitizeString(msg.m_type), msg.m_message_size, e.what(), typeid(e).name());
+    } catch (...) {
+        LogPrint(BCLog::NET, "%s(%s, %u bytes): Unknown exception caught\n", __func__, SanitizeString(msg.m_type), msg.m_message_size);
+    }
+
+    return true;
+}
+
+void PeerManagerImpl::TraceReceivedMessage(const CNode& pfrom, const CNetMessage& msg)
+{
+    TRACE6(net, inbound_message,
+        pfrom.GetId(),
+        pfrom.m_addr_name.c_str(),
+        pfrom.ConnectionTypeAsString().c_str(),
+        msg.m_type.c_str(),
+        msg.m_recv.size(),
+        msg.m_recv.data()
+    );
+
+    if (m_opts.capture_messages) {
+        CaptureMessage(pfrom.addr, msg.m_type, MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
+    }
+}
+
 void PeerManagerImpl::ConsiderEviction(CNode& pto, Peer& peer, std::chrono::seconds time_in_seconds)
 {
     AssertLockHeld(cs_main);
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockcache.h>
+
+#include <chain.h>
+#include <kernel/cs_main.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <util/hasher.h>
+
+namespace node {
+size_t SerializedBlockCache::KeyHasher::operator()(const Key& key) const
+{
+    return BlockHasher{}(key.first) ^ size_t{key.second};
+}
+
+SerializedBlockCache::SerializedBlock SerializedBlockCache::Get(const uint256& hash, bool witness)
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find({hash, witness})};
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->block;
+}
+
+void SerializedBlockCache::Insert(const uint256& hash, bool witness, SerializedBlock block)
+{
+    if (!block || block->size() > m_max_bytes) return;
+
+    LOCK(m_mutex);
+    const Key key{hash, witness};
+    if (const auto it{m_index.find(key)}; it != m_index.end()) {
+        // Another thread read the same block in the meantime
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+    while (m_bytes + block->size() > m_max_bytes) {
+        const Entry& evict{m_lru.back()};
+        m_bytes -= evict.block->size();
+        m_index.erase(evict.key);
+        m_lru.pop_back();
+    }
+    m_bytes += block->size();
+    m_lru.push_front(Entry{key, std::move(block)});
+    m_index.emplace(key, m_lru.begin());
+}
+
+SerializedBlockCache::SerializedBlock SerializedBlockCache::GetOrRead(const BlockManager& blockman, const CBlockIndex& index, bool witness)
+{
+    const uint256 hash{index.GetBlockHash()};
+    if (auto block{Get(hash, witness)}) return block;
+
+    auto data{std::make_shared<std::vector<uint8_t>>()};
+    if (witness) {
+        // The block is stored on disk with witness data, so it can be copied as is
+        RawBlock raw_block;
+        if (!blockman.ReadRawBlockFromDisk(raw_block, WITH_LOCK(::cs_main, return index.GetBlockPos()))) return nullptr;
+        data->assign(raw_block.data().begin(), raw_block.data().end());
+    } else {
+        CBlock block;
+        if (!blockman.ReadBlockFromDisk(block, index)) return nullptr;
+        VectorWriter{*data, 0} << TX_NO_WITNESS(block);
+    }
+    Insert(hash, witness, data);
+    return data;
+}
+
+SerializedBlockCache::Stats SerializedBlockCache::GetStats() const
+{
+    LOCK(m_mutex);
+    return Stats{
+        .hits = m_hits,
+        .misses = m_misses,
+        .entries = m_lru.size(),
+        .bytes = m_bytes,
+        .max_bytes = m_max_bytes,
+    };
+}
+} // namespace node
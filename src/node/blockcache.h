@@ -0,0 +1,90 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCACHE_H
+#define BITCOIN_NODE_BLOCKCACHE_H
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CBlockIndex;
+
+namespace node {
+class BlockManager;
+
+/** Default for -blockcachesize, in MiB */
+static constexpr int64_t DEFAULT_BLOCK_CACHE_SIZE{0};
+
+/**
+ * A least-recently-used cache of serialized blocks, bounded by their total
+ * size. Blocks are cached both with and without witness data, so that
+ * repeated requests for the same recent blocks by different peers or REST
+ * clients are served without reading and re-serializing them from disk.
+ */
+class SerializedBlockCache
+{
+public:
+    using SerializedBlock = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t entries{0};
+        size_t bytes{0};
+        size_t max_bytes{0};
+    };
+
+    explicit SerializedBlockCache(size_t max_bytes) : m_max_bytes{max_bytes} {}
+
+    /** Return the cached serialization of a block, or nullptr if it isn't cached. */
+    SerializedBlock Get(const uint256& hash, bool witness) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Add the serialization of a block, evicting the least recently used
+     * entries to stay within the size limit. Blocks larger than the limit
+     * are not cached.
+     */
+    void Insert(const uint256& hash, bool witness, SerializedBlock block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Return the serialization of a block, reading it from disk and adding
+     * it to the cache if it isn't cached yet.
+     * @return nullptr if the block could not be read from disk.
+     */
+    SerializedBlock GetOrRead(const BlockManager& blockman, const CBlockIndex& index, bool witness) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    Stats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    using Key = std::pair<uint256, bool>;
+
+    struct KeyHasher {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        SerializedBlock block;
+    };
+
+    mutable Mutex m_mutex;
+    const size_t m_max_bytes;
+    //! Entries in order of use, most recently used first
+    std::list<Entry> m_lru GUARDED_BY(m_mutex);
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> m_index GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKCACHE_H
@@ -1040,19 +1040,31 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
 {
     block.SetNull();
 
-    // Open history file to read
-    AutoFile filein{OpenBlockFile(pos, true)};
-    if (filein.IsNull()) {
-        LogError("ReadBlockFromDisk: OpenBlockFile failed for %s\n", pos.ToString());
-        return false;
-    }
+    if (m_opts.use_mmap) {
+        // Deserialize straight from the mapped block file
+        RawBlock raw_block;
+        if (!ReadRawBlockFromDisk(raw_block, pos)) return false;
+        try {
+            SpanReader{raw_block.data()} >> TX_WITH_WITNESS(block);
+        } catch (const std::exception& e) {
+            LogError("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
+            return false;
+        }
+    } else {
+        // Open history file to read
+        AutoFile filein{OpenBlockFile(pos, true)};
+        if (filein.IsNull()) {
+            LogError("ReadBlockFromDisk: OpenBlockFile failed for %s\n", pos.ToString());
+            return false;
+        }
 
-    // Read block
-    try {
-        filein >> TX_WITH_WITNESS(block);
-    } catch (const std::exception& e) {
-        LogError("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
-        return false;
+        // Read block
+        try {
+            filein >> TX_WITH_WITNESS(block);
+        } catch (const std::exception& e) {
+            LogError("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
+            return false;
+        }
     }
 
     // Check the header
@@ -1085,41 +1097,53 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) co
     return true;
 }
 
-bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const
+AutoFile BlockManager::OpenRawBlock(const FlatFilePos& pos, unsigned int& blk_size) const
 {
     FlatFilePos hpos = pos;
     // If nPos is less than 8 the pos is null and we don't have the block data
     // Return early to prevent undefined behavior of unsigned int underflow
     if (hpos.nPos < 8) {
         LogError("%s: OpenBlockFile failed for %s\n", __func__, pos.ToString());
-        return false;
+        return AutoFile{nullptr};
     }
     hpos.nPos -= 8; // Seek back 8 bytes for meta header
     AutoFile filein{OpenBlockFile(hpos, true)};
     if (filein.IsNull()) {
         LogError("%s: OpenBlockFile failed for %s\n", __func__, pos.ToString());
-        return false;
+        return AutoFile{nullptr};
     }
 
     try {
         MessageStartChars blk_start;
-        unsigned int blk_size;
-
         filein >> blk_start >> blk_size;
 
         if (blk_start != GetParams().MessageStart()) {
             LogError("%s: Block magic mismatch for %s: %s versus expected %s\n", __func__, pos.ToString(),
                          HexStr(blk_start),
                          HexStr(GetParams().MessageStart()));
-            return false;
+            return AutoFile{nullptr};
         }
 
         if (blk_size > MAX_SIZE) {
             LogError("%s: Block data is larger than maximum deserialization size for %s: %s versus %s\n", __func__, pos.ToString(),
                          blk_size, MAX_SIZE);
-            return false;
+            return AutoFile{nullptr};
         }
+    } catch (const std::exception& e) {
+        LogError("%s: Read from block file failed: %s for %s\n", __func__, e.what(), pos.ToString());
+        return AutoFile{nullptr};
+    }
+
+    return AutoFile{filein.release()};
+}
 
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const
+{
+    unsigned int blk_size;
+    AutoFile filein{OpenRawBlock(pos, blk_size)};
+    if (filein.IsNull()) return false;
+
+    try {
         block.resize(blk_size); // Zeroing of memory is intentional here
         filein.read(MakeWritableByteSpan(block));
     } catch (const std::exception& e) {
@@ -1130,6 +1154,28 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+bool BlockManager::ReadRawBlockFromDisk(RawBlock& block, const FlatFilePos& pos) const
+{
+    if (!m_opts.use_mmap) {
+        block.m_mapping.reset();
+        return ReadRawBlockFromDisk(block.m_buffer, pos);
+    }
+
+    unsigned int blk_size;
+    AutoFile filein{OpenRawBlock(pos, blk_size)};
+    if (filein.IsNull()) return false;
+
+    block.m_buffer.clear();
+    block.m_mapping = MappedFileRange::Map(filein.Get(), pos.nPos, blk_size);
+    if (!block.m_mapping) {
+        // Fall back to reading the block, e.g. if the address space is exhausted.
+        LogPrint(BCLog::BLOCKSTORAGE, "Mapping block file failed for %s, reading it instead\n", pos.ToString());
+        return ReadRawBlockFromDisk(block.m_buffer, pos);
+    }
+
+    return true;
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(TX_WITH_WITNESS(block));
@@ -18,6 +18,7 @@
 #include <sync.h>
 #include <uint256.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/hasher.h>
 
 #include <array>
@@ -125,6 +126,24 @@ struct BlockfileCursor {
 
 std::ostream& operator<<(std::ostream& os, const BlockfileCursor& cursor);
 
+/**
+ * The serialized data of a block as stored in its block file, either copied
+ * into memory or, with -blockmmap, mapped directly from the file.
+ */
+class RawBlock
+{
+private:
+    std::vector<uint8_t> m_buffer;
+    std::unique_ptr<MappedFileRange> m_mapping;
+
+    friend class BlockManager;
+
+public:
+    Span<const uint8_t> data() const
+    {
+        return m_mapping ? UCharSpanCast(m_mapping->Data()) : Span<const uint8_t>{m_buffer};
+    }
+};
 
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
@@ -164,6 +183,14 @@ private:
 
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
+    /**
+     * Open the block file at the block stored at pos, checking the header
+     * written in front of it.
+     * @param[out] blk_size The size of the serialized block.
+     * @return The file positioned at the block, or a null file on failure.
+     */
+    AutoFile OpenRawBlock(const FlatFilePos& pos, unsigned int& blk_size) const;
+
     bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const;
     bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const;
 
@@ -364,6 +391,8 @@ public:
     bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const;
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
+    /** Like above, but maps the block file instead of copying the block out of it if -blockmmap is set. */
+    bool ReadRawBlockFromDisk(RawBlock& block, const FlatFilePos& pos) const;
 
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
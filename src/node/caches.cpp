@@ -5,6 +5,8 @@
 #include <node/caches.h>
 
 #include <common/args.h>
+#include <index/coinstatsindex.h>
+#include <index/syncblockreader.h>
 #include <index/txindex.h>
 #include <txdb.h>
 
@@ -25,6 +27,11 @@ CacheSizes CalculateCacheSizes(const ArgsManager& args, size_t n_indexes)
         sizes.filter_index = max_cache / n_indexes;
         nTotalCache -= sizes.filter_index * n_indexes;
     }
+    sizes.index_sync_blocks = 0;
+    if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX) || args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX) || n_indexes > 0) {
+        sizes.index_sync_blocks = std::min(nTotalCache / 8, MAX_SYNC_BLOCK_CACHE << 20);
+        nTotalCache -= sizes.index_sync_blocks;
+    }
     sizes.coins_db = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     sizes.coins_db = std::min(sizes.coins_db, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= sizes.coins_db;
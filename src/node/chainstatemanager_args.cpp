@@ -53,6 +53,21 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
     opts.worker_threads_num = std::clamp(script_threads - 1, 0, MAX_SCRIPTCHECK_THREADS);
     LogPrintf("Script verification uses %d additional threads\n", opts.worker_threads_num);
 
+    opts.prefetch_threads_num = static_cast<int>(std::clamp<int64_t>(args.GetIntArg("-prefetchthreads", DEFAULT_PREFETCH_THREADS), 0, MAX_PREFETCH_THREADS));
+    if (opts.prefetch_threads_num > 0) {
+        LogPrintf("Block input prefetching uses %d additional threads\n", opts.prefetch_threads_num);
+    }
+
+    opts.block_lookahead = static_cast<int>(std::clamp<int64_t>(args.GetIntArg("-blocklookahead", DEFAULT_BLOCK_LOOKAHEAD), 0, MAX_BLOCK_LOOKAHEAD));
+    if (opts.block_lookahead > 0) {
+        LogPrintf("Preparing up to %d blocks ahead of the one being connected\n", opts.block_lookahead);
+    }
+
+    opts.script_check_window = static_cast<int>(std::clamp<int64_t>(args.GetIntArg("-scriptcheckwindow", DEFAULT_SCRIPT_CHECK_WINDOW), 1, MAX_SCRIPT_CHECK_WINDOW));
+    if (opts.script_check_window > 1 && opts.worker_threads_num > 0) {
+        LogPrintf("Script checks of up to %d blocks may run concurrently\n", opts.script_check_window);
+    }
+
     return {};
 }
 } // namespace node
@@ -14,6 +14,18 @@ class ArgsManager;
 static constexpr int MAX_SCRIPTCHECK_THREADS{15};
 /** -par default (number of script-checking threads, 0 = auto) */
 static constexpr int DEFAULT_SCRIPTCHECK_THREADS{0};
+/** Maximum number of threads prefetching block inputs allowed */
+static constexpr int MAX_PREFETCH_THREADS{16};
+/** -prefetchthreads default (number of threads prefetching block inputs, 0 = disabled) */
+static constexpr int DEFAULT_PREFETCH_THREADS{0};
+/** Maximum number of blocks prepared ahead of the one being connected allowed */
+static constexpr int MAX_BLOCK_LOOKAHEAD{31};
+/** -blocklookahead default (number of blocks prepared ahead of the one being connected, 0 = disabled) */
+static constexpr int DEFAULT_BLOCK_LOOKAHEAD{0};
+/** Maximum number of blocks whose script checks may run concurrently allowed */
+static constexpr int MAX_SCRIPT_CHECK_WINDOW{32};
+/** -scriptcheckwindow default (number of blocks whose script checks may run concurrently, 1 = disabled) */
+static constexpr int DEFAULT_SCRIPT_CHECK_WINDOW{1};
 
 namespace node {
 [[nodiscard]] util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManager::Options& opts);
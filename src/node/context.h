@@ -35,6 +35,8 @@ class WalletLoader;
 
 namespace node {
 class KernelNotifications;
+class SerializedBlockCache;
+class BlockTemplateBuilder;
 
 //! NodeContext struct containing references to chain state and connection
 //! state.
@@ -58,7 +60,11 @@ struct NodeContext {
     std::unique_ptr<CTxMemPool> mempool;
     std::unique_ptr<const NetGroupManager> netgroupman;
     std::unique_ptr<CBlockPolicyEstimator> fee_estimator;
+    //! Serialized blocks recently served to peers and REST clients
+    std::unique_ptr<SerializedBlockCache> block_cache;
     std::unique_ptr<PeerManager> peerman;
+    //! Block template kept up to date with the mempool for getblocktemplate, if enabled
+    std::unique_ptr<BlockTemplateBuilder> template_builder;
     std::unique_ptr<ChainstateManager> chainman;
     std::unique_ptr<BanMan> banman;
     ArgsManager* args{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
@@ -0,0 +1,331 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/template_builder.h>
+
+#include <chain.h>
+#include <consensus/consensus.h>
+#include <consensus/merkle.h>
+#include <consensus/tx_verify.h>
+#include <consensus/validation.h>
+#include <logging.h>
+#include <script/script.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <algorithm>
+
+namespace node {
+BlockTemplateBuilder::BlockTemplateBuilder(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options)
+    : m_chainman{chainman}, m_mempool{mempool}, m_options{options}
+{
+}
+
+void BlockTemplateBuilder::AddLeaf(const Txid& txid, const Entry& entry)
+{
+    m_leaves.emplace(CFeeRate{entry.modified_fee, uint32_t(entry.vsize)}, txid);
+}
+
+void BlockTemplateBuilder::RemoveLeaf(const Txid& txid, const Entry& entry)
+{
+    m_leaves.erase({CFeeRate{entry.modified_fee, uint32_t(entry.vsize)}, txid});
+}
+
+void BlockTemplateBuilder::MarkDirty()
+{
+    m_dirty = true;
+    m_base_sequence = ++m_sequence;
+    m_deltas.clear();
+    m_cv.notify_all();
+}
+
+void BlockTemplateBuilder::Rebuild()
+{
+    AssertLockHeld(::cs_main);
+    const auto time_start{SteadyClock::now()};
+
+    // The coinbase is replaced by the miner, see getblocktemplate.
+    m_template = BlockAssembler{m_chainman.ActiveChainstate(), &m_mempool, m_options}.CreateNewBlock(CScript() << OP_TRUE);
+    m_prev = Assert(m_chainman.m_blockman.LookupBlockIndex(m_template->block.hashPrevBlock));
+    m_height = m_prev->nHeight + 1;
+    m_lock_time_cutoff = m_prev->GetMedianTimePast();
+    m_built = NodeClock::now();
+
+    m_entries.clear();
+    m_leaves.clear();
+    // Same reservations for the coinbase as BlockAssembler
+    m_block_weight = 4000;
+    m_block_sigops = 400;
+    m_fees = 0;
+    {
+        LOCK(m_mempool.cs);
+        const auto& vtx{m_template->block.vtx};
+        for (size_t i{1}; i < vtx.size(); ++i) {
+            const CTransaction& tx{*vtx[i]};
+            Entry entry{
+                .modified_fee = m_template->vTxFees[i],
+                .vsize = int32_t(GetVirtualTransactionSize(tx)),
+                .weight = GetTransactionWeight(tx),
+                .sigops = m_template->vTxSigOpsCost[i],
+            };
+            // Selection was done by modified fee, so evict by it as well
+            if (const auto it{m_mempool.GetIter(tx.GetHash())}) {
+                entry.modified_fee = (*it)->GetModifiedFee();
+                entry.vsize = (*it)->GetTxSize();
+            }
+            for (const CTxIn& txin : tx.vin) {
+                if (const auto parent{m_entries.find(txin.prevout.hash)}; parent != m_entries.end()) {
+                    ++parent->second.children;
+                }
+            }
+            m_block_weight += entry.weight;
+            m_block_sigops += entry.sigops;
+            m_fees += m_template->vTxFees[i];
+            m_entries.emplace(tx.GetHash(), entry);
+        }
+    }
+    for (const auto& [txid, entry] : m_entries) {
+        if (entry.children == 0) AddLeaf(txid, entry);
+    }
+
+    m_dirty = false;
+    m_base_sequence = ++m_sequence;
+    m_deltas.clear();
+    m_cv.notify_all();
+
+    LogPrint(BCLog::BENCH, "BlockTemplateBuilder: rebuilt template with %u txs in %.2fms\n",
+             m_entries.size(), Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+}
+
+bool BlockTemplateBuilder::NeedsRebuild() const
+{
+    AssertLockHeld(::cs_main);
+    return m_dirty || m_prev != m_chainman.ActiveChain().Tip() || NodeClock::now() - m_built > MAX_TEMPLATE_AGE;
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateBuilder::GetTemplate(uint64_t& sequence)
+{
+    AssertLockHeld(::cs_main);
+    LOCK(m_mutex);
+    if (NeedsRebuild()) Rebuild();
+    sequence = m_sequence;
+    return std::make_unique<CBlockTemplate>(*m_template);
+}
+
+std::optional<std::pair<BlockTemplateBuilder::Delta, std::unique_ptr<CBlockTemplate>>> BlockTemplateBuilder::GetDelta(uint64_t sequence, uint64_t& current_sequence)
+{
+    AssertLockHeld(::cs_main);
+    LOCK(m_mutex);
+    current_sequence = m_sequence;
+    // The builder learns about new blocks asynchronously, so check the tip here
+    // as well. GetTemplate will rebuild in all of these cases.
+    if (NeedsRebuild() || sequence < m_base_sequence || sequence > m_sequence) return std::nullopt;
+
+    // Squash the changes. A transaction that was added and removed again is
+    // left out, one that was removed and added again shows up in both lists.
+    std::vector<Txid> removed;
+    std::vector<Txid> added;
+    for (const auto& [change_sequence, change] : m_deltas) {
+        if (change_sequence <= sequence) continue;
+        for (const Txid& txid : change.removed) {
+            if (const auto it{std::find(added.begin(), added.end(), txid)}; it != added.end()) {
+                added.erase(it);
+            } else {
+                removed.push_back(txid);
+            }
+        }
+        added.insert(added.end(), change.added.begin(), change.added.end());
+    }
+
+    Delta delta{.removed = std::move(removed)};
+    // Additions are appended, so they are at the end of the template in the
+    // order they were made.
+    const auto& vtx{m_template->block.vtx};
+    delta.added.reserve(added.size());
+    for (size_t i{vtx.size() - added.size()}; i < vtx.size(); ++i) {
+        Assume(vtx[i]->GetHash() == added[i - (vtx.size() - added.size())]);
+        delta.added.push_back(i);
+    }
+    return std::make_pair(std::move(delta), std::make_unique<CBlockTemplate>(*m_template));
+}
+
+uint64_t BlockTemplateBuilder::WaitForChange(uint64_t sequence, std::chrono::milliseconds timeout)
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait_for(lock, timeout, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_sequence != sequence; });
+    return m_sequence;
+}
+
+void BlockTemplateBuilder::Invalidate()
+{
+    LOCK(m_mutex);
+    MarkDirty();
+}
+
+void BlockTemplateBuilder::Append(const CTransactionRef& tx, CAmount fee, const Entry& entry)
+{
+    for (const CTxIn& txin : tx->vin) {
+        if (const auto parent{m_entries.find(txin.prevout.hash)}; parent != m_entries.end()) {
+            if (parent->second.children++ == 0) RemoveLeaf(parent->first, parent->second);
+        }
+    }
+    m_template->block.vtx.push_back(tx);
+    m_template->vTxFees.push_back(fee);
+    m_template->vTxSigOpsCost.push_back(entry.sigops);
+    m_block_weight += entry.weight;
+    m_block_sigops += entry.sigops;
+    m_fees += fee;
+    m_entries.emplace(tx->GetHash(), entry);
+    AddLeaf(tx->GetHash(), entry);
+}
+
+std::vector<Txid> BlockTemplateBuilder::Remove(std::set<Txid> txids)
+{
+    std::vector<Txid> removed;
+    auto& vtx{m_template->block.vtx};
+    size_t out{1};
+    for (size_t i{1}; i < vtx.size(); ++i) {
+        const CTransaction& tx{*vtx[i]};
+        bool remove{txids.count(tx.GetHash()) > 0};
+        // Descendants come after their ancestors, so this finds all of them
+        for (size_t j{0}; !remove && j < tx.vin.size(); ++j) {
+            remove = txids.count(tx.vin[j].prevout.hash) > 0;
+        }
+        if (!remove) {
+            if (out != i) {
+                vtx[out] = std::move(vtx[i]);
+                m_template->vTxFees[out] = m_template->vTxFees[i];
+                m_template->vTxSigOpsCost[out] = m_template->vTxSigOpsCost[i];
+            }
+            ++out;
+            continue;
+        }
+        txids.insert(tx.GetHash());
+        removed.push_back(tx.GetHash());
+
+        const auto it{m_entries.find(tx.GetHash())};
+        const Entry& entry{it->second};
+        if (entry.children == 0) RemoveLeaf(it->first, entry);
+        for (const CTxIn& txin : tx.vin) {
+            if (const auto parent{m_entries.find(txin.prevout.hash)}; parent != m_entries.end()) {
+                if (--parent->second.children == 0) AddLeaf(parent->first, parent->second);
+            }
+        }
+        m_block_weight -= entry.weight;
+        m_block_sigops -= entry.sigops;
+        m_fees -= m_template->vTxFees[i];
+        m_entries.erase(it);
+    }
+    vtx.resize(out);
+    m_template->vTxFees.resize(out);
+    m_template->vTxSigOpsCost.resize(out);
+    return removed;
+}
+
+void BlockTemplateBuilder::UpdateCoinbase()
+{
+    CBlock& block{m_template->block};
+    CMutableTransaction coinbase{*block.vtx[0]};
+    coinbase.vout[0].nValue = m_fees + GetBlockSubsidy(m_height, m_chainman.GetConsensus());
+    // Drop the old witness commitment so that a new one is generated
+    if (const int commitpos{GetWitnessCommitmentIndex(block)}; commitpos != NO_WITNESS_COMMITMENT) {
+        coinbase.vout.erase(coinbase.vout.begin() + commitpos);
+    }
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    m_template->vchCoinbaseCommitment = m_chainman.GenerateCoinbaseCommitment(block, m_prev);
+    m_template->vTxFees[0] = -m_fees;
+
+    BlockAssembler::m_last_block_num_txs = block.vtx.size() - 1;
+    BlockAssembler::m_last_block_weight = m_block_weight;
+}
+
+void BlockTemplateBuilder::Commit(Change change)
+{
+    UpdateCoinbase();
+    m_deltas.emplace_back(++m_sequence, std::move(change));
+    if (m_deltas.size() > MAX_TEMPLATE_DELTAS) {
+        m_base_sequence = m_deltas.front().first;
+        m_deltas.pop_front();
+    }
+    m_cv.notify_all();
+}
+
+void BlockTemplateBuilder::TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t mempool_sequence)
+{
+    LOCK(m_mutex);
+    const Txid& txid{tx.info.m_tx->GetHash()};
+    if (m_dirty || m_entries.count(txid)) return;
+
+    LOCK(m_mempool.cs);
+    // The notification is asynchronous, the transaction may be gone already
+    const auto it{m_mempool.GetIter(txid)};
+    if (!it) return;
+
+    // The package consists of the transaction and its ancestors that are not in the template yet
+    auto ancestors{m_mempool.AssumeCalculateMemPoolAncestors(__func__, **it, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
+    std::vector<CTxMemPool::txiter> package{*it};
+    for (const CTxMemPool::txiter& ancestor : ancestors) {
+        if (!m_entries.count(ancestor->GetTx().GetHash())) package.push_back(ancestor);
+    }
+    CAmount package_fee{0};
+    int64_t package_vsize{0};
+    int64_t package_sigops{0};
+    for (const CTxMemPool::txiter& entry : package) {
+        if (!IsFinalTx(entry->GetTx(), m_height, m_lock_time_cutoff)) return;
+        package_fee += entry->GetModifiedFee();
+        package_vsize += entry->GetTxSize();
+        package_sigops += entry->GetSigOpCost();
+    }
+    if (package_fee < m_options.blockMinFeeRate.GetFee(package_vsize)) return;
+    const CFeeRate package_feerate{package_fee, uint32_t(package_vsize)};
+
+    // Same limits as BlockAssembler::TestPackage, which also accounts in vsize
+    const auto fits{[&](uint64_t freed_weight, int64_t freed_sigops) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_block_weight - freed_weight + WITNESS_SCALE_FACTOR * package_vsize < m_options.nBlockMaxWeight &&
+               m_block_sigops - freed_sigops + package_sigops < MAX_BLOCK_SIGOPS_COST;
+    }};
+    std::set<Txid> evict;
+    uint64_t freed_weight{0};
+    int64_t freed_sigops{0};
+    for (auto leaf{m_leaves.begin()}; !fits(freed_weight, freed_sigops); ++leaf) {
+        // Only evict transactions paying less than the package, that it does not depend on
+        if (leaf == m_leaves.end() || !(leaf->first < package_feerate)) return;
+        if (const auto leaf_it{m_mempool.GetIter(leaf->second)}; leaf_it && ancestors.count(*leaf_it)) continue;
+        const Entry& entry{m_entries.at(leaf->second)};
+        freed_weight += entry.weight;
+        freed_sigops += entry.sigops;
+        evict.insert(leaf->second);
+    }
+
+    Change change;
+    if (!evict.empty()) change.removed = Remove(std::move(evict));
+    // Parents have fewer ancestors than their children, so this is a valid order
+    std::sort(package.begin(), package.end(), CompareTxIterByAncestorCount());
+    for (const CTxMemPool::txiter& entry : package) {
+        Append(entry->GetSharedTx(), entry->GetFee(), Entry{
+            .modified_fee = entry->GetModifiedFee(),
+            .vsize = entry->GetTxSize(),
+            .weight = entry->GetTxWeight(),
+            .sigops = entry->GetSigOpCost(),
+        });
+        change.added.push_back(entry->GetTx().GetHash());
+    }
+    Commit(std::move(change));
+}
+
+void BlockTemplateBuilder::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    LOCK(m_mutex);
+    if (m_dirty || !m_entries.count(tx->GetHash())) return;
+    // A transaction that is no longer in the mempool may conflict with the
+    // ones that are, so the template is only consistent without it.
+    Commit(Change{.removed = Remove({tx->GetHash()})});
+}
+
+void BlockTemplateBuilder::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    LOCK(m_mutex);
+    MarkDirty();
+}
+} // namespace node
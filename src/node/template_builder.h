@@ -0,0 +1,162 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_TEMPLATE_BUILDER_H
+#define BITCOIN_NODE_TEMPLATE_BUILDER_H
+
+#include <consensus/amount.h>
+#include <kernel/cs_main.h>
+#include <node/miner.h>
+#include <policy/feerate.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <util/hasher.h>
+#include <util/time.h>
+#include <validationinterface.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CBlockIndex;
+class ChainstateManager;
+class CTxMemPool;
+
+namespace node {
+/** Default for -incrementaltemplates */
+static constexpr bool DEFAULT_INCREMENTAL_TEMPLATES{false};
+
+/** Rebuild the template from scratch at least this often, to undo the drift of
+ * incremental updates from what the full package selection would choose. */
+static constexpr auto MAX_TEMPLATE_AGE{std::chrono::seconds{60}};
+/** Number of incremental updates for which deltas are kept */
+static constexpr size_t MAX_TEMPLATE_DELTAS{1000};
+
+/**
+ * Keeps a block template up to date with the mempool, so that getblocktemplate
+ * does not have to run the full package selection of BlockAssembler on every
+ * call.
+ *
+ * The template is built with BlockAssembler when the tip changes, and after
+ * that it follows mempool notifications:
+ * - A new transaction is appended together with its ancestors that are not in
+ *   the template yet, if the package pays at least the minimum fee rate and
+ *   fits. If it does not fit, transactions without descendants in the template
+ *   and with a lower fee rate than the package are evicted to make room.
+ * - A transaction that leaves the mempool for any reason other than being
+ *   mined is removed from the template together with its descendants.
+ *
+ * Every change gets a new sequence number, and the changes since a given
+ * sequence number can be retrieved as a delta, so that clients can follow the
+ * template without downloading it in full each time.
+ */
+class BlockTemplateBuilder final : public CValidationInterface
+{
+public:
+    /** Changes to the template since some earlier sequence number. */
+    struct Delta {
+        //! Transactions removed from the template
+        std::vector<Txid> removed;
+        //! Indexes of the transactions appended to the template, in block order
+        std::vector<size_t> added;
+    };
+
+    BlockTemplateBuilder(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options);
+
+    /**
+     * Return a copy of the current template, rebuilding it first if the tip
+     * changed or it is too old.
+     * @param[out] sequence the sequence number of the returned template
+     */
+    std::unique_ptr<CBlockTemplate> GetTemplate(uint64_t& sequence) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /**
+     * Return the changes made to the template after sequence, along with a copy
+     * of the current template, or std::nullopt if the template was (or has to
+     * be) rebuilt since, because the tip changed or it is too old, in which case
+     * it has to be fetched in full.
+     * @param[out] current_sequence the sequence number of the current template
+     */
+    std::optional<std::pair<Delta, std::unique_ptr<CBlockTemplate>>> GetDelta(uint64_t sequence, uint64_t& current_sequence) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /** Wait until the template changes after sequence, or the timeout expires. Returns the current sequence. */
+    uint64_t WaitForChange(uint64_t sequence, std::chrono::milliseconds timeout) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Rebuild the template on the next request, e.g. after fee deltas changed. */
+    void Invalidate() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    // CValidationInterface
+    void TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /** What is needed to account for and evict a transaction in the template */
+    struct Entry {
+        CAmount modified_fee;
+        int32_t vsize;
+        int64_t weight;
+        int64_t sigops;
+        //! Number of transactions in the template spending this one
+        size_t children{0};
+    };
+
+    ChainstateManager& m_chainman;
+    const CTxMemPool& m_mempool;
+    const BlockAssembler::Options m_options;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+
+    std::unique_ptr<CBlockTemplate> m_template GUARDED_BY(m_mutex);
+    //! Whether the template has to be rebuilt before it can be used again
+    bool m_dirty GUARDED_BY(m_mutex){true};
+    const CBlockIndex* m_prev GUARDED_BY(m_mutex){nullptr};
+    int m_height GUARDED_BY(m_mutex){0};
+    int64_t m_lock_time_cutoff GUARDED_BY(m_mutex){0};
+    NodeClock::time_point m_built GUARDED_BY(m_mutex);
+
+    std::unordered_map<Txid, Entry, SaltedTxidHasher> m_entries GUARDED_BY(m_mutex);
+    //! Transactions without children in the template, the candidates for eviction, by fee rate
+    std::set<std::pair<CFeeRate, Txid>> m_leaves GUARDED_BY(m_mutex);
+    uint64_t m_block_weight GUARDED_BY(m_mutex){0};
+    int64_t m_block_sigops GUARDED_BY(m_mutex){0};
+    CAmount m_fees GUARDED_BY(m_mutex){0};
+
+    uint64_t m_sequence GUARDED_BY(m_mutex){0};
+    //! Sequence number of the last rebuild. Deltas only go back this far.
+    uint64_t m_base_sequence GUARDED_BY(m_mutex){0};
+    struct Change {
+        std::vector<Txid> removed;
+        std::vector<Txid> added;
+    };
+    //! Changes made by each incremental update since the last rebuild, with the sequence number they led to
+    std::deque<std::pair<uint64_t, Change>> m_deltas GUARDED_BY(m_mutex);
+
+    /** Whether the template is stale: invalidated, built on another tip than the active one or too old. */
+    bool NeedsRebuild() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mutex);
+    void Rebuild() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mutex);
+    void MarkDirty() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void AddLeaf(const Txid& txid, const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void RemoveLeaf(const Txid& txid, const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Account for a transaction appended to the template. */
+    void Append(const CTransactionRef& tx, CAmount fee, const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Remove the given transactions and their descendants from the template. Returns the txids removed. */
+    std::vector<Txid> Remove(std::set<Txid> txids) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Update the coinbase output value and witness commitment after the transactions changed. */
+    void UpdateCoinbase() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Record an incremental update. */
+    void Commit(Change change) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_TEMPLATE_BUILDER_H
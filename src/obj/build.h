@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "1452dc2b623c-dirty"
@@ -20,6 +20,7 @@
 #include <uint256.h>
 #include <util/fs.h>
 #include <util/serfloat.h>
+#include <util/thread.h>
 #include <util/time.h>
 
 #include <algorithm>
@@ -29,6 +30,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <optional>
 #include <stdexcept>
 #include <utility>
 
@@ -110,8 +112,24 @@ private:
     // transactions still unconfirmed after GetMaxConfirms for each bucket
     std::vector<int> oldUnconfTxs;
 
+    // For each bucket X, the number of transactions in the mempool that have
+    // been unconfirmed for Y blocks or more, as counted by EstimateMedianVal.
+    // Summed from unconfTxs and oldUnconfTxs when first needed after they change.
+    mutable std::vector<std::vector<int>> m_unconf_since; // m_unconf_since[Y][X]
+    // Block height m_unconf_since was summed at, unset if it is out of date
+    mutable std::optional<unsigned int> m_unconf_since_height;
+
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Return m_unconf_since[confTarget] at nBlockHeight, summing it again if needed */
+    const std::vector<int>& UnconfirmedSince(unsigned int confTarget, unsigned int nBlockHeight) const;
+
+    /**
+     * Add delta to the m_unconf_since sums that include unconfTxs[blockIndex][bucketindex],
+     * or oldUnconfTxs[bucketindex] if blockIndex is unset, if they were summed at nBlockHeight.
+     */
+    void UpdateUnconfirmedSince(unsigned int nBlockHeight, std::optional<unsigned int> blockIndex, unsigned int bucketindex, int delta);
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -123,6 +141,9 @@ public:
     TxConfirmStats(const std::vector<double>& defaultBuckets, const std::map<double, unsigned int>& defaultBucketMap,
                    unsigned int maxPeriods, double decay, unsigned int scale);
 
+    /** Copy the data of other, which refers to the same buckets as bucketsCopy and bucketMapCopy */
+    TxConfirmStats(const TxConfirmStats& other, const std::vector<double>& bucketsCopy, const std::map<double, unsigned int>& bucketMapCopy);
+
     /** Roll the circular buffer for unconfirmed txs*/
     void ClearCurrent(unsigned int nBlockHeight);
 
@@ -191,6 +212,16 @@ TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
     resizeInMemoryCounters(buckets.size());
 }
 
+TxConfirmStats::TxConfirmStats(const TxConfirmStats& other, const std::vector<double>& bucketsCopy,
+                               const std::map<double, unsigned int>& bucketMapCopy)
+    : buckets(bucketsCopy), bucketMap(bucketMapCopy), txCtAvg(other.txCtAvg), confAvg(other.confAvg),
+      failAvg(other.failAvg), m_feerate_avg(other.m_feerate_avg), decay(other.decay), scale(other.scale),
+      unconfTxs(other.unconfTxs), oldUnconfTxs(other.oldUnconfTxs), m_unconf_since(other.m_unconf_since),
+      m_unconf_since_height(other.m_unconf_since_height)
+{
+    assert(buckets == other.buckets && bucketMap == other.bucketMap);
+}
+
 void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
     // newbuckets must be passed in because the buckets referred to during Read have not been updated yet.
     unconfTxs.resize(GetMaxConfirms());
@@ -198,6 +229,40 @@ void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
         unconfTxs[i].resize(newbuckets);
     }
     oldUnconfTxs.resize(newbuckets);
+    m_unconf_since_height.reset();
+}
+
+const std::vector<int>& TxConfirmStats::UnconfirmedSince(unsigned int confTarget, unsigned int nBlockHeight) const
+{
+    const unsigned int bins = unconfTxs.size();
+    if (m_unconf_since_height != nBlockHeight) {
+        m_unconf_since.resize(GetMaxConfirms() + 1);
+        m_unconf_since[GetMaxConfirms()] = oldUnconfTxs;
+        for (unsigned int confct = GetMaxConfirms(); confct-- > 0;) {
+            m_unconf_since[confct] = m_unconf_since[confct + 1];
+            for (unsigned int bucket = 0; bucket < oldUnconfTxs.size(); bucket++) {
+                m_unconf_since[confct][bucket] += unconfTxs[(nBlockHeight - confct) % bins][bucket];
+            }
+        }
+        m_unconf_since_height = nBlockHeight;
+    }
+    return m_unconf_since[std::min(confTarget, GetMaxConfirms())];
+}
+
+void TxConfirmStats::UpdateUnconfirmedSince(unsigned int nBlockHeight, std::optional<unsigned int> blockIndex, unsigned int bucketindex, int delta)
+{
+    if (m_unconf_since_height != nBlockHeight) {
+        m_unconf_since_height.reset();
+        return;
+    }
+    const unsigned int bins = unconfTxs.size();
+    // m_unconf_since[Y] sums the slots of unconfTxs for all confct >= Y, like UnconfirmedSince()
+    int change = blockIndex ? 0 : delta;
+    m_unconf_since[GetMaxConfirms()][bucketindex] += change;
+    for (unsigned int confct = GetMaxConfirms(); confct-- > 0;) {
+        if (blockIndex && (nBlockHeight - confct) % bins == *blockIndex) change += delta;
+        m_unconf_since[confct][bucketindex] += change;
+    }
 }
 
 // Roll the unconfirmed txs circular buffer
@@ -207,6 +272,7 @@ void TxConfirmStats::ClearCurrent(unsigned int nBlockHeight)
         oldUnconfTxs[j] += unconfTxs[nBlockHeight % unconfTxs.size()][j];
         unconfTxs[nBlockHeight%unconfTxs.size()][j] = 0;
     }
+    m_unconf_since_height.reset();
 }
 
 
@@ -266,7 +332,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     double partialNum = 0;
 
     bool foundAnswer = false;
-    unsigned int bins = unconfTxs.size();
+    const std::vector<int>& unconfSince = UnconfirmedSince(confTarget, nBlockHeight);
     bool newBucketRange = true;
     bool passing = true;
     EstimatorBucket passBucket;
@@ -283,9 +349,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
         partialNum += txCtAvg[bucket];
         totalNum += txCtAvg[bucket];
         failNum += failAvg[periodTarget - 1][bucket];
-        for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
-            extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
-        extraNum += oldUnconfTxs[bucket];
+        extraNum += unconfSince[bucket];
         // If we have enough transaction data points in this range of buckets,
         // we can test for success
         // (Only count the confirmed data points, so that each confirmation count
@@ -475,6 +539,7 @@ unsigned int TxConfirmStats::NewTx(unsigned int nBlockHeight, double val)
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
     unsigned int blockIndex = nBlockHeight % unconfTxs.size();
     unconfTxs[blockIndex][bucketindex]++;
+    UpdateUnconfirmedSince(nBlockHeight, blockIndex, bucketindex, 1);
     return bucketindex;
 }
 
@@ -492,6 +557,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
     if (blocksAgo >= (int)unconfTxs.size()) {
         if (oldUnconfTxs[bucketindex] > 0) {
             oldUnconfTxs[bucketindex]--;
+            UpdateUnconfirmedSince(nBestSeenHeight, std::nullopt, bucketindex, -1);
         } else {
             LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy error, mempool tx removed from >25 blocks,bucketIndex=%u already\n",
                      bucketindex);
@@ -501,6 +567,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         unsigned int blockIndex = entryHeight % unconfTxs.size();
         if (unconfTxs[blockIndex][bucketindex] > 0) {
             unconfTxs[blockIndex][bucketindex]--;
+            UpdateUnconfirmedSince(nBestSeenHeight, blockIndex, bucketindex, -1);
         } else {
             LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy error, mempool tx removed from blockIndex=%u,bucketIndex=%u already\n",
                      blockIndex, bucketindex);
@@ -524,12 +591,12 @@ bool CBlockPolicyEstimator::removeTx(uint256 hash)
 bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
 {
     AssertLockHeld(m_cs_fee_estimator);
-    std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
+    auto pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
-        mapMemPoolTxs.erase(hash);
+        mapMemPoolTxs.erase(pos);
         return true;
     } else {
         return false;
@@ -572,7 +639,61 @@ CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath
     }
 }
 
-CBlockPolicyEstimator::~CBlockPolicyEstimator() = default;
+CBlockPolicyEstimator::~CBlockPolicyEstimator()
+{
+    WITH_LOCK(m_cs_fee_estimator, m_stop = true);
+    m_stats_cv.notify_all();
+    if (m_estimates_thread.joinable()) m_estimates_thread.join();
+}
+
+void CBlockPolicyEstimator::StartEstimatesThread()
+{
+    assert(!m_estimates_thread.joinable());
+    m_estimates_thread = std::thread(&util::TraceThread, "feeest", [this] { EstimatesThread(); });
+}
+
+CBlockPolicyEstimator::EstimationStats CBlockPolicyEstimator::LiveStats() const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+    return {*feeStats, *shortStats, *longStats, nBestSeenHeight};
+}
+
+void CBlockPolicyEstimator::EstimatesThread()
+{
+    WAIT_LOCK(m_cs_fee_estimator, lock);
+    while (true) {
+        m_stats_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator) { return m_stop || m_computed_version != m_stats_version; });
+        if (m_stop) return;
+
+        auto estimates{std::make_shared<FeeEstimates>()};
+        estimates->version = m_stats_version;
+        estimates->max_target = longStats->GetMaxConfirms();
+        estimates->max_usable = MaxUsableEstimate();
+        // Copy the stats, so that blocks and transactions can be processed
+        // while the estimates are computed from the copy.
+        const std::vector<double> buckets_copy{buckets};
+        const std::map<double, unsigned int> bucket_map_copy{bucketMap};
+        const TxConfirmStats fee_stats{*feeStats, buckets_copy, bucket_map_copy};
+        const TxConfirmStats short_stats{*shortStats, buckets_copy, bucket_map_copy};
+        const TxConfirmStats long_stats{*longStats, buckets_copy, bucket_map_copy};
+        const EstimationStats stats{fee_stats, short_stats, long_stats, nBestSeenHeight};
+        {
+            REVERSE_LOCK(lock);
+            for (const bool conservative : {false, true}) {
+                auto& results{estimates->results[conservative]};
+                for (unsigned int confTarget = 2; confTarget <= estimates->max_usable; confTarget++) {
+                    FeeCalculation feeCalc;
+                    const CFeeRate feeRate{EstimateSmartFeeAtTarget(stats, confTarget, &feeCalc, conservative)};
+                    results.emplace_back(feeRate, feeCalc);
+                }
+            }
+        }
+        // If the stats changed in the meantime, estimateSmartFee() skips these
+        // for the version they were computed at, and they are computed again.
+        m_computed_version = estimates->version;
+        WITH_LOCK(m_estimates_mutex, m_estimates = std::move(estimates));
+    }
+}
 
 void CBlockPolicyEstimator::TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t /*unused*/)
 {
@@ -594,7 +715,7 @@ void CBlockPolicyEstimator::processTransaction(const NewMempoolTransactionInfo&
     LOCK(m_cs_fee_estimator);
     const unsigned int txHeight = tx.info.txHeight;
     const auto& hash = tx.info.m_tx->GetHash();
-    if (mapMemPoolTxs.count(hash)) {
+    if (mapMemPoolTxs.contains(hash)) {
         LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy error mempool tx %s already being tracked\n",
                  hash.ToString());
         return;
@@ -625,9 +746,10 @@ void CBlockPolicyEstimator::processTransaction(const NewMempoolTransactionInfo&
     // Feerates are stored and reported as BTC-per-kb:
     const CFeeRate feeRate(tx.info.m_fee, tx.info.m_virtual_transaction_size);
 
-    mapMemPoolTxs[hash].blockHeight = txHeight;
+    TxStatsInfo& stats_info = mapMemPoolTxs[hash];
+    stats_info.blockHeight = txHeight;
     unsigned int bucketIndex = feeStats->NewTx(txHeight, static_cast<double>(feeRate.GetFeePerK()));
-    mapMemPoolTxs[hash].bucketIndex = bucketIndex;
+    stats_info.bucketIndex = bucketIndex;
     unsigned int bucketIndex2 = shortStats->NewTx(txHeight, static_cast<double>(feeRate.GetFeePerK()));
     assert(bucketIndex == bucketIndex2);
     unsigned int bucketIndex3 = longStats->NewTx(txHeight, static_cast<double>(feeRate.GetFeePerK()));
@@ -709,6 +831,9 @@ void CBlockPolicyEstimator::processBlock(const std::vector<RemovedMempoolTransac
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    ++m_stats_version;
+    m_stats_cv.notify_all();
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -801,32 +926,32 @@ unsigned int CBlockPolicyEstimator::MaxUsableEstimate() const
  * time horizon which tracks confirmations up to the desired target.  If
  * checkShorterHorizon is requested, also allow short time horizon estimates
  * for a lower target to reduce the given answer */
-double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateCombinedFee(const EstimationStats& stats, unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result)
 {
     double estimate = -1;
-    if (confTarget >= 1 && confTarget <= longStats->GetMaxConfirms()) {
+    if (confTarget >= 1 && confTarget <= stats.long_stats.GetMaxConfirms()) {
         // Find estimate from shortest time horizon possible
-        if (confTarget <= shortStats->GetMaxConfirms()) { // short horizon
-            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result);
+        if (confTarget <= stats.short_stats.GetMaxConfirms()) { // short horizon
+            estimate = stats.short_stats.EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, stats.best_seen_height, result);
         }
-        else if (confTarget <= feeStats->GetMaxConfirms()) { // medium horizon
-            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+        else if (confTarget <= stats.fee_stats.GetMaxConfirms()) { // medium horizon
+            estimate = stats.fee_stats.EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, stats.best_seen_height, result);
         }
         else { // long horizon
-            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = stats.long_stats.EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, stats.best_seen_height, result);
         }
         if (checkShorterHorizon) {
             EstimationResult tempResult;
             // If a lower confTarget from a more recent horizon returns a lower answer use it.
-            if (confTarget > feeStats->GetMaxConfirms()) {
-                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult);
+            if (confTarget > stats.fee_stats.GetMaxConfirms()) {
+                double medMax = stats.fee_stats.EstimateMedianVal(stats.fee_stats.GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, stats.best_seen_height, &tempResult);
                 if (medMax > 0 && (estimate == -1 || medMax < estimate)) {
                     estimate = medMax;
                     if (result) *result = tempResult;
                 }
             }
-            if (confTarget > shortStats->GetMaxConfirms()) {
-                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult);
+            if (confTarget > stats.short_stats.GetMaxConfirms()) {
+                double shortMax = stats.short_stats.EstimateMedianVal(stats.short_stats.GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, stats.best_seen_height, &tempResult);
                 if (shortMax > 0 && (estimate == -1 || shortMax < estimate)) {
                     estimate = shortMax;
                     if (result) *result = tempResult;
@@ -840,15 +965,15 @@ double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, doubl
 /** Ensure that for a conservative estimate, the DOUBLE_SUCCESS_PCT is also met
  * at 2 * target for any longer time horizons.
  */
-double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateConservativeFee(const EstimationStats& stats, unsigned int doubleTarget, EstimationResult *result)
 {
     double estimate = -1;
     EstimationResult tempResult;
-    if (doubleTarget <= shortStats->GetMaxConfirms()) {
-        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result);
+    if (doubleTarget <= stats.short_stats.GetMaxConfirms()) {
+        estimate = stats.fee_stats.EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, stats.best_seen_height, result);
     }
-    if (doubleTarget <= feeStats->GetMaxConfirms()) {
-        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult);
+    if (doubleTarget <= stats.fee_stats.GetMaxConfirms()) {
+        double longEstimate = stats.long_stats.EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, stats.best_seen_height, &tempResult);
         if (longEstimate > estimate) {
             estimate = longEstimate;
             if (result) *result = tempResult;
@@ -857,42 +982,66 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
     return estimate;
 }
 
-/** estimateSmartFee returns the max of the feerates calculated with a 60%
- * threshold required at target / 2, an 85% threshold required at target and a
- * 95% threshold required at 2 * target.  Each calculation is performed at the
- * shortest time horizon which tracks the required target.  Conservative
- * estimates, however, required the 95% threshold at 2 * target be met for any
- * longer time horizons also.
- */
-CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+/** Return the target estimateSmartFee() answers for when asked for confTarget, or 0 if it can't */
+static unsigned int SmartFeeTarget(int confTarget, unsigned int maxTarget, unsigned int maxUsableEstimate, FeeCalculation* feeCalc)
 {
-    LOCK(m_cs_fee_estimator);
-
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
     }
 
-    double median = -1;
-    EstimationResult tempResult;
-
     // Return failure if trying to analyze a target we're not tracking
-    if (confTarget <= 0 || (unsigned int)confTarget > longStats->GetMaxConfirms()) {
-        return CFeeRate(0);  // error condition
+    if (confTarget <= 0 || (unsigned int)confTarget > maxTarget) {
+        return 0;
     }
 
     // It's not possible to get reasonable estimates for confTarget of 1
     if (confTarget == 1) confTarget = 2;
 
-    unsigned int maxUsableEstimate = MaxUsableEstimate();
     if ((unsigned int)confTarget > maxUsableEstimate) {
         confTarget = maxUsableEstimate;
     }
     if (feeCalc) feeCalc->returnedTarget = confTarget;
 
-    if (confTarget <= 1) return CFeeRate(0); // error condition
+    if (confTarget <= 1) return 0;
+
+    return confTarget;
+}
+
+/** estimateSmartFee returns the max of the feerates calculated with a 60%
+ * threshold required at target / 2, an 85% threshold required at target and a
+ * 95% threshold required at 2 * target.  Each calculation is performed at the
+ * shortest time horizon which tracks the required target.  Conservative
+ * estimates, however, required the 95% threshold at 2 * target be met for any
+ * longer time horizons also.
+ */
+CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    // Look the estimate up among those computed in the background, unless the
+    // stats changed since and it has to be computed here.
+    const auto estimates{WITH_LOCK(m_estimates_mutex, return m_estimates)};
+    if (!estimates || estimates->version != m_stats_version) {
+        LOCK(m_cs_fee_estimator);
+        const unsigned int target = SmartFeeTarget(confTarget, longStats->GetMaxConfirms(), MaxUsableEstimate(), feeCalc);
+        if (target == 0) return CFeeRate(0); // error condition
+        return EstimateSmartFeeAtTarget(LiveStats(), target, feeCalc, conservative);
+    }
+
+    const unsigned int target = SmartFeeTarget(confTarget, estimates->max_target, estimates->max_usable, feeCalc);
+    if (target == 0) return CFeeRate(0); // error condition
+    const auto& [feeRate, calc] = estimates->results[conservative][target - 2];
+    if (feeCalc) {
+        feeCalc->est = calc.est;
+        feeCalc->reason = calc.reason;
+    }
+    return feeRate;
+}
+
+CFeeRate CBlockPolicyEstimator::EstimateSmartFeeAtTarget(const EstimationStats& stats, unsigned int confTarget, FeeCalculation* feeCalc, bool conservative)
+{
+    double median = -1;
+    EstimationResult tempResult;
 
-    assert(confTarget > 0); //estimateCombinedFee and estimateConservativeFee take unsigned ints
     /** true is passed to estimateCombined fee for target/2 and target so
      * that we check the max confirms for shorter time horizons as well.
      * This is necessary to preserve monotonically increasing estimates.
@@ -903,13 +1052,13 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * the purpose of conservative estimates is not to let short term
      * fluctuations lower our estimates by too much.
      */
-    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
+    double halfEst = estimateCombinedFee(stats, confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
     if (feeCalc) {
         feeCalc->est = tempResult;
         feeCalc->reason = FeeReason::HALF_ESTIMATE;
     }
     median = halfEst;
-    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
+    double actualEst = estimateCombinedFee(stats, confTarget, SUCCESS_PCT, true, &tempResult);
     if (actualEst > median) {
         median = actualEst;
         if (feeCalc) {
@@ -917,7 +1066,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
             feeCalc->reason = FeeReason::FULL_ESTIMATE;
         }
     }
-    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
+    double doubleEst = estimateCombinedFee(stats, 2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
     if (doubleEst > median) {
         median = doubleEst;
         if (feeCalc) {
@@ -927,7 +1076,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     }
 
     if (conservative || median == -1) {
-        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
+        double consEst =  estimateConservativeFee(stats, 2 * confTarget, &tempResult);
         if (consEst > median) {
             median = consEst;
             if (feeCalc) {
@@ -1035,6 +1184,9 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+
+            ++m_stats_version;
+            m_stats_cv.notify_all();
         }
     }
     catch (const std::exception& e) {
@@ -1054,6 +1206,8 @@ void CBlockPolicyEstimator::FlushUnconfirmed()
         auto mi = mapMemPoolTxs.begin();
         _removeTx(mi->first, false); // this calls erase() on mapMemPoolTxs
     }
+    ++m_stats_version;
+    m_stats_cv.notify_all();
     const auto endclear{SteadyClock::now()};
     LogPrint(BCLog::ESTIMATEFEE, "Recorded %u unconfirmed txs from mempool in %.3fs\n", num_entries, Ticks<SecondsDouble>(endclear - startclear));
 }
@@ -12,14 +12,20 @@
 #include <threadsafety.h>
 #include <uint256.h>
 #include <util/fs.h>
+#include <util/hasher.h>
 #include <validationinterface.h>
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 
@@ -144,6 +150,10 @@ struct FeeCalculation
  *  We want to be able to estimate feerates that are needed on tx's to be included in
  * a certain number of blocks.  Every time a block is added to the best chain, this class records
  * stats on the transactions included in that block
+ *
+ * After each block, a background thread computes the smart fee estimate for
+ * every target, so estimateSmartFee() can answer without taking the estimator
+ * lock the validation interface callbacks update the stats under.
  */
 class CBlockPolicyEstimator : public CValidationInterface
 {
@@ -202,6 +212,10 @@ public:
     CBlockPolicyEstimator(const fs::path& estimation_filepath, const bool read_stale_estimates);
     virtual ~CBlockPolicyEstimator();
 
+    /** Start computing estimateSmartFee() answers in the background after every block */
+    void StartEstimatesThread()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_estimates_mutex);
+
     /** Process all the transactions that have been included in a block */
     void processBlock(const std::vector<RemovedMempoolTransactionInfo>& txs_removed_for_block,
                       unsigned int nBlockHeight)
@@ -223,6 +237,8 @@ public:
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
      *  valid over longer time horizons also.
+     *  Answers from the estimates computed after the last block, which do not
+     *  reflect mempool transactions removed since.
      */
     CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
@@ -274,6 +290,28 @@ protected:
 private:
     mutable Mutex m_cs_fee_estimator;
 
+    /** Smart fee estimates for every target, computed after a block */
+    struct FeeEstimates {
+        //! m_stats_version these were computed at
+        uint64_t version;
+        unsigned int max_target;
+        unsigned int max_usable;
+        //! Estimate and calculation by [conservative][target - 2], up to max_usable
+        std::array<std::vector<std::pair<CFeeRate, FeeCalculation>>, 2> results;
+    };
+
+    //! Bumped whenever a block or a file changes what estimateSmartFee() answers from
+    std::atomic<uint64_t> m_stats_version{1};
+    //! m_stats_version the background thread last computed estimates at
+    uint64_t m_computed_version GUARDED_BY(m_cs_fee_estimator){0};
+    bool m_stop GUARDED_BY(m_cs_fee_estimator){false};
+    std::condition_variable m_stats_cv;
+    std::thread m_estimates_thread;
+
+    //! Only held to copy or replace the pointer, never while estimating
+    mutable Mutex m_estimates_mutex;
+    std::shared_ptr<const FeeEstimates> m_estimates GUARDED_BY(m_estimates_mutex);
+
     unsigned int nBestSeenHeight GUARDED_BY(m_cs_fee_estimator){0};
     unsigned int firstRecordedHeight GUARDED_BY(m_cs_fee_estimator){0};
     unsigned int historicalFirst GUARDED_BY(m_cs_fee_estimator){0};
@@ -287,7 +325,7 @@ private:
     };
 
     // map of txids to information about that transaction
-    std::map<uint256, TxStatsInfo> mapMemPoolTxs GUARDED_BY(m_cs_fee_estimator);
+    std::unordered_map<uint256, TxStatsInfo, SaltedTxidHasher> mapMemPoolTxs GUARDED_BY(m_cs_fee_estimator);
 
     /** Classes to track historical data on transaction confirmations */
     std::unique_ptr<TxConfirmStats> feeStats PT_GUARDED_BY(m_cs_fee_estimator);
@@ -303,10 +341,23 @@ private:
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const RemovedMempoolTransactionInfo& tx) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** The stats smart fee estimates are computed from: the live ones or a copy of them */
+    struct EstimationStats {
+        const TxConfirmStats& fee_stats;
+        const TxConfirmStats& short_stats;
+        const TxConfirmStats& long_stats;
+        unsigned int best_seen_height;
+    };
+    EstimationStats LiveStats() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** Recompute m_estimates whenever m_stats_version changes, until m_stop is set */
+    void EstimatesThread() EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_estimates_mutex);
+    /** Smart fee estimate at a target already adjusted to what can be estimated */
+    static CFeeRate EstimateSmartFeeAtTarget(const EstimationStats& stats, unsigned int confTarget, FeeCalculation* feeCalc, bool conservative);
     /** Helper for estimateSmartFee */
-    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    static double estimateCombinedFee(const EstimationStats& stats, unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result);
     /** Helper for estimateSmartFee */
-    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    static double estimateConservativeFee(const EstimationStats& stats, unsigned int doubleTarget, EstimationResult *result);
     /** Number of blocks of data recorded while fee estimates have been running */
     unsigned int BlockSpan() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Number of blocks of recorded fee estimate data represented in saved data file */
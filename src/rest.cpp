@@ -17,11 +17,13 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
+#include <node/blockcache.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/json_stream.h>
 #include <rpc/mempool.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
@@ -41,6 +43,8 @@
 
 using node::GetTransaction;
 using node::NodeContext;
+using node::RawBlock;
+using node::SerializedBlockCache;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
@@ -315,16 +319,27 @@ static bool rest_block(const std::any& context,
         pos = pblockindex->GetBlockPos();
     }
 
-    std::vector<uint8_t> block_data{};
-    if (!chainman.m_blockman.ReadRawBlockFromDisk(block_data, pos)) {
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+    // Serve recently requested blocks from memory if the block cache is enabled
+    SerializedBlockCache::SerializedBlock cached_block;
+    RawBlock raw_block{};
+    Span<const uint8_t> block_data;
+    if (const NodeContext* node{util::AnyPtr<NodeContext>(context)}; node && node->block_cache) {
+        cached_block = node->block_cache->GetOrRead(chainman.m_blockman, *pblockindex, /*witness=*/true);
+        if (!cached_block) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
+        block_data = *cached_block;
+    } else {
+        if (!chainman.m_blockman.ReadRawBlockFromDisk(raw_block, pos)) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
+        block_data = raw_block.data();
     }
 
     switch (rf) {
     case RESTResponseFormat::BINARY: {
-        const std::string binaryBlock{block_data.begin(), block_data.end()};
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, MakeByteSpan(block_data));
         return true;
     }
 
@@ -337,12 +352,15 @@ static bool rest_block(const std::any& context,
 
     case RESTResponseFormat::JSON: {
         CBlock block{};
-        DataStream block_stream{block_data};
-        block_stream >> TX_WITH_WITNESS(block);
-        UniValue objBlock = blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
-        std::string strJSON = objBlock.write() + "\n";
+        SpanReader{block_data} >> TX_WITH_WITNESS(block);
+        // Stream the transactions into the reply instead of building it in memory
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->StartChunkedReply(HTTP_OK);
+        JSONStreamWriter writer{[&](std::string_view chunk) { req->WriteReplyChunk(MakeByteSpan(chunk)); }};
+        blockToJSON(writer, chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+        writer.Flush();
+        req->WriteReplyChunk(MakeByteSpan(std::string_view{"\n"}));
+        req->EndChunkedReply();
         return true;
     }
 
@@ -1006,26 +1024,27 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
+    HTTPWorkClass work_class;
 } uri_prefixes[] = {
-      {"/rest/tx/", rest_tx},
-      {"/rest/block/notxdetails/", rest_block_notxdetails},
-      {"/rest/block/", rest_block_extended},
-      {"/rest/blockfilter/", rest_block_filter},
-      {"/rest/blockfilterheaders/", rest_filter_header},
-      {"/rest/chaininfo", rest_chaininfo},
-      {"/rest/mempool/", rest_mempool},
-      {"/rest/headers/", rest_headers},
-      {"/rest/getutxos", rest_getutxos},
-      {"/rest/deploymentinfo/", rest_deploymentinfo},
-      {"/rest/deploymentinfo", rest_deploymentinfo},
-      {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/tx/", rest_tx, HTTPWorkClass::MEDIUM},
+      {"/rest/block/notxdetails/", rest_block_notxdetails, HTTPWorkClass::HEAVY},
+      {"/rest/block/", rest_block_extended, HTTPWorkClass::HEAVY},
+      {"/rest/blockfilter/", rest_block_filter, HTTPWorkClass::MEDIUM},
+      {"/rest/blockfilterheaders/", rest_filter_header, HTTPWorkClass::MEDIUM},
+      {"/rest/chaininfo", rest_chaininfo, HTTPWorkClass::MEDIUM},
+      {"/rest/mempool/", rest_mempool, HTTPWorkClass::HEAVY},
+      {"/rest/headers/", rest_headers, HTTPWorkClass::MEDIUM},
+      {"/rest/getutxos", rest_getutxos, HTTPWorkClass::MEDIUM},
+      {"/rest/deploymentinfo/", rest_deploymentinfo, HTTPWorkClass::MEDIUM},
+      {"/rest/deploymentinfo", rest_deploymentinfo, HTTPWorkClass::MEDIUM},
+      {"/rest/blockhashbyheight/", rest_blockhash_by_height, HTTPWorkClass::CHEAP},
 };
 
 void StartREST(const std::any& context)
 {
     for (const auto& up : uri_prefixes) {
         auto handler = [context, up](HTTPRequest* req, const std::string& prefix) { return up.handler(context, req, prefix); };
-        RegisterHTTPHandler(up.prefix, false, handler);
+        RegisterHTTPHandler(up.prefix, false, handler, up.work_class);
     }
 }
 
@@ -30,6 +30,7 @@
 #include <node/transaction.h>
 #include <node/utxo_snapshot.h>
 #include <primitives/transaction.h>
+#include <rpc/json_stream.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -52,6 +53,7 @@
 #include <stdint.h>
 
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -161,19 +163,24 @@ UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex
     return result;
 }
 
-UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
+/** Everything blockToJSON returns except for the transactions. */
+static UniValue BlockSummaryToJSON(const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex)
 {
     UniValue result = blockheaderToJSON(tip, blockindex);
 
     result.pushKV("strippedsize", (int)::GetSerializeSize(TX_NO_WITNESS(block)));
     result.pushKV("size", (int)::GetSerializeSize(TX_WITH_WITNESS(block)));
     result.pushKV("weight", (int)::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
+    return result;
+}
 
+/** Call fn with the JSON representation of each transaction of the block, in order. */
+static void BlockTxsToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& blockindex, TxVerbosity verbosity, const std::function<void(UniValue&&)>& fn)
+{
     switch (verbosity) {
         case TxVerbosity::SHOW_TXID:
             for (const CTransactionRef& tx : block.vtx) {
-                txs.push_back(tx->GetHash().GetHex());
+                fn(tx->GetHash().GetHex());
             }
             break;
 
@@ -189,16 +196,34 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
                 const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
                 UniValue objTx(UniValue::VOBJ);
                 TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, txundo, verbosity);
-                txs.push_back(objTx);
+                fn(std::move(objTx));
             }
             break;
     }
+}
 
-    result.pushKV("tx", txs);
+UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
+{
+    UniValue result = BlockSummaryToJSON(block, tip, blockindex);
+
+    UniValue txs(UniValue::VARR);
+    BlockTxsToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) { txs.push_back(std::move(tx)); });
+    result.pushKV("tx", std::move(txs));
 
     return result;
 }
 
+void blockToJSON(JSONStreamWriter& writer, BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
+{
+    writer.BeginObject();
+    writer.Entries(BlockSummaryToJSON(block, tip, blockindex));
+    writer.Key("tx");
+    writer.BeginArray();
+    BlockTxsToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) { writer.Value(tx); });
+    writer.EndArray();
+    writer.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -777,6 +802,11 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
+    if (request.result_stream) {
+        // Write the transactions one by one instead of building the whole result in memory
+        blockToJSON(*request.result_stream, chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+        return NullUniValue;
+    }
     return blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
 },
     };
@@ -2442,7 +2472,7 @@ static RPCHelpMan scanblocks()
         }
         UniValue blocks(UniValue::VARR);
         const int amount_per_chunk = 10000;
-        std::vector<BlockFilter> filters;
+        std::vector<std::shared_ptr<const DecodedGCSFilter>> filters;
         int start_block_height = start_index->nHeight; // for progress reporting
         const int total_blocks_to_process = stop_block->nHeight - start_block_height;
 
@@ -2465,20 +2495,23 @@ static RPCHelpMan scanblocks()
                     WITH_LOCK(::cs_main, return chainman.ActiveChain()[start_block + amount_per_chunk]) :
                     stop_block;
 
-            if (index->LookupFilterRange(start_block, end_range, filters)) {
-                for (const BlockFilter& filter : filters) {
-                    // compare the elements-set with each filter
-                    if (filter.GetFilter().MatchAny(needle_set)) {
+            if (index->LookupDecodedFilterRange(start_block, end_range, filters)) {
+                // compare the elements-set with all filters at once
+                std::vector<const DecodedGCSFilter*> decoded_filters;
+                decoded_filters.reserve(filters.size());
+                for (const auto& filter : filters) decoded_filters.push_back(filter.get());
+                const std::vector<bool> matches{DecodedGCSFilter::MatchAnyBatch(decoded_filters, needle_set)};
+                for (size_t i = 0; i < filters.size(); ++i) {
+                    if (matches[i]) {
+                        const CBlockIndex& blockindex = *CHECK_NONFATAL(end_range->GetAncestor(start_block + static_cast<int>(i)));
                         if (filter_false_positives) {
                             // Double check the filter matches by scanning the block
-                            const CBlockIndex& blockindex = *CHECK_NONFATAL(WITH_LOCK(cs_main, return chainman.m_blockman.LookupBlockIndex(filter.GetBlockHash())));
-
                             if (!CheckBlockFilterMatches(chainman.m_blockman, blockindex, needle_set)) {
                                 continue;
                             }
                         }
 
-                        blocks.push_back(filter.GetBlockHash().GetHex());
+                        blocks.push_back(blockindex.GetBlockHash().GetHex());
                     }
                 }
             }
@@ -2877,26 +2910,26 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
     static const CRPCCommand commands[]{
         {"blockchain", &getblockchaininfo},
         {"blockchain", &getchaintxstats},
-        {"blockchain", &getblockstats},
-        {"blockchain", &getbestblockhash},
-        {"blockchain", &getblockcount},
-        {"blockchain", &getblock},
+        {"blockchain", &getblockstats, RPCCost::HEAVY},
+        {"blockchain", &getbestblockhash, RPCCost::CHEAP},
+        {"blockchain", &getblockcount, RPCCost::CHEAP},
+        {"blockchain", &getblock, RPCCost::HEAVY},
         {"blockchain", &getblockfrompeer},
-        {"blockchain", &getblockhash},
-        {"blockchain", &getblockheader},
+        {"blockchain", &getblockhash, RPCCost::CHEAP},
+        {"blockchain", &getblockheader, RPCCost::CHEAP},
         {"blockchain", &getchaintips},
-        {"blockchain", &getdifficulty},
+        {"blockchain", &getdifficulty, RPCCost::CHEAP},
         {"blockchain", &getdeploymentinfo},
         {"blockchain", &gettxout},
-        {"blockchain", &gettxoutsetinfo},
+        {"blockchain", &gettxoutsetinfo, RPCCost::HEAVY},
         {"blockchain", &pruneblockchain},
-        {"blockchain", &verifychain},
+        {"blockchain", &verifychain, RPCCost::HEAVY},
         {"blockchain", &preciousblock},
-        {"blockchain", &scantxoutset},
-        {"blockchain", &scanblocks},
+        {"blockchain", &scantxoutset, RPCCost::HEAVY},
+        {"blockchain", &scanblocks, RPCCost::HEAVY},
         {"blockchain", &getblockfilter},
-        {"blockchain", &dumptxoutset},
-        {"blockchain", &loadtxoutset},
+        {"blockchain", &dumptxoutset, RPCCost::HEAVY},
+        {"blockchain", &loadtxoutset, RPCCost::HEAVY},
         {"blockchain", &getchainstates},
         {"hidden", &invalidateblock},
         {"hidden", &reconsiderblock},
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/json_stream.h>
+
+#include <univalue.h>
+#include <util/check.h>
+
+void JSONStreamWriter::Separate()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (m_empty.empty()) return;
+    if (!m_empty.back()) Append(",");
+    m_empty.back() = false;
+}
+
+void JSONStreamWriter::Append(std::string_view str)
+{
+    m_started = true;
+    m_buffer.append(str);
+    if (m_buffer.size() >= m_flush_size) Flush();
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    Separate();
+    Append("{");
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    CHECK_NONFATAL(!m_empty.empty() && !m_after_key);
+    m_empty.pop_back();
+    Append("}");
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    Separate();
+    Append("[");
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    CHECK_NONFATAL(!m_empty.empty());
+    m_empty.pop_back();
+    Append("]");
+}
+
+void JSONStreamWriter::Key(std::string_view key)
+{
+    CHECK_NONFATAL(!m_empty.empty() && !m_after_key);
+    Separate();
+    // Let UniValue take care of escaping
+    Append(UniValue{std::string{key}}.write());
+    Append(":");
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    Separate();
+    Append(value.write());
+}
+
+void JSONStreamWriter::Entries(const UniValue& obj)
+{
+    for (size_t i{0}; i < obj.size(); ++i) {
+        KV(obj.getKeys()[i], obj.getValues()[i]);
+    }
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    m_sink(m_buffer);
+    m_buffer.clear();
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSON_STREAM_H
+#define BITCOIN_RPC_JSON_STREAM_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class UniValue;
+
+/**
+ * Writes a JSON document incrementally, handing it to a sink in chunks of
+ * roughly flush_size bytes. Large results can be emitted one element at a
+ * time this way, without holding the whole document in memory, either as a
+ * UniValue tree or as a string.
+ *
+ * The output is identical to UniValue::write() of the equivalent value.
+ */
+class JSONStreamWriter
+{
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    static constexpr size_t DEFAULT_FLUSH_SIZE{64 * 1024};
+
+    explicit JSONStreamWriter(Sink sink, size_t flush_size = DEFAULT_FLUSH_SIZE)
+        : m_sink{std::move(sink)}, m_flush_size{flush_size} {}
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the key of the next value in the current object. */
+    void Key(std::string_view key);
+    /** Write a complete value, either at the top level, in an array, or after a Key(). */
+    void Value(const UniValue& value);
+    void KV(std::string_view key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    /** Write all key-value pairs of obj into the current object. */
+    void Entries(const UniValue& obj);
+
+    /** Hand everything written so far to the sink. */
+    void Flush();
+
+    /** Whether anything has been written. */
+    bool Started() const { return m_started; }
+
+private:
+    const Sink m_sink;
+    const size_t m_flush_size;
+    std::string m_buffer;
+    //! For each open object or array, whether it has no elements yet
+    std::vector<bool> m_empty;
+    bool m_after_key{false};
+    bool m_started{false};
+
+    /** Write the separator needed before the next value. */
+    void Separate();
+    void Append(std::string_view str);
+};
+
+#endif // BITCOIN_RPC_JSON_STREAM_H
@@ -14,6 +14,7 @@
 #include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/json_stream.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -371,6 +372,18 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+void MempoolToJSON(JSONStreamWriter& writer, const CTxMemPool& pool)
+{
+    LOCK(pool.cs);
+    writer.BeginObject();
+    for (const CTxMemPoolEntry& e : pool.entryAll()) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(pool, info, e);
+        writer.KV(e.GetTx().GetHash().ToString(), info);
+    }
+    writer.EndObject();
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -416,6 +429,11 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
+    if (fVerbose && !include_mempool_sequence && request.result_stream) {
+        // Write the entries one by one instead of building the whole result in memory
+        MempoolToJSON(*request.result_stream, EnsureAnyMemPool(request.context));
+        return NullUniValue;
+    }
     return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
 },
     };
@@ -1021,11 +1039,11 @@ void RegisterMempoolRPCCommands(CRPCTable& t)
         {"blockchain", &getmempooldescendants},
         {"blockchain", &getmempoolentry},
         {"blockchain", &gettxspendingprevout},
-        {"blockchain", &getmempoolinfo},
-        {"blockchain", &getrawmempool},
-        {"blockchain", &importmempool},
-        {"blockchain", &savemempool},
-        {"rawtransactions", &submitpackage},
+        {"blockchain", &getmempoolinfo, RPCCost::CHEAP},
+        {"blockchain", &getrawmempool, RPCCost::HEAVY},
+        {"blockchain", &importmempool, RPCCost::HEAVY},
+        {"blockchain", &savemempool, RPCCost::HEAVY},
+        {"rawtransactions", &submitpackage, RPCCost::HEAVY},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
@@ -22,6 +22,7 @@
 #include <net.h>
 #include <node/context.h>
 #include <node/miner.h>
+#include <node/template_builder.h>
 #include <pow.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
@@ -487,7 +488,10 @@ static RPCHelpMan prioritisetransaction()
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Priority is no longer supported, dummy argument to prioritisetransaction must be 0.");
     }
 
-    EnsureAnyMemPool(request.context).PrioritiseTransaction(hash, nAmount);
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    EnsureMemPool(node).PrioritiseTransaction(hash, nAmount);
+    // Fee deltas are not announced to validation interfaces
+    if (node.template_builder) node.template_builder->Invalidate();
     return true;
 },
     };
@@ -645,6 +649,7 @@ static RPCHelpMan getblocktemplate()
                 {RPCResult::Type::NUM, "height", "The height of the next block"},
                 {RPCResult::Type::STR_HEX, "signet_challenge", /*optional=*/true, "Only on signet"},
                 {RPCResult::Type::STR_HEX, "default_witness_commitment", /*optional=*/true, "a valid witness commitment for the unmodified block template"},
+                {RPCResult::Type::NUM, "templateid", /*optional=*/true, "Only with -incrementaltemplates. An id to pass to getblocktemplatedelta to follow the changes to this template"},
             }},
         },
         RPCExamples{
@@ -794,7 +799,13 @@ static RPCHelpMan getblocktemplate()
     static CBlockIndex* pindexPrev;
     static int64_t time_start;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != active_chain.Tip() ||
+    uint64_t template_id{0};
+    if (node.template_builder) {
+        // The builder keeps its template up to date, so there is no need to rate limit rebuilds
+        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+        pblocktemplate = node.template_builder->GetTemplate(template_id);
+        pindexPrev = chainman.m_blockman.LookupBlockIndex(pblocktemplate->block.hashPrevBlock);
+    } else if (pindexPrev != active_chain.Tip() ||
         (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - time_start > 5))
     {
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
@@ -964,6 +975,137 @@ static RPCHelpMan getblocktemplate()
         result.pushKV("default_witness_commitment", HexStr(pblocktemplate->vchCoinbaseCommitment));
     }
 
+    if (node.template_builder) {
+        result.pushKV("templateid", template_id);
+    }
+
+    return result;
+},
+    };
+}
+
+static RPCHelpMan getblocktemplatedelta()
+{
+    return RPCHelpMan{"getblocktemplatedelta",
+        "Wait for the block template to change and return the changes since an earlier template.\n"
+        "Requires -incrementaltemplates.\n"
+        "To follow the template, remove the transactions in 'removed' from the previous template,\n"
+        "keeping the order of the others, and append the ones in 'added'.\n"
+        "If 'full' is true the template was rebuilt, e.g. because of a new block, and has to be fetched with getblocktemplate.\n",
+        {
+            {"templateid", RPCArg::Type::NUM, RPCArg::Optional::NO, "The templateid of the previous template, as returned by getblocktemplate or getblocktemplatedelta"},
+            {"timeout", RPCArg::Type::NUM, RPCArg::Default{0}, "Time in milliseconds to wait for a change, 0 to return immediately"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::NUM, "templateid", "The id of the current template"},
+                {RPCResult::Type::BOOL, "full", "Whether the template has to be fetched in full. The remaining fields are omitted if so"},
+                {RPCResult::Type::ARR, "removed", /*optional=*/true, "transactions removed from the template",
+                {
+                    {RPCResult::Type::STR_HEX, "", "The transaction id"},
+                }},
+                {RPCResult::Type::ARR, "added", /*optional=*/true, "transactions appended to the template, in the format of the 'transactions' of getblocktemplate",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "data", "transaction data encoded in hexadecimal (byte-for-byte)"},
+                        {RPCResult::Type::STR_HEX, "txid", "transaction id encoded in little-endian hexadecimal"},
+                        {RPCResult::Type::STR_HEX, "hash", "hash encoded in little-endian hexadecimal (including witness data)"},
+                        {RPCResult::Type::ARR, "depends", "array of numbers",
+                        {
+                            {RPCResult::Type::NUM, "", "transactions before this one (by 1-based index in the updated 'transactions' list) that must be present in the final block if this one is"},
+                        }},
+                        {RPCResult::Type::NUM, "fee", "difference in value between transaction inputs and outputs (in satoshis)"},
+                        {RPCResult::Type::NUM, "sigops", "total SigOps cost, as counted for purposes of block limits"},
+                        {RPCResult::Type::NUM, "weight", "total transaction weight, as counted for purposes of block limits"},
+                    }},
+                }},
+                {RPCResult::Type::NUM, "coinbasevalue", /*optional=*/true, "maximum allowable input to coinbase transaction, including the generation award and transaction fees (in satoshis)"},
+                {RPCResult::Type::STR_HEX, "default_witness_commitment", /*optional=*/true, "a valid witness commitment for the updated block template"},
+            }},
+        RPCExamples{
+            HelpExampleCli("getblocktemplatedelta", "42 30000")
+            + HelpExampleRpc("getblocktemplatedelta", "42, 30000")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    if (!node.template_builder) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Incremental block templates are disabled (start with -incrementaltemplates)");
+    }
+    const uint64_t template_id{self.Arg<uint64_t>(0)};
+    const int timeout{self.Arg<int>(1)};
+    if (timeout < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "timeout cannot be negative");
+    }
+
+    // Wait in short steps to notice a shutdown
+    const auto deadline{SteadyClock::now() + std::chrono::milliseconds{timeout}};
+    uint64_t current_id{template_id};
+    while (current_id == template_id && IsRPCRunning()) {
+        const auto remaining{std::chrono::duration_cast<std::chrono::milliseconds>(deadline - SteadyClock::now())};
+        if (remaining.count() <= 0) break;
+        current_id = node.template_builder->WaitForChange(template_id, std::min(remaining, std::chrono::milliseconds{1000}));
+    }
+    if (!IsRPCRunning()) {
+        throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    LOCK(cs_main);
+    auto delta{node.template_builder->GetDelta(template_id, current_id)};
+    result.pushKV("templateid", current_id);
+    if (!delta) {
+        result.pushKV("full", true);
+        return result;
+    }
+    result.pushKV("full", false);
+
+    const auto& [changes, block_template] = *delta;
+    const std::vector<CTransactionRef>& vtx{block_template->block.vtx};
+    const CBlockIndex* tip{chainman.ActiveChain().Tip()};
+    const bool pre_segwit{!DeploymentActiveAfter(tip, chainman, Consensus::DEPLOYMENT_SEGWIT)};
+
+    UniValue removed(UniValue::VARR);
+    for (const Txid& txid : changes.removed) {
+        removed.push_back(txid.GetHex());
+    }
+
+    std::map<Txid, int64_t> tx_index;
+    for (size_t i{0}; i < vtx.size(); ++i) {
+        tx_index.emplace(vtx[i]->GetHash(), i);
+    }
+    UniValue added(UniValue::VARR);
+    for (const size_t i : changes.added) {
+        const CTransaction& tx{*vtx[i]};
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("data", EncodeHexTx(tx));
+        entry.pushKV("txid", tx.GetHash().GetHex());
+        entry.pushKV("hash", tx.GetWitnessHash().GetHex());
+        UniValue deps(UniValue::VARR);
+        for (const CTxIn& in : tx.vin) {
+            if (const auto it{tx_index.find(in.prevout.hash)}; it != tx_index.end()) deps.push_back(it->second);
+        }
+        entry.pushKV("depends", deps);
+        entry.pushKV("fee", block_template->vTxFees[i]);
+        int64_t sigops{block_template->vTxSigOpsCost[i]};
+        if (pre_segwit) {
+            CHECK_NONFATAL(sigops % WITNESS_SCALE_FACTOR == 0);
+            sigops /= WITNESS_SCALE_FACTOR;
+        }
+        entry.pushKV("sigops", sigops);
+        entry.pushKV("weight", GetTransactionWeight(tx));
+        added.push_back(entry);
+    }
+
+    result.pushKV("removed", removed);
+    result.pushKV("added", added);
+    result.pushKV("coinbasevalue", vtx[0]->vout[0].nValue);
+    if (!block_template->vchCoinbaseCommitment.empty()) {
+        result.pushKV("default_witness_commitment", HexStr(block_template->vchCoinbaseCommitment));
+    }
     return result;
 },
     };
@@ -1102,13 +1244,14 @@ void RegisterMiningRPCCommands(CRPCTable& t)
         {"mining", &getmininginfo},
         {"mining", &prioritisetransaction},
         {"mining", &getprioritisedtransactions},
-        {"mining", &getblocktemplate},
-        {"mining", &submitblock},
+        {"mining", &getblocktemplate, RPCCost::HEAVY},
+        {"mining", &getblocktemplatedelta},
+        {"mining", &submitblock, RPCCost::HEAVY},
         {"mining", &submitheader},
 
-        {"hidden", &generatetoaddress},
-        {"hidden", &generatetodescriptor},
-        {"hidden", &generateblock},
+        {"hidden", &generatetoaddress, RPCCost::HEAVY},
+        {"hidden", &generatetodescriptor, RPCCost::HEAVY},
+        {"hidden", &generateblock, RPCCost::HEAVY},
         {"hidden", &generate},
     };
     for (const auto& c : commands) {
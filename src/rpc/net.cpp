@@ -14,6 +14,7 @@
 #include <net_processing.h>
 #include <net_types.h> // For banmap_t
 #include <netbase.h>
+#include <node/blockcache.h>
 #include <node/context.h>
 #include <node/protocol_version.h>
 #include <policy/settings.h>
@@ -595,6 +596,44 @@ static RPCHelpMan getnettotals()
     };
 }
 
+static RPCHelpMan getblockcacheinfo()
+{
+    return RPCHelpMan{"getblockcacheinfo",
+        "Returns information about the cache of recently requested blocks, which are served\n"
+        "to peers and REST clients from memory (see -blockcachesize).",
+        {},
+                RPCResult{
+                   RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::BOOL, "enabled", "Whether the block cache is enabled"},
+                       {RPCResult::Type::NUM, "entries", "Number of cached serialized blocks, with and without witness data counted separately"},
+                       {RPCResult::Type::NUM, "bytes", "Total size of the cached serialized blocks"},
+                       {RPCResult::Type::NUM, "max_bytes", "Maximum total size of the cached serialized blocks"},
+                       {RPCResult::Type::NUM, "hits", "Number of block requests served from the cache"},
+                       {RPCResult::Type::NUM, "misses", "Number of block requests that had to read the block from disk"},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getblockcacheinfo", "")
+            + HelpExampleRpc("getblockcacheinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    const node::SerializedBlockCache::Stats stats{node.block_cache ? node.block_cache->GetStats() : node::SerializedBlockCache::Stats{}};
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("enabled", node.block_cache != nullptr);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("bytes", uint64_t(stats.bytes));
+    obj.pushKV("max_bytes", uint64_t(stats.max_bytes));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    return obj;
+},
+    };
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -1161,14 +1200,15 @@ static RPCHelpMan getrawaddrman()
 void RegisterNetRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
-        {"network", &getconnectioncount},
-        {"network", &ping},
+        {"network", &getconnectioncount, RPCCost::CHEAP},
+        {"network", &ping, RPCCost::CHEAP},
         {"network", &getpeerinfo},
         {"network", &addnode},
         {"network", &disconnectnode},
         {"network", &getaddednodeinfo},
-        {"network", &getnettotals},
-        {"network", &getnetworkinfo},
+        {"network", &getnettotals, RPCCost::CHEAP},
+        {"network", &getblockcacheinfo, RPCCost::CHEAP},
+        {"network", &getnetworkinfo, RPCCost::CHEAP},
         {"network", &setban},
         {"network", &listbanned},
         {"network", &clearbanned},
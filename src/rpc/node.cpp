@@ -406,13 +406,13 @@ static RPCHelpMan getindexinfo()
 void RegisterNodeRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
-        {"control", &getmemoryinfo},
-        {"control", &logging},
-        {"util", &getindexinfo},
+        {"control", &getmemoryinfo, RPCCost::CHEAP},
+        {"control", &logging, RPCCost::CHEAP},
+        {"util", &getindexinfo, RPCCost::CHEAP},
         {"hidden", &setmocktime},
         {"hidden", &mockscheduler},
-        {"hidden", &echo},
-        {"hidden", &echojson},
+        {"hidden", &echo, RPCCost::CHEAP},
+        {"hidden", &echojson, RPCCost::CHEAP},
         {"hidden", &echoipc},
     };
     for (const auto& c : commands) {
@@ -11,6 +11,8 @@
 
 #include <univalue.h>
 
+class JSONStreamWriter;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -36,6 +38,12 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    /**
+     * If set, handlers of large results may write their result to this stream
+     * instead of returning it. The returned value is ignored once anything was
+     * written.
+     */
+    JSONStreamWriter* result_stream{nullptr};
 
     void parse(const UniValue& valRequest);
 };
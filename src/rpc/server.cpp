@@ -11,6 +11,7 @@
 
 #include <common/args.h>
 #include <common/system.h>
+#include <httpserver.h>
 #include <logging.h>
 #include <node/context.h>
 #include <rpc/server_util.h>
@@ -23,11 +24,13 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 static GlobalMutex g_rpc_warmup_mutex;
 static std::atomic<bool> g_rpc_running{false};
@@ -230,6 +233,20 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::OBJ_DYN, "work_queues", /*optional=*/true, "Queues of the HTTP server, by cost class of the requests they serve (cheap, medium, heavy)",
+                        {
+                            {RPCResult::Type::OBJ, "class", "",
+                            {
+                                {RPCResult::Type::NUM, "threads", "The number of worker threads serving the queue"},
+                                {RPCResult::Type::NUM, "depth", "The number of queued requests"},
+                                {RPCResult::Type::NUM, "max_depth", "The maximum number of queued requests"},
+                                {RPCResult::Type::NUM, "processed", "The number of requests handled"},
+                                {RPCResult::Type::NUM, "rejected", "The number of requests rejected because the queue was full"},
+                                {RPCResult::Type::NUM, "avg_wait", "The average time handled requests were queued in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait", "The maximum time a handled request was queued in microseconds"},
+                                {RPCResult::Type::NUM, "avg_duration", "The average time handling a request took in microseconds"},
+                            }},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -253,6 +270,25 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    const std::vector<HTTPWorkQueueStats> queue_stats{GetHTTPWorkQueueStats()};
+    if (!queue_stats.empty()) {
+        UniValue work_queues(UniValue::VOBJ);
+        for (const HTTPWorkQueueStats& stats : queue_stats) {
+            const int64_t processed{std::max<int64_t>(stats.processed, 1)};
+            UniValue queue(UniValue::VOBJ);
+            queue.pushKV("threads", stats.threads);
+            queue.pushKV("depth", uint64_t{stats.depth});
+            queue.pushKV("max_depth", uint64_t{stats.max_depth});
+            queue.pushKV("processed", stats.processed);
+            queue.pushKV("rejected", stats.rejected);
+            queue.pushKV("avg_wait", int64_t{count_microseconds(stats.total_wait) / processed});
+            queue.pushKV("max_wait", int64_t{count_microseconds(stats.max_wait)});
+            queue.pushKV("avg_duration", int64_t{count_microseconds(stats.total_run) / processed});
+            work_queues.pushKV(HTTPWorkClassString(stats.work_class), queue);
+        }
+        result.pushKV("work_queues", work_queues);
+    }
+
     return result;
 }
     };
@@ -260,10 +296,10 @@ static RPCHelpMan getrpcinfo()
 
 static const CRPCCommand vRPCCommands[]{
     /* Overall control/query calls */
-    {"control", &getrpcinfo},
-    {"control", &help},
-    {"control", &stop},
-    {"control", &uptime},
+    {"control", &getrpcinfo, RPCCost::CHEAP},
+    {"control", &help, RPCCost::CHEAP},
+    {"control", &stop, RPCCost::CHEAP},
+    {"control", &uptime, RPCCost::CHEAP},
 };
 
 CRPCTable::CRPCTable()
@@ -557,6 +593,13 @@ std::vector<std::string> CRPCTable::listCommands() const
     return commandList;
 }
 
+RPCCost CRPCTable::GetCost(const std::string& method) const
+{
+    auto it = mapCommands.find(method);
+    if (it == mapCommands.end() || it->second.empty()) return RPCCost::MEDIUM;
+    return it->second.front()->cost;
+}
+
 UniValue CRPCTable::dumpArgMap(const JSONRPCRequest& args_request) const
 {
     JSONRPCRequest request = args_request;
@@ -84,6 +84,18 @@ void RPCRunLater(const std::string& name, std::function<void()> func, int64_t nS
 
 typedef RPCHelpMan (*RpcMethodFnType)();
 
+/** How expensive it is to serve a call of an RPC method. The HTTP server
+ * serves each cost class from its own worker threads, so that cheap calls do
+ * not have to wait behind expensive ones.
+ */
+enum class RPCCost {
+    //! Answered right away from state kept in memory, e.g. getblockcount
+    CHEAP,
+    MEDIUM,
+    //! May take a long time or return a lot of data, e.g. getblock
+    HEAVY,
+};
+
 class CRPCCommand
 {
 public:
@@ -93,20 +105,21 @@ public:
     using Actor = std::function<bool(const JSONRPCRequest& request, UniValue& result, bool last_handler)>;
 
     //! Constructor taking Actor callback supporting multiple handlers.
-    CRPCCommand(std::string category, std::string name, Actor actor, std::vector<std::pair<std::string, bool>> args, intptr_t unique_id)
+    CRPCCommand(std::string category, std::string name, Actor actor, std::vector<std::pair<std::string, bool>> args, intptr_t unique_id, RPCCost cost = RPCCost::MEDIUM)
         : category(std::move(category)), name(std::move(name)), actor(std::move(actor)), argNames(std::move(args)),
-          unique_id(unique_id)
+          unique_id(unique_id), cost(cost)
     {
     }
 
     //! Simplified constructor taking plain RpcMethodFnType function pointer.
-    CRPCCommand(std::string category, RpcMethodFnType fn)
+    CRPCCommand(std::string category, RpcMethodFnType fn, RPCCost cost = RPCCost::MEDIUM)
         : CRPCCommand(
               category,
               fn().m_name,
               [fn](const JSONRPCRequest& request, UniValue& result, bool) { result = fn().HandleRequest(request); return true; },
               fn().GetArgNames(),
-              intptr_t(fn))
+              intptr_t(fn),
+              cost)
     {
     }
 
@@ -124,6 +137,7 @@ public:
     //! appended after other arguments, see transformNamedArguments for details.
     std::vector<std::pair<std::string, bool>> argNames;
     intptr_t unique_id;
+    RPCCost cost;
 };
 
 /**
@@ -151,6 +165,11 @@ public:
     */
     std::vector<std::string> listCommands() const;
 
+    /**
+     * Return the cost class of a method, RPCCost::MEDIUM if it is unknown.
+     */
+    RPCCost GetCost(const std::string& method) const;
+
     /**
      * Return all named arguments that need to be converted by the client from string to another JSON type
      */
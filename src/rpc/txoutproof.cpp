@@ -171,7 +171,7 @@ static RPCHelpMan verifytxoutproof()
 void RegisterTxoutProofRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
-        {"blockchain", &gettxoutproof},
+        {"blockchain", &gettxoutproof, RPCCost::HEAVY},
         {"blockchain", &verifytxoutproof},
     };
     for (const auto& c : commands) {
@@ -14,6 +14,7 @@
 #include <cuckoocache.h>
 
 #include <algorithm>
+#include <array>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
@@ -24,6 +25,12 @@ namespace {
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into shards, each with its own lock, so that the script
+ * check threads looking up and inserting signatures rarely contend on the same
+ * lock or the cache line holding it. Lookups only take a shard's lock in
+ * shared mode: erasing on a hit just marks the entry as collectable with the
+ * cache's atomic flags.
  */
 class CSignatureCache
 {
@@ -32,8 +39,20 @@ private:
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    std::shared_mutex cs_sigcache;
+    struct alignas(64) Shard {
+        map_type setValid;
+        std::shared_mutex cs_sigcache;
+    };
+    static constexpr size_t NUM_SHARDS{16};
+    std::array<Shard, NUM_SHARDS> m_shards;
+
+    Shard& GetShard(const uint256& entry)
+    {
+        // Entries are uniformly random. The cuckoo cache derives the locations
+        // of an entry from the high bits of each of its 32-bit words, so pick
+        // the shard from low bits.
+        return m_shards[entry.data()[0] % NUM_SHARDS];
+    }
 
 public:
     CSignatureCache()
@@ -68,18 +87,27 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        std::shared_lock<std::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        Shard& shard{GetShard(entry)};
+        std::shared_lock<std::shared_mutex> lock(shard.cs_sigcache);
+        return shard.setValid.contains(entry, erase);
     }
 
     void Set(const uint256& entry)
     {
-        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard& shard{GetShard(entry)};
+        std::unique_lock<std::shared_mutex> lock(shard.cs_sigcache);
+        shard.setValid.insert(entry);
     }
     std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t n)
     {
-        return setValid.setup_bytes(n);
+        std::pair<uint32_t, size_t> total{0, 0};
+        for (Shard& shard : m_shards) {
+            const auto result{shard.setValid.setup_bytes(n / NUM_SHARDS)};
+            if (!result) return std::nullopt;
+            total.first += result->first;
+            total.second += result->second;
+        }
+        return total;
     }
 };
 
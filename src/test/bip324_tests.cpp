@@ -92,6 +92,18 @@ void TestBIP324PacketVector(
         BOOST_CHECK(Span{out_ciphertext_endswith} == Span{ciphertext}.last(out_ciphertext_endswith.size()));
     }
 
+    // Encrypting the contents in place, from where their ciphertext goes, gives the same result.
+    BIP324Cipher in_place_cipher(key, ellswift_ours);
+    in_place_cipher.Initialize(ellswift_theirs, in_initiating);
+    for (uint32_t i = 0; i < in_idx; ++i) {
+        in_place_cipher.Encrypt({}, {}, true, dummies[i]);
+    }
+    std::vector<std::byte> in_place(contents.size() + in_place_cipher.EXPANSION);
+    const auto in_place_contents{Span{in_place}.subspan(in_place_cipher.LENGTH_LEN + in_place_cipher.HEADER_LEN, contents.size())};
+    std::copy(contents.begin(), contents.end(), in_place_contents.begin());
+    in_place_cipher.Encrypt(in_place_contents, in_aad, in_ignore, in_place);
+    BOOST_CHECK(in_place == ciphertext);
+
     for (unsigned error = 0; error <= 12; ++error) {
         // error selects a type of error introduced:
         // - error=0: no errors, decryption should be successful
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <node/blockcache.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using node::SerializedBlockCache;
+
+static SerializedBlockCache::SerializedBlock MakeBlock(size_t size)
+{
+    return std::make_shared<const std::vector<uint8_t>>(size);
+}
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lru_eviction)
+{
+    SerializedBlockCache cache{100};
+    const uint256 hash1{1}, hash2{2}, hash3{3};
+
+    cache.Insert(hash1, /*witness=*/true, MakeBlock(40));
+    cache.Insert(hash1, /*witness=*/false, MakeBlock(30));
+    BOOST_CHECK_EQUAL(cache.Get(hash1, /*witness=*/true)->size(), 40U);
+    BOOST_CHECK_EQUAL(cache.Get(hash1, /*witness=*/false)->size(), 30U);
+    BOOST_CHECK(!cache.Get(hash2, /*witness=*/true));
+
+    // hash1 without witness is the least recently used entry after this
+    BOOST_CHECK(cache.Get(hash1, /*witness=*/true));
+    cache.Insert(hash2, /*witness=*/true, MakeBlock(50));
+    BOOST_CHECK(!cache.Get(hash1, /*witness=*/false));
+    BOOST_CHECK(cache.Get(hash1, /*witness=*/true));
+    BOOST_CHECK(cache.Get(hash2, /*witness=*/true));
+
+    // Blocks larger than the whole cache are not cached
+    cache.Insert(hash3, /*witness=*/true, MakeBlock(101));
+    BOOST_CHECK(!cache.Get(hash3, /*witness=*/true));
+
+    const auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.bytes, 90U);
+    BOOST_CHECK_EQUAL(stats.max_bytes, 100U);
+    BOOST_CHECK_EQUAL(stats.hits, 5U);
+    BOOST_CHECK_EQUAL(stats.misses, 3U);
+}
+
+BOOST_FIXTURE_TEST_CASE(get_or_read, TestChain100Setup)
+{
+    SerializedBlockCache cache{1 << 20};
+    const node::BlockManager& blockman{m_node.chainman->m_blockman};
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *tip));
+
+    for (const bool witness : {true, false}) {
+        const auto first{cache.GetOrRead(blockman, *tip, witness)};
+        BOOST_REQUIRE(first);
+        DataStream expected{};
+        if (witness) {
+            expected << TX_WITH_WITNESS(block);
+        } else {
+            expected << TX_NO_WITNESS(block);
+        }
+        BOOST_CHECK_EQUAL(first->size(), expected.size());
+        BOOST_CHECK(std::equal(first->begin(), first->end(), UCharCast(expected.data())));
+        // The second request is served from the cache
+        BOOST_CHECK_EQUAL(cache.GetOrRead(blockman, *tip, witness), first);
+    }
+
+    const auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
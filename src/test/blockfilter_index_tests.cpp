@@ -57,6 +57,11 @@ static bool CheckFilterLookups(BlockFilterIndex& filter_index, const CBlockIndex
     BOOST_CHECK_EQUAL(filters[0].GetHash(), expected_filter.GetHash());
     BOOST_CHECK_EQUAL(filter_hashes[0], expected_filter.GetHash());
 
+    std::vector<std::shared_ptr<const DecodedGCSFilter>> decoded_filters;
+    BOOST_CHECK(filter_index.LookupDecodedFilterRange(block_index->nHeight, block_index, decoded_filters));
+    BOOST_REQUIRE_EQUAL(decoded_filters.size(), 1U);
+    BOOST_CHECK_EQUAL(decoded_filters[0]->GetN(), expected_filter.GetFilter().GetN());
+
     filters.clear();
     filter_hashes.clear();
     last_header = filter_header;
@@ -112,7 +117,10 @@ bool BuildChainTestingSetup::BuildChain(const CBlockIndex* pindex,
 
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
 {
-    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true);
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true,
+                                  /*f_wipe=*/false, /*decoded_cache_size=*/1 << 20);
+    // Build the filters on several threads, whatever the number of cores.
+    filter_index.SetSyncWorkers(3);
     BOOST_REQUIRE(filter_index.Init());
 
     uint256 last_header;
@@ -124,6 +132,7 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
         BlockFilter filter;
         uint256 filter_header;
         std::vector<BlockFilter> filters;
+        std::vector<std::shared_ptr<const DecodedGCSFilter>> decoded_filters;
         std::vector<uint256> filter_hashes;
 
         for (const CBlockIndex* block_index = m_node.chainman->ActiveChain().Genesis();
@@ -132,6 +141,7 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
             BOOST_CHECK(!filter_index.LookupFilter(block_index, filter));
             BOOST_CHECK(!filter_index.LookupFilterHeader(block_index, filter_header));
             BOOST_CHECK(!filter_index.LookupFilterRange(block_index->nHeight, block_index, filters));
+            BOOST_CHECK(!filter_index.LookupDecodedFilterRange(block_index->nHeight, block_index, decoded_filters));
             BOOST_CHECK(!filter_index.LookupFilterHashRange(block_index->nHeight, block_index,
                                                             filter_hashes));
         }
@@ -188,6 +198,13 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
         CheckFilterLookups(filter_index, block_index, chainA_last_header, m_node.chainman->m_blockman);
     }
 
+    // Decoded filters are served from the cache until their block is disconnected.
+    const CBlockIndex* chainA_tip_index{WITH_LOCK(cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(chainA[1]->GetHash()))};
+    std::vector<std::shared_ptr<const DecodedGCSFilter>> cached_filters, decoded_filters;
+    BOOST_CHECK(filter_index.LookupDecodedFilterRange(chainA_tip_index->nHeight - 1, chainA_tip_index, cached_filters));
+    BOOST_CHECK(filter_index.LookupDecodedFilterRange(chainA_tip_index->nHeight - 1, chainA_tip_index, decoded_filters));
+    BOOST_CHECK(decoded_filters == cached_filters);
+
     // Reorg to chain B.
     uint256 chainB_last_header = last_header;
     for (size_t i = 0; i < 3; i++) {
@@ -206,6 +223,15 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
         CheckFilterLookups(filter_index, block_index, chainB_last_header, m_node.chainman->m_blockman);
     }
 
+    // The decoded filters of the disconnected chain A blocks were dropped from the cache, but
+    // can still be looked up.
+    BOOST_CHECK(filter_index.LookupDecodedFilterRange(chainA_tip_index->nHeight - 1, chainA_tip_index, decoded_filters));
+    BOOST_REQUIRE_EQUAL(decoded_filters.size(), 2U);
+    for (size_t i = 0; i < 2; ++i) {
+        BOOST_CHECK(decoded_filters[i] != cached_filters[i]);
+        BOOST_CHECK_EQUAL(decoded_filters[i]->GetN(), cached_filters[i]->GetN());
+    }
+
     // Check that filters for stale blocks on A can be retrieved.
     chainA_last_header = last_header;
     for (size_t i = 0; i < 2; i++) {
@@ -257,10 +283,15 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     }
     BOOST_CHECK(filter_index.LookupFilterRange(0, tip, filters));
     BOOST_CHECK(filter_index.LookupFilterHashRange(0, tip, filter_hashes));
+    BOOST_CHECK(filter_index.LookupDecodedFilterRange(0, tip, decoded_filters));
 
     assert(tip->nHeight >= 0);
     BOOST_CHECK_EQUAL(filters.size(), tip->nHeight + 1U);
     BOOST_CHECK_EQUAL(filter_hashes.size(), tip->nHeight + 1U);
+    BOOST_REQUIRE_EQUAL(decoded_filters.size(), tip->nHeight + 1U);
+    for (size_t i = 0; i < filters.size(); ++i) {
+        BOOST_CHECK_EQUAL(decoded_filters[i]->GetN(), filters[i].GetFilter().GetN());
+    }
 
     filters.clear();
     filter_hashes.clear();
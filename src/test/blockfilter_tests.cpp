@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <test/data/blockfilters.json.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <blockfilter.h>
@@ -41,6 +42,50 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(gcsfilter_match_any_batch)
+{
+    auto random_elements = [](size_t count) {
+        GCSFilter::ElementSet elements;
+        while (elements.size() < count) {
+            elements.insert(g_insecure_rand_ctx.randbytes(1 + InsecureRandRange(40)));
+        }
+        return elements;
+    };
+
+    // Filters small and large compared to the element sets, so that both matching strategies are used
+    std::vector<GCSFilter::ElementSet> filter_elements;
+    std::vector<GCSFilter> filters;
+    for (const size_t n : {0, 1, 10, 100, 1000, 3000}) {
+        filter_elements.push_back(random_elements(n));
+        filters.emplace_back(GCSFilter::Params{g_insecure_rand_ctx.rand64(), g_insecure_rand_ctx.rand64(), BASIC_FILTER_P, BASIC_FILTER_M}, filter_elements.back());
+        filter_elements.push_back(random_elements(n));
+        filters.emplace_back(GCSFilter::Params{g_insecure_rand_ctx.rand64(), g_insecure_rand_ctx.rand64(), 10, 1 << 10}, filter_elements.back());
+    }
+    std::vector<const GCSFilter*> filter_ptrs;
+    for (const GCSFilter& filter : filters) filter_ptrs.push_back(&filter);
+    std::vector<DecodedGCSFilter> decoded_filters;
+    for (const GCSFilter& filter : filters) decoded_filters.emplace_back(filter);
+    std::vector<const DecodedGCSFilter*> decoded_ptrs;
+    for (const DecodedGCSFilter& filter : decoded_filters) decoded_ptrs.push_back(&filter);
+
+    for (const size_t count : {0, 1, 5, 200, 5000}) {
+        GCSFilter::ElementSet queries{random_elements(count)};
+        // Include an element of every other non-empty filter
+        for (size_t i = 2; i < filters.size(); i += 2) queries.insert(*filter_elements[i].begin());
+
+        const std::vector<bool> matches{GCSFilter::MatchAnyBatch(filter_ptrs, queries)};
+        const std::vector<bool> decoded_matches{DecodedGCSFilter::MatchAnyBatch(decoded_ptrs, queries)};
+        BOOST_REQUIRE_EQUAL(matches.size(), filters.size());
+        BOOST_REQUIRE_EQUAL(decoded_matches.size(), filters.size());
+        for (size_t i = 0; i < filters.size(); ++i) {
+            BOOST_CHECK_EQUAL(matches[i], filters[i].MatchAny(queries));
+            BOOST_CHECK_EQUAL(decoded_matches[i], matches[i]);
+            BOOST_CHECK_EQUAL(decoded_filters[i].MatchAny(queries), matches[i]);
+            if (i >= 2 && i % 2 == 0) BOOST_CHECK(matches[i]);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
 {
     GCSFilter filter;
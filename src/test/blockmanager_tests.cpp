@@ -12,6 +12,8 @@
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <algorithm>
+
 #include <boost/test/unit_test.hpp>
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
@@ -20,6 +22,7 @@ using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
+using node::RawBlock;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -201,4 +204,39 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_raw_block_mmap, TestChain100Setup)
+{
+    KernelNotifications notifications{*Assert(m_node.shutdown), m_node.exit_status};
+    const BlockManager::Options blockman_opts{
+        .chainparams = Params(),
+        .use_mmap = true,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+    };
+    // A second BlockManager, mapping the block files written by the chainstate's one
+    BlockManager mapped_blockman{*Assert(m_node.shutdown), blockman_opts};
+    BlockManager& blockman{m_node.chainman->m_blockman};
+
+    for (const CBlockIndex* index{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())}; index; index = index->pprev) {
+        const FlatFilePos pos{WITH_LOCK(::cs_main, return index->GetBlockPos())};
+        std::vector<uint8_t> expected;
+        BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(expected, pos));
+
+        RawBlock raw_block;
+        BOOST_REQUIRE(mapped_blockman.ReadRawBlockFromDisk(raw_block, pos));
+        BOOST_CHECK(std::ranges::equal(raw_block.data(), expected));
+        // Without -blockmmap the block is copied out of the file
+        BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw_block, pos));
+        BOOST_CHECK(std::ranges::equal(raw_block.data(), expected));
+
+        CBlock block;
+        BOOST_REQUIRE(mapped_blockman.ReadBlockFromDisk(block, *index));
+        BOOST_CHECK_EQUAL(block.GetHash(), index->GetBlockHash());
+    }
+
+    // A null position can neither be read nor mapped
+    RawBlock raw_block;
+    BOOST_CHECK(!mapped_blockman.ReadRawBlockFromDisk(raw_block, FlatFilePos{}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cluster_linearize.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/feefrac.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace cluster_linearize;
+
+BOOST_FIXTURE_TEST_SUITE(cluster_linearize_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(child_pays_for_parent)
+{
+    DepGraph depgraph;
+    const ClusterIndex parent{depgraph.AddTransaction({1, 10})};
+    const ClusterIndex child{depgraph.AddTransaction({100, 10})};
+    const ClusterIndex other{depgraph.AddTransaction({20, 10})};
+    depgraph.AddDependency(parent, child);
+
+    const auto linearization{Linearize(depgraph)};
+    BOOST_CHECK(linearization == std::vector<ClusterIndex>({parent, child, other}));
+    const auto chunks{ChunkLinearization(depgraph, linearization)};
+    BOOST_REQUIRE_EQUAL(chunks.size(), 2U);
+    BOOST_CHECK(chunks[0].feerate == FeeFrac(101, 20));
+    BOOST_CHECK_EQUAL(chunks[0].end, 2U);
+    BOOST_CHECK(chunks[1].feerate == FeeFrac(20, 10));
+    BOOST_CHECK_EQUAL(chunks[1].end, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(low_feerate_child)
+{
+    // A child paying less than its parent is mined after the unrelated transaction
+    DepGraph depgraph;
+    const ClusterIndex parent{depgraph.AddTransaction({100, 10})};
+    const ClusterIndex child{depgraph.AddTransaction({1, 10})};
+    const ClusterIndex other{depgraph.AddTransaction({20, 10})};
+    depgraph.AddDependency(parent, child);
+
+    const auto linearization{Linearize(depgraph)};
+    BOOST_CHECK(linearization == std::vector<ClusterIndex>({parent, other, child}));
+    const auto chunks{ChunkLinearization(depgraph, linearization)};
+    BOOST_CHECK_EQUAL(chunks.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(random_graphs)
+{
+    for (int i = 0; i < 100; ++i) {
+        DepGraph depgraph;
+        const ClusterIndex count = 1 + InsecureRandRange(40);
+        for (ClusterIndex tx{0}; tx < count; ++tx) {
+            depgraph.AddTransaction(FeeFrac{int64_t(InsecureRandRange(10000)), int32_t(1 + InsecureRandRange(1000))});
+            // Only spend earlier transactions, so there are no cycles
+            for (ClusterIndex parent{0}; parent < tx; ++parent) {
+                if (InsecureRandRange(8) == 0) depgraph.AddDependency(parent, tx);
+            }
+        }
+
+        const auto linearization{Linearize(depgraph)};
+        BOOST_REQUIRE_EQUAL(linearization.size(), count);
+        // Every transaction appears once, after all of its parents
+        std::vector<size_t> position(count, count);
+        for (size_t pos{0}; pos < count; ++pos) {
+            BOOST_REQUIRE_EQUAL(position[linearization[pos]], count);
+            position[linearization[pos]] = pos;
+        }
+        for (ClusterIndex tx{0}; tx < count; ++tx) {
+            for (const ClusterIndex parent : depgraph.Parents(tx)) {
+                BOOST_CHECK_LT(position[parent], position[tx]);
+            }
+        }
+
+        // Chunks cover the linearization with decreasing feerates
+        const auto chunks{ChunkLinearization(depgraph, linearization)};
+        size_t begin{0};
+        for (size_t c{0}; c < chunks.size(); ++c) {
+            BOOST_REQUIRE_GT(chunks[c].end, begin);
+            FeeFrac feerate;
+            for (size_t pos{begin}; pos < chunks[c].end; ++pos) feerate += depgraph.FeeRate(linearization[pos]);
+            BOOST_CHECK(feerate == chunks[c].feerate);
+            if (c > 0) BOOST_CHECK(!(chunks[c].feerate >> chunks[c - 1].feerate));
+            begin = chunks[c].end;
+        }
+        BOOST_CHECK_EQUAL(begin, count);
+
+        // Chunking only needs the feerates in linearization order
+        std::vector<FeeFrac> feerates;
+        for (const ClusterIndex tx : linearization) feerates.push_back(depgraph.FeeRate(tx));
+        const auto feerate_chunks{ChunkLinearization(feerates)};
+        BOOST_REQUIRE_EQUAL(feerate_chunks.size(), chunks.size());
+        for (size_t c{0}; c < chunks.size(); ++c) {
+            BOOST_CHECK(feerate_chunks[c].feerate == chunks[c].feerate);
+            BOOST_CHECK_EQUAL(feerate_chunks[c].end, chunks[c].end);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
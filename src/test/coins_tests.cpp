@@ -6,7 +6,6 @@
 #include <clientversion.h>
 #include <coins.h>
 #include <streams.h>
-#include <test/util/poolresourcetester.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <txdb.h>
@@ -589,7 +588,7 @@ static size_t InsertCoinsMapEntry(CCoinsMap& map, CAmount value, char flags)
     CCoinsCacheEntry entry;
     entry.flags = flags;
     SetCoinsValue(value, entry.coin);
-    auto inserted = map.emplace(OUTPOINT, std::move(entry));
+    auto inserted = map.try_emplace(OUTPOINT, std::move(entry));
     assert(inserted.second);
     return inserted.first->second.coin.DynamicMemoryUsage();
 }
@@ -613,8 +612,7 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags, const C
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMapMemoryResource resource;
-    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+    CCoinsMap map;
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -971,7 +969,7 @@ void TestFlushBehavior(
         //
         flush_all(/*erase=*/ true);
 
-        // Memory does not necessarily go down due to the map using a memory pool
+        // Memory does not necessarily go down as the map keeps its index allocated
         BOOST_TEST(view->DynamicMemoryUsage() <= cache_usage);
         // Size of the cache must go down though
         BOOST_TEST(view->map().size() < cache_size);
@@ -1084,29 +1082,39 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
-BOOST_AUTO_TEST_CASE(coins_resource_is_used)
+BOOST_AUTO_TEST_CASE(coins_map_memory_usage)
 {
-    CCoinsMapMemoryResource resource;
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
-
-    {
-        CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
-        BOOST_TEST(memusage::DynamicUsage(map) >= resource.ChunkSizeBytes());
-
-        map.reserve(1000);
-
-        // The resource has preallocated a chunk, so we should have space for at several nodes without the need to allocate anything else.
-        const auto usage_before = memusage::DynamicUsage(map);
-
-        COutPoint out_point{};
-        for (size_t i = 0; i < 1000; ++i) {
-            out_point.n = i;
-            map[out_point];
-        }
-        BOOST_TEST(usage_before == memusage::DynamicUsage(map));
+    CCoinsMap map;
+    // An empty map does not allocate.
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    COutPoint out_point{};
+    for (uint32_t i = 0; i < 100'000; ++i) {
+        out_point.n = i;
+        map[out_point];
+    }
+    BOOST_CHECK_EQUAL(map.size(), 100'000U);
+    // Entries are stored densely, next to an index that is at least 1/8 empty.
+    const size_t usage{memusage::DynamicUsage(map)};
+    BOOST_CHECK(usage >= map.size() * sizeof(CCoinsMap::value_type) + map.bucket_count() * 8);
+    BOOST_CHECK(usage < map.size() * (sizeof(CCoinsMap::value_type) + 2 * 8 * 8 / 7) + (1 << 20));
+
+    // Erasing while iterating visits every entry exactly once.
+    size_t visited{0};
+    for (auto it = map.begin(); it != map.end();) {
+        BOOST_CHECK(it->first.n < 100'000);
+        ++visited;
+        it = (it->first.n % 3 == 0) ? map.erase(it) : std::next(it);
+    }
+    BOOST_CHECK_EQUAL(visited, 100'000U);
+    BOOST_CHECK_EQUAL(map.size(), 100'000U - 33'334U);
+    for (uint32_t i = 0; i < 100'000; ++i) {
+        out_point.n = i;
+        BOOST_CHECK_EQUAL(map.count(out_point), i % 3 == 0 ? 0U : 1U);
     }
 
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
+    map.clear();
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@
 #include <test/util/setup_common.h>
 #include <util/strencodings.h>
 
+#include <limits>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -838,6 +839,45 @@ BOOST_AUTO_TEST_CASE(chacha20_midblock)
     BOOST_CHECK(Span{block}.last(52) == Span{b3});
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_implementations)
+{
+    // Every implementation produces the same output as the standard one, for runs of blocks that
+    // may or may not be a multiple of the number of blocks processed at once, including across a
+    // block counter overflow.
+    for (int i = 0; i < 32; ++i) {
+        const auto key{g_insecure_rand_ctx.randbytes<std::byte>(ChaCha20Aligned::KEYLEN)};
+        const ChaCha20Aligned::Nonce96 nonce{InsecureRand32(), g_insecure_rand_ctx.rand64()};
+        const uint32_t counter = (i % 2) ? InsecureRand32() : std::numeric_limits<uint32_t>::max() - InsecureRandRange(32);
+        const auto input{g_insecure_rand_ctx.randbytes<std::byte>(InsecureRandRange(40) * ChaCha20Aligned::BLOCKLEN)};
+
+        ChaCha20AutoDetect(chacha20_implementation::STANDARD);
+        ChaCha20Aligned standard{key};
+        std::vector<std::byte> expected_keystream(input.size()), expected_crypt(input.size());
+        standard.Seek(nonce, counter);
+        standard.Keystream(expected_keystream);
+        standard.Seek(nonce, counter);
+        standard.Crypt(input, expected_crypt);
+
+        for (const auto use_implementation : {chacha20_implementation::USE_SSE41, chacha20_implementation::USE_ALL}) {
+            ChaCha20AutoDetect(use_implementation);
+            ChaCha20Aligned cipher{key};
+            std::vector<std::byte> keystream(input.size()), crypt(input.size());
+            cipher.Seek(nonce, counter);
+            cipher.Keystream(keystream);
+            BOOST_CHECK(keystream == expected_keystream);
+            cipher.Seek(nonce, counter);
+            cipher.Crypt(input, crypt);
+            BOOST_CHECK(crypt == expected_crypt);
+            // Encrypting in place gives the same result.
+            crypt = input;
+            cipher.Seek(nonce, counter);
+            cipher.Crypt(crypt, crypt);
+            BOOST_CHECK(crypt == expected_crypt);
+        }
+    }
+    ChaCha20AutoDetect();
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
@@ -959,6 +999,38 @@ BOOST_AUTO_TEST_CASE(poly1305_testvector)
                  "0e410fa9d7a40ac582e77546be9a72bb");
 }
 
+BOOST_AUTO_TEST_CASE(poly1305_implementations)
+{
+    // Every implementation produces the same tag as the standard one, including for the largest r
+    // allowed and for messages of all ones, and with messages processed in chunks of any size.
+    for (int i = 0; i < 64; ++i) {
+        auto key{g_insecure_rand_ctx.randbytes<std::byte>(Poly1305::KEYLEN)};
+        auto msg{g_insecure_rand_ctx.randbytes<std::byte>(InsecureRandRange(1024))};
+        if (i % 4 == 1) std::fill(key.begin(), key.begin() + 16, std::byte{0xff});
+        if (i % 4 == 2) std::fill(msg.begin(), msg.end(), std::byte{0xff});
+
+        Poly1305AutoDetect(poly1305_implementation::STANDARD);
+        std::vector<std::byte> expected(Poly1305::TAGLEN);
+        Poly1305{key}.Update(msg).Finalize(expected);
+
+        Poly1305AutoDetect(poly1305_implementation::USE_ALL);
+        std::vector<std::byte> tag(Poly1305::TAGLEN);
+        Poly1305{key}.Update(msg).Finalize(tag);
+        BOOST_CHECK(tag == expected);
+
+        auto data = Span{msg};
+        Poly1305 poly1305{key};
+        while (!data.empty()) {
+            const size_t now = InsecureRandRange(data.size() + 1);
+            poly1305.Update(data.first(now));
+            data = data.subspan(now);
+        }
+        poly1305.Finalize(tag);
+        BOOST_CHECK(tag == expected);
+    }
+    Poly1305AutoDetect();
+}
+
 BOOST_AUTO_TEST_CASE(chacha20poly1305_testvectors)
 {
     // Note that in our implementation, the authentication is suffixed to the ciphertext.
@@ -4,6 +4,7 @@
 
 #include <coins.h>
 #include <crypto/sha256.h>
+#include <memusage.h>
 #include <primitives/transaction.h>
 #include <test/fuzz/fuzz.h>
 #include <test/fuzz/FuzzedDataProvider.h>
@@ -13,6 +14,7 @@
 #include <optional>
 #include <memory>
 #include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -478,3 +480,84 @@ FUZZ_TARGET(coinscache_sim)
         }
     }
 }
+
+/** Compare CCoinsMap against the node-based std::unordered_map it replaced. */
+FUZZ_TARGET(coinscache_map)
+{
+    /** Precomputed COutPoint and CCoins values. */
+    static const PrecomputedData data;
+
+    CCoinsMap real{SaltedOutpointHasher{/*deterministic=*/true}};
+    std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> sim;
+
+    auto check_entry = [&](const COutPoint& outpoint) {
+        auto it_real = real.find(outpoint);
+        auto it_sim = sim.find(outpoint);
+        assert((it_real == real.end()) == (it_sim == sim.end()));
+        if (it_real != real.end()) {
+            assert(it_real->first == outpoint);
+            assert(it_real->second.flags == it_sim->second.flags);
+            assert(it_real->second.coin.out == it_sim->second.coin.out);
+            assert(it_real->second.coin.nHeight == it_sim->second.coin.nHeight);
+        }
+    };
+
+    FuzzedDataProvider provider(buffer.data(), buffer.size());
+    uint32_t height{0};
+    LIMITED_WHILE(provider.remaining_bytes(), 10000) {
+        const COutPoint& outpoint{data.outpoints[provider.ConsumeIntegralInRange<uint32_t>(0, NUM_OUTPOINTS - 1)]};
+        CallOneOf(
+            provider,
+            [&] { // try_emplace
+                Coin coin{data.coins[provider.ConsumeIntegral<coinidx_type>()]};
+                coin.nHeight = ++height;
+                const unsigned char flags{provider.ConsumeIntegralInRange<unsigned char>(0, 3)};
+                auto [it_real, ins_real] = real.try_emplace(outpoint, Coin{coin}, flags);
+                auto [it_sim, ins_sim] = sim.try_emplace(outpoint, std::move(coin), flags);
+                assert(ins_real == ins_sim);
+                assert(it_real->first == it_sim->first);
+            },
+            [&] { // operator[] and modification
+                const unsigned char flags{provider.ConsumeIntegralInRange<unsigned char>(0, 3)};
+                real[outpoint].flags = flags;
+                sim[outpoint].flags = flags;
+            },
+            [&] { // erase by key
+                assert(real.erase(outpoint) == sim.erase(outpoint));
+            },
+            [&] { // erase a subset while iterating, as BatchWrite and Sync do
+                const unsigned char mask{provider.ConsumeIntegral<unsigned char>()};
+                const size_t size_before{real.size()};
+                size_t visited{0};
+                for (auto it = real.begin(); it != real.end(); ++visited) {
+                    if ((mask >> (it->first.n % 8)) & 1) {
+                        assert(sim.erase(it->first) == 1);
+                        it = real.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                assert(visited == size_before);
+            },
+            [&] { // clear
+                real.clear();
+                sim.clear();
+                assert(memusage::DynamicUsage(real) == 0);
+            });
+        assert(real.size() == sim.size());
+        assert(real.empty() == sim.empty());
+        check_entry(outpoint);
+    }
+
+    // Full comparison, both by lookup and by iteration.
+    for (const COutPoint& outpoint : data.outpoints) {
+        check_entry(outpoint);
+    }
+    size_t count{0};
+    for (const auto& [outpoint, entry] : real) {
+        assert(sim.count(outpoint) == 1);
+        ++count;
+    }
+    assert(count == sim.size());
+    assert(memusage::DynamicUsage(real) >= real.size() * sizeof(CCoinsMap::value_type));
+}
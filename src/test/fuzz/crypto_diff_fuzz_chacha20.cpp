@@ -265,7 +265,13 @@ void ECRYPT_keystream_bytes(ECRYPT_ctx* x, u8* stream, u32 bytes)
     ECRYPT_encrypt_bytes(x, stream, stream, bytes);
 }
 
-FUZZ_TARGET(crypto_diff_fuzz_chacha20)
+void initialize_crypto_diff_fuzz_chacha20()
+{
+    // Compare the fastest available implementation with the reference one.
+    ChaCha20AutoDetect();
+}
+
+FUZZ_TARGET(crypto_diff_fuzz_chacha20, .init = initialize_crypto_diff_fuzz_chacha20)
 {
     FuzzedDataProvider fuzzed_data_provider{buffer.data(), buffer.size()};
 
@@ -15,6 +15,7 @@
 #include <cassert>
 #include <cstdint>
 #include <iosfwd>
+#include <optional>
 #include <unordered_set>
 #include <vector>
 
@@ -78,6 +79,16 @@ FUZZ_TARGET(golomb_rice)
 
     assert(encoded_deltas == decoded_deltas);
 
+    {
+        SpanReader stream{golomb_rice_data};
+        const uint32_t n = static_cast<uint32_t>(ReadCompactSize(stream));
+        GolombRiceDecoder decoder{Span{golomb_rice_data}.last(stream.size())};
+        for (uint32_t i = 0; i < n; ++i) {
+            assert(decoder.Decode(BASIC_FILTER_P) == decoded_deltas[i]);
+        }
+        assert(decoder.empty());
+    }
+
     {
         const std::vector<uint8_t> random_bytes = ConsumeRandomLengthByteVector(fuzzed_data_provider, 1024);
         SpanReader stream{random_bytes};
@@ -87,11 +98,23 @@ FUZZ_TARGET(golomb_rice)
         } catch (const std::ios_base::failure&) {
             return;
         }
+        // The fast decoder must agree with the bit by bit one, including on where the data ends.
+        GolombRiceDecoder decoder{Span{random_bytes}.last(stream.size())};
         BitStreamReader bitreader{stream};
+        bool decoder_failed{false};
         for (uint32_t i = 0; i < std::min<uint32_t>(n, 1024); ++i) {
+            std::optional<uint64_t> expected;
+            try {
+                expected = GolombRiceDecode(bitreader, BASIC_FILTER_P);
+            } catch (const std::ios_base::failure&) {
+            }
+            if (decoder_failed) continue;
             try {
-                (void)GolombRiceDecode(bitreader, BASIC_FILTER_P);
+                const uint64_t decoded{decoder.Decode(BASIC_FILTER_P)};
+                assert(expected == decoded);
             } catch (const std::ios_base::failure&) {
+                assert(!expected);
+                decoder_failed = true;
             }
         }
     }
@@ -114,6 +114,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getaddrmaninfo",
     "getbestblockhash",
     "getblock",
+    "getblockcacheinfo",
     "getblockchaininfo",
     "getblockcount",
     "getblockfilter",
@@ -122,6 +123,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getblockheader",
     "getblockstats",
     "getblocktemplate",
+    "getblocktemplatedelta",
     "getchaintips",
     "getchainstates",
     "getchaintxstats",
@@ -0,0 +1,216 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <common/args.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <core_memusage.h>
+#include <hash.h>
+#include <index/base.h>
+#include <index/syncblockreader.h>
+#include <interfaces/chain.h>
+#include <script/script.h>
+#include <sync.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <util/time.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/**
+ * Index keeping a hash chain over the merkle roots of the blocks it indexed, like the filter
+ * header chain of BlockFilterIndex, so that the result of a sync depends on every block being
+ * appended once and in order.
+ */
+class ChainHashIndex final : public BaseIndex
+{
+public:
+    struct Entry {
+        uint256 block_hash;
+        uint256 chain_hash;
+        bool operator==(const Entry&) const = default;
+    };
+
+    //! Called for every block processed on a worker thread during a parallel sync
+    std::function<void(const interfaces::BlockInfo&)> m_on_process_block;
+
+    ChainHashIndex(std::unique_ptr<interfaces::Chain> chain, std::string name, bool parallel)
+        : BaseIndex(std::move(chain), name),
+          m_db{std::make_unique<BaseIndex::DB>(gArgs.GetDataDirNet() / "indexes" / fs::u8path(name), /*n_cache_size=*/0, /*f_memory=*/true)},
+          m_parallel{parallel} {}
+
+    ~ChainHashIndex() override
+    {
+        Interrupt();
+        Stop();
+    }
+
+    std::vector<Entry> GetEntries() const { return WITH_LOCK(m_mutex, return m_entries); }
+
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+    const bool m_parallel;
+    mutable Mutex m_mutex;
+    std::vector<Entry> m_entries GUARDED_BY(m_mutex);
+
+    bool AllowPrune() const override { return false; }
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+    bool AllowParallelSync() const override { return m_parallel; }
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override
+    {
+        return CustomPostProcessBlock(block, BlockMerkleRoot(*Assert(block.data)));
+    }
+
+    std::any CustomProcessBlock(const interfaces::BlockInfo& block) override
+    {
+        if (m_on_process_block) m_on_process_block(block);
+        return BlockMerkleRoot(*Assert(block.data));
+    }
+
+    bool CustomPostProcessBlock(const interfaces::BlockInfo& block, const std::any& entries) override
+    {
+        LOCK(m_mutex);
+        // Blocks must be appended on top of the last one.
+        if (block.height != int(m_entries.size())) return false;
+        if (block.height > 0 && *block.prev_hash != m_entries.back().block_hash) return false;
+        const uint256 prev_chain_hash{m_entries.empty() ? uint256{} : m_entries.back().chain_hash};
+        m_entries.push_back({block.hash, (HashWriter{} << prev_chain_hash << std::any_cast<const uint256&>(entries)).GetHash()});
+        return true;
+    }
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override
+    {
+        LOCK(m_mutex);
+        if (current_tip.height != int(m_entries.size()) - 1 || current_tip.hash != m_entries.back().block_hash) return false;
+        m_entries.resize(new_tip.height + 1);
+        return m_entries.back().block_hash == new_tip.hash;
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(index_sync_tests)
+
+BOOST_FIXTURE_TEST_CASE(parallel_sync_reorg, TestChain100Setup)
+{
+    constexpr int FORK_HEIGHT{40};
+    constexpr int PAUSE_HEIGHT{50};
+
+    // Sync with several workers, and reorganize the chain while the first batch, which spans
+    // the fork point, is being processed.
+    ChainHashIndex parallel_index{interfaces::MakeChain(m_node), "parallel", /*parallel=*/true};
+    parallel_index.SetSyncWorkers(3);
+    std::promise<void> paused;
+    std::promise<void> resume;
+    std::atomic<bool> did_pause{false};
+    parallel_index.m_on_process_block = [&, resumed = resume.get_future().share()](const interfaces::BlockInfo& block) {
+        if (block.height == PAUSE_HEIGHT && !did_pause.exchange(true)) {
+            paused.set_value();
+            resumed.wait();
+        }
+    };
+    BOOST_REQUIRE(parallel_index.Init());
+    BOOST_REQUIRE(parallel_index.StartBackgroundSync());
+    paused.get_future().wait();
+
+    CBlockIndex* fork_child{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()[FORK_HEIGHT + 1])};
+    BlockValidationState state;
+    BOOST_CHECK(m_node.chainman->ActiveChainstate().InvalidateBlock(state, fork_child));
+    for (int i{0}; i < 70; ++i) CreateAndProcessBlock({}, CScript{} << OP_TRUE);
+    // Let the index ignore the notifications of the reorg, it is not synced yet.
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    resume.set_value();
+    IndexWaitSynced(parallel_index, *Assert(m_node.shutdown));
+
+    // A serial sync of the new chain must give the same result.
+    ChainHashIndex serial_index{interfaces::MakeChain(m_node), "serial", /*parallel=*/false};
+    BOOST_REQUIRE(serial_index.Init());
+    BOOST_REQUIRE(serial_index.StartBackgroundSync());
+    IndexWaitSynced(serial_index, *Assert(m_node.shutdown));
+
+    const auto entries{parallel_index.GetEntries()};
+    BOOST_CHECK(entries == serial_index.GetEntries());
+    LOCK(cs_main);
+    const CChain& chain{m_node.chainman->ActiveChain()};
+    BOOST_REQUIRE_EQUAL(entries.size(), size_t(chain.Height() + 1));
+    BOOST_CHECK_EQUAL(chain.Height(), FORK_HEIGHT + 70);
+    for (int height{0}; height <= chain.Height(); ++height) {
+        BOOST_CHECK_EQUAL(entries[height].block_hash, chain[height]->GetBlockHash());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(sync_block_reader, TestChain100Setup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    const auto block_at{[&](int height) { return WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()[height]); }};
+
+    // Indexes syncing at the same time share a reader, which goes away after them.
+    std::weak_ptr<SyncBlockReader> weak_reader;
+    {
+        const auto reader{GetSyncBlockReader(chainstate)};
+        const auto other_reader{GetSyncBlockReader(chainstate)};
+        BOOST_CHECK(reader == other_reader);
+        weak_reader = reader;
+
+        // A block read for one index is handed out to the others from memory.
+        const auto block{reader->Read(*block_at(10))};
+        BOOST_REQUIRE(block);
+        BOOST_CHECK_EQUAL(block->GetHash(), block_at(10)->GetBlockHash());
+        BOOST_CHECK(other_reader->Read(*block_at(10)) == block);
+    }
+    BOOST_CHECK(weak_reader.expired());
+
+    // The coinbase transactions of these blocks have the same size.
+    const size_t block_usage{RecursiveDynamicUsage(*GetSyncBlockReader(chainstate)->Read(*block_at(20)))};
+    SyncBlockReader reader{chainstate, /*cache_bytes=*/2 * block_usage, /*read_ahead_blocks=*/0};
+    BOOST_REQUIRE(reader.Read(*block_at(20)));
+    BOOST_REQUIRE(reader.Read(*block_at(21)));
+    BOOST_CHECK_EQUAL(reader.GetCacheUsage(), 2 * block_usage);
+
+    // The least recently used block is evicted to make room for a new one.
+    BOOST_REQUIRE(reader.Read(*block_at(20)));
+    BOOST_REQUIRE(reader.Read(*block_at(22)));
+    BOOST_CHECK(reader.IsCached(*block_at(20)));
+    BOOST_CHECK(!reader.IsCached(*block_at(21)));
+    BOOST_CHECK(reader.IsCached(*block_at(22)));
+    BOOST_CHECK_EQUAL(reader.GetCacheUsage(), 2 * block_usage);
+
+    // A block is kept even if it alone exceeds the memory for the blocks.
+    SetSyncBlockCacheSize(0);
+    {
+        const auto small_reader{GetSyncBlockReader(chainstate)};
+        BOOST_REQUIRE(small_reader->Read(*block_at(20)));
+        BOOST_REQUIRE(small_reader->Read(*block_at(21)));
+        BOOST_CHECK(!small_reader->IsCached(*block_at(20)));
+        BOOST_CHECK_EQUAL(small_reader->GetCacheUsage(), block_usage);
+    }
+    SetSyncBlockCacheSize(MAX_SYNC_BLOCK_CACHE << 20);
+
+    // Blocks after the furthest one asked for are read ahead.
+    SyncBlockReader read_ahead_reader{chainstate, /*cache_bytes=*/MAX_SYNC_BLOCK_CACHE << 20, /*read_ahead_blocks=*/5};
+    BOOST_REQUIRE(read_ahead_reader.Read(*block_at(30)));
+    for (int height{31}; height <= 35; ++height) {
+        for (int i{0}; i < 1000 && !read_ahead_reader.IsCached(*block_at(height)); ++i) UninterruptibleSleep(10ms);
+        BOOST_CHECK(read_ahead_reader.IsCached(*block_at(height)));
+    }
+    BOOST_CHECK(!read_ahead_reader.IsCached(*block_at(36)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,11 +6,13 @@
 #include <policy/policy.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
+#include <util/feefrac.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <set>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -115,18 +117,48 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
     BOOST_CHECK_EQUAL(testPool.size(), 0U);
 }
 
-template <typename name>
-static void CheckSort(CTxMemPool& pool, std::vector<std::string>& sortedOrder) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+/** Return the chunks of the cluster containing txid, as sets of txids. */
+static std::vector<std::set<Txid>> ClusterChunks(const CTxMemPool& pool, const Txid& txid) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
-    BOOST_CHECK_EQUAL(pool.size(), sortedOrder.size());
-    typename CTxMemPool::indexed_transaction_set::index<name>::type::iterator it = pool.mapTx.get<name>().begin();
-    int count = 0;
-    for (; it != pool.mapTx.get<name>().end(); ++it, ++count) {
-        BOOST_CHECK_EQUAL(it->GetTx().GetHash().ToString(), sortedOrder[count]);
+    for (const auto& cluster : pool.GetClusterChunks()) {
+        std::vector<std::set<Txid>> chunks;
+        bool found{false};
+        for (const CTxMemPool::Chunk& chunk : cluster) {
+            FeeFrac feerate;
+            chunks.emplace_back();
+            for (const CTxMemPool::txiter& it : chunk.txs) {
+                feerate += FeeFrac{it->GetModifiedFee(), it->GetTxSize()};
+                chunks.back().insert(it->GetTx().GetHash());
+                found |= it->GetTx().GetHash() == txid;
+            }
+            BOOST_CHECK(feerate == chunk.feerate);
+        }
+        if (found) return chunks;
     }
+    return {};
 }
 
-BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
+/** Return the txids in the order they would be mined: by decreasing chunk feerate, ties broken by
+ * the txid of the first transaction of the chunk. */
+static std::vector<std::string> MiningOrder(const CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    std::vector<CTxMemPool::Chunk> chunks;
+    for (const auto& cluster : pool.GetClusterChunks()) {
+        chunks.insert(chunks.end(), cluster.begin(), cluster.end());
+    }
+    std::stable_sort(chunks.begin(), chunks.end(), [](const CTxMemPool::Chunk& a, const CTxMemPool::Chunk& b) {
+        const auto cmp{FeeRateCompare(a.feerate, b.feerate)};
+        if (cmp != 0) return cmp > 0;
+        return a.txs.front()->GetTx().GetHash() < b.txs.front()->GetTx().GetHash();
+    });
+    std::vector<std::string> order;
+    for (const CTxMemPool::Chunk& chunk : chunks) {
+        for (const CTxMemPool::txiter& it : chunk.txs) order.push_back(it->GetTx().GetHash().ToString());
+    }
+    return order;
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterTest)
 {
     CTxMemPool& pool = *Assert(m_node.mempool);
     LOCK2(cs_main, pool.cs);
@@ -153,30 +185,11 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     tx3.vout[0].nValue = 5 * COIN;
     pool.addUnchecked(entry.Fee(0LL).FromTx(tx3));
 
-    /* 2nd highest fee */
-    CMutableTransaction tx4 = CMutableTransaction();
-    tx4.vout.resize(1);
-    tx4.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
-    tx4.vout[0].nValue = 6 * COIN;
-    pool.addUnchecked(entry.Fee(15000LL).FromTx(tx4));
-
-    /* equal fee rate to tx1, but newer */
-    CMutableTransaction tx5 = CMutableTransaction();
-    tx5.vout.resize(1);
-    tx5.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
-    tx5.vout[0].nValue = 11 * COIN;
-    entry.time = NodeSeconds{1s};
-    pool.addUnchecked(entry.Fee(10000LL).FromTx(tx5));
-    BOOST_CHECK_EQUAL(pool.size(), 5U);
-
-    std::vector<std::string> sortedOrder;
-    sortedOrder.resize(5);
-    sortedOrder[0] = tx3.GetHash().ToString(); // 0
-    sortedOrder[1] = tx5.GetHash().ToString(); // 10000
-    sortedOrder[2] = tx1.GetHash().ToString(); // 10000
-    sortedOrder[3] = tx4.GetHash().ToString(); // 15000
-    sortedOrder[4] = tx2.GetHash().ToString(); // 20000
-    CheckSort<descendant_score>(pool, sortedOrder);
+    // Unrelated transactions are clusters of their own
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 3U);
+    for (const auto& tx : {tx1, tx2, tx3}) {
+        BOOST_CHECK((ClusterChunks(pool, tx.GetHash()) == std::vector<std::set<Txid>>{{tx.GetHash()}}));
+    }
 
     /* low fee but with high fee child */
     /* tx6 -> tx7 -> tx8, tx9 -> tx10 */
@@ -185,10 +198,7 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     tx6.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
     tx6.vout[0].nValue = 20 * COIN;
     pool.addUnchecked(entry.Fee(0LL).FromTx(tx6));
-    BOOST_CHECK_EQUAL(pool.size(), 6U);
-    // Check that at this point, tx6 is sorted low
-    sortedOrder.insert(sortedOrder.begin(), tx6.GetHash().ToString());
-    CheckSort<descendant_score>(pool, sortedOrder);
+    BOOST_CHECK_EQUAL(pool.size(), 4U);
 
     CTxMemPool::setEntries setAncestors;
     setAncestors.insert(pool.GetIter(tx6.GetHash()).value());
@@ -201,19 +211,11 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     tx7.vout[0].nValue = 10 * COIN;
     tx7.vout[1].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
     tx7.vout[1].nValue = 1 * COIN;
+    pool.addUnchecked(entry.Fee(2000000LL).FromTx(tx7), setAncestors);
 
-    auto ancestors_calculated{pool.CalculateMemPoolAncestors(entry.Fee(2000000LL).FromTx(tx7), CTxMemPool::Limits::NoLimits())};
-    BOOST_REQUIRE(ancestors_calculated.has_value());
-    BOOST_CHECK(*ancestors_calculated == setAncestors);
-
-    pool.addUnchecked(entry.FromTx(tx7), setAncestors);
-    BOOST_CHECK_EQUAL(pool.size(), 7U);
-
-    // Now tx6 should be sorted higher (high fee child): tx7, tx6, tx2, ...
-    sortedOrder.erase(sortedOrder.begin());
-    sortedOrder.push_back(tx6.GetHash().ToString());
-    sortedOrder.push_back(tx7.GetHash().ToString());
-    CheckSort<descendant_score>(pool, sortedOrder);
+    // The child pays for its parent, so they form a single chunk
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 4U);
+    BOOST_CHECK((ClusterChunks(pool, tx6.GetHash()) == std::vector<std::set<Txid>>{{tx6.GetHash(), tx7.GetHash()}}));
 
     /* low fee child of tx7 */
     CMutableTransaction tx8 = CMutableTransaction();
@@ -226,9 +228,8 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     setAncestors.insert(pool.GetIter(tx7.GetHash()).value());
     pool.addUnchecked(entry.Fee(0LL).Time(NodeSeconds{2s}).FromTx(tx8), setAncestors);
 
-    // Now tx8 should be sorted low, but tx6/tx both high
-    sortedOrder.insert(sortedOrder.begin(), tx8.GetHash().ToString());
-    CheckSort<descendant_score>(pool, sortedOrder);
+    // A low fee child comes in a chunk of its own
+    BOOST_CHECK((ClusterChunks(pool, tx8.GetHash()) == std::vector<std::set<Txid>>{{tx6.GetHash(), tx7.GetHash()}, {tx8.GetHash()}}));
 
     /* low fee child of tx7 */
     CMutableTransaction tx9 = CMutableTransaction();
@@ -239,13 +240,12 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     tx9.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
     tx9.vout[0].nValue = 1 * COIN;
     pool.addUnchecked(entry.Fee(0LL).Time(NodeSeconds{3s}).FromTx(tx9), setAncestors);
+    BOOST_CHECK_EQUAL(pool.size(), 7U);
 
-    // tx9 should be sorted low
-    BOOST_CHECK_EQUAL(pool.size(), 9U);
-    sortedOrder.insert(sortedOrder.begin(), tx9.GetHash().ToString());
-    CheckSort<descendant_score>(pool, sortedOrder);
-
-    std::vector<std::string> snapshotOrder = sortedOrder;
+    auto chunks{ClusterChunks(pool, tx9.GetHash())};
+    BOOST_REQUIRE_EQUAL(chunks.size(), 3U);
+    BOOST_CHECK((chunks[0] == std::set<Txid>{tx6.GetHash(), tx7.GetHash()}));
+    BOOST_CHECK((std::set<std::set<Txid>>{chunks[1], chunks[2]} == std::set<std::set<Txid>>{{tx8.GetHash()}, {tx9.GetHash()}}));
 
     setAncestors.insert(pool.GetIter(tx8.GetHash()).value());
     setAncestors.insert(pool.GetIter(tx9.GetHash()).value());
@@ -259,46 +259,142 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     tx10.vout.resize(1);
     tx10.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
     tx10.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(entry.Fee(200000LL).Time(NodeSeconds{4s}).FromTx(tx10), setAncestors);
 
-    ancestors_calculated = pool.CalculateMemPoolAncestors(entry.Fee(200000LL).Time(NodeSeconds{4s}).FromTx(tx10), CTxMemPool::Limits::NoLimits());
-    BOOST_REQUIRE(ancestors_calculated);
-    BOOST_CHECK(*ancestors_calculated == setAncestors);
-
-    pool.addUnchecked(entry.FromTx(tx10), setAncestors);
-
-    /**
-     *  tx8 and tx9 should both now be sorted higher
-     *  Final order after tx10 is added:
-     *
-     *  tx3 = 0 (1)
-     *  tx5 = 10000 (1)
-     *  tx1 = 10000 (1)
-     *  tx4 = 15000 (1)
-     *  tx2 = 20000 (1)
-     *  tx9 = 200k (2 txs)
-     *  tx8 = 200k (2 txs)
-     *  tx10 = 200k (1 tx)
-     *  tx6 = 2.2M (5 txs)
-     *  tx7 = 2.2M (4 txs)
-     */
-    sortedOrder.erase(sortedOrder.begin(), sortedOrder.begin()+2); // take out tx9, tx8 from the beginning
-    sortedOrder.insert(sortedOrder.begin()+5, tx9.GetHash().ToString());
-    sortedOrder.insert(sortedOrder.begin()+6, tx8.GetHash().ToString());
-    sortedOrder.insert(sortedOrder.begin()+7, tx10.GetHash().ToString()); // tx10 is just before tx6
-    CheckSort<descendant_score>(pool, sortedOrder);
-
-    // there should be 10 transactions in the mempool
-    BOOST_CHECK_EQUAL(pool.size(), 10U);
-
-    // Now try removing tx10 and verify the sort order returns to normal
+    // tx10 pays for both of its parents
+    BOOST_CHECK((ClusterChunks(pool, tx10.GetHash()) == std::vector<std::set<Txid>>{{tx6.GetHash(), tx7.GetHash()}, {tx8.GetHash(), tx9.GetHash(), tx10.GetHash()}}));
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 4U);
+
+    // Removing tx10 splits its chunk up again
     pool.removeRecursive(*Assert(pool.get(tx10.GetHash())), REMOVAL_REASON_DUMMY);
-    CheckSort<descendant_score>(pool, snapshotOrder);
+    chunks = ClusterChunks(pool, tx6.GetHash());
+    BOOST_REQUIRE_EQUAL(chunks.size(), 3U);
+    BOOST_CHECK((std::set<std::set<Txid>>{chunks[1], chunks[2]} == std::set<std::set<Txid>>{{tx8.GetHash()}, {tx9.GetHash()}}));
+
+    // Mining tx6 and tx7 splits the cluster
+    pool.removeForBlock({MakeTransactionRef(tx6), MakeTransactionRef(tx7)}, 1);
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 5U);
+    BOOST_CHECK((ClusterChunks(pool, tx8.GetHash()) == std::vector<std::set<Txid>>{{tx8.GetHash()}}));
+    BOOST_CHECK((ClusterChunks(pool, tx9.GetHash()) == std::vector<std::set<Txid>>{{tx9.GetHash()}}));
+
+    // Prioritising a transaction changes the chunks of its cluster
+    CMutableTransaction tx11 = CMutableTransaction();
+    tx11.vin.resize(1);
+    tx11.vin[0].prevout = COutPoint(tx9.GetHash(), 0);
+    tx11.vin[0].scriptSig = CScript() << OP_11;
+    tx11.vout.resize(1);
+    tx11.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx11.vout[0].nValue = 1 * COIN;
+    pool.addUnchecked(entry.Fee(0LL).FromTx(tx11));
+    BOOST_CHECK((ClusterChunks(pool, tx11.GetHash()) == std::vector<std::set<Txid>>{{tx9.GetHash()}, {tx11.GetHash()}}));
+    pool.PrioritiseTransaction(tx11.GetHash(), 10000LL);
+    BOOST_CHECK((ClusterChunks(pool, tx11.GetHash()) == std::vector<std::set<Txid>>{{tx9.GetHash(), tx11.GetHash()}}));
+    pool.PrioritiseTransaction(tx11.GetHash(), -10000LL);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterLimitTest)
+{
+    auto options{MemPoolOptionsForTest(m_node)};
+    options.limits.cluster_count = 4;
+    CTxMemPool pool{options};
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
 
-    pool.removeRecursive(*Assert(pool.get(tx9.GetHash())), REMOVAL_REASON_DUMMY);
-    pool.removeRecursive(*Assert(pool.get(tx8.GetHash())), REMOVAL_REASON_DUMMY);
+    int n{0};
+    const auto make_tx{[&](const std::vector<CTransactionRef>& parents) {
+        CMutableTransaction tx;
+        for (const auto& parent : parents) {
+            tx.vin.emplace_back(COutPoint{parent->GetHash(), 0}, CScript() << OP_11);
+        }
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = ++n * COIN;
+        return MakeTransactionRef(tx);
+    }};
+
+    // A chain a -> b -> c -> d, and e on its own
+    const auto a{make_tx({})};
+    const auto b{make_tx({a})};
+    const auto c{make_tx({b})};
+    const auto d{make_tx({c})};
+    const auto e{make_tx({})};
+    for (const auto& tx : {a, b, c, d, e}) pool.addUnchecked(entry.FromTx(tx));
+    const CTxMemPool::setEntries replaced{*pool.GetIter(a->GetHash())};
+
+    auto result{pool.CheckClusterLimits({make_tx({d})}, 100, {})};
+    BOOST_REQUIRE(!result);
+    BOOST_CHECK_EQUAL(util::ErrorString(result).original, "cluster count 5 exceeds limit [limit: 4]");
+    // Transactions that are replaced make room
+    BOOST_CHECK(pool.CheckClusterLimits({make_tx({d})}, 100, replaced));
+    BOOST_CHECK(pool.CheckClusterLimits({make_tx({e})}, 100, {}));
+    // Merging clusters counts all of them
+    BOOST_CHECK(!pool.CheckClusterLimits({make_tx({d, e})}, 100, replaced));
+    // So does a package, which ends up in a single cluster
+    const auto child{make_tx({e})};
+    BOOST_CHECK(pool.CheckClusterLimits({child, make_tx({child})}, 200, {}));
+    BOOST_CHECK(!pool.CheckClusterLimits({child, make_tx({child}), make_tx({child}), make_tx({child})}, 400, {}));
+
+    // The virtual size of the cluster counts as well
+    result = pool.CheckClusterLimits({make_tx({e})}, options.limits.cluster_size_vbytes, {});
+    BOOST_REQUIRE(!result);
+    BOOST_CHECK_EQUAL(util::ErrorString(result).original, strprintf("cluster size %u exceeds limit [limit: %u]",
+                                                                    options.limits.cluster_size_vbytes + (*pool.GetIter(e->GetHash()))->GetTxSize(), options.limits.cluster_size_vbytes));
+
+    // Removed transactions stop counting right away, before the cluster is linearized again
+    pool.removeForBlock({a}, 1);
+    BOOST_CHECK(pool.CheckClusterLimits({make_tx({d})}, 100, {}));
+    std::set<Txid> cluster;
+    for (const auto& chunk : ClusterChunks(pool, d->GetHash())) cluster.insert(chunk.begin(), chunk.end());
+    BOOST_CHECK((cluster == std::set<Txid>{b->GetHash(), c->GetHash(), d->GetHash()}));
 }
 
-BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
+BOOST_AUTO_TEST_CASE(MempoolLinkUsageTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    int n{0};
+    const auto make_tx{[&](const std::vector<CTransactionRef>& parents) {
+        CMutableTransaction tx;
+        for (const auto& parent : parents) {
+            tx.vin.emplace_back(COutPoint{parent->GetHash(), ++n}, CScript() << OP_11);
+        }
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = ++n * COIN;
+        return MakeTransactionRef(tx);
+    }};
+    const auto link_usage{[&](const CTransactionRef& tx) {
+        const auto it{*pool.GetIter(tx->GetHash())};
+        return it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
+    }};
+
+    // A chain a -> b -> c only has one parent and child per entry, which are stored inline
+    const auto a{make_tx({})};
+    const auto b{make_tx({a})};
+    const auto c{make_tx({b})};
+    for (const auto& tx : {a, b, c}) pool.addUnchecked(entry.FromTx(tx));
+    for (const auto& tx : {a, b, c}) BOOST_CHECK_EQUAL(link_usage(tx), 0U);
+
+    // A second child of a and parent of c takes them onto the heap, which the pool accounts for
+    const size_t usage{pool.DynamicMemoryUsage()};
+    const auto d{make_tx({a})};
+    pool.addUnchecked(entry.FromTx(d));
+    BOOST_CHECK_GT(link_usage(a), 0U);
+    BOOST_CHECK_EQUAL(link_usage(d), 0U);
+    const size_t d_usage{pool.DynamicMemoryUsage() - usage};
+    const auto e{make_tx({c, d})};
+    pool.addUnchecked(entry.FromTx(e));
+    BOOST_CHECK_GT(link_usage(e), 0U);
+    BOOST_CHECK_GT(pool.DynamicMemoryUsage() - usage, d_usage + link_usage(e));
+
+    // Removing the links releases their memory again
+    pool.removeRecursive(*d, MemPoolRemovalReason::REPLACED);
+    for (const auto& tx : {a, b, c}) BOOST_CHECK_EQUAL(link_usage(tx), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolMiningOrderTest)
 {
     CTxMemPool& pool = *Assert(m_node.mempool);
     LOCK2(cs_main, pool.cs);
@@ -357,7 +453,7 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
     }
     sortedOrder[4] = tx3.GetHash().ToString(); // 0
 
-    CheckSort<ancestor_score>(pool, sortedOrder);
+    BOOST_CHECK(MiningOrder(pool) == sortedOrder);
 
     /* low fee parent with high fee child */
     /* tx6 (0) -> tx7 (high) */
@@ -375,7 +471,7 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
     else
         sortedOrder.insert(sortedOrder.end()-1,tx6.GetHash().ToString());
 
-    CheckSort<ancestor_score>(pool, sortedOrder);
+    BOOST_CHECK(MiningOrder(pool) == sortedOrder);
 
     CMutableTransaction tx7 = CMutableTransaction();
     tx7.vin.resize(1);
@@ -391,22 +487,20 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
 
     pool.addUnchecked(entry.Fee(fee).FromTx(tx7));
     BOOST_CHECK_EQUAL(pool.size(), 7U);
-    sortedOrder.insert(sortedOrder.begin()+1, tx7.GetHash().ToString());
-    CheckSort<ancestor_score>(pool, sortedOrder);
+    // tx6 is mined together with tx7, right after tx2
+    sortedOrder.erase(std::find(sortedOrder.begin(), sortedOrder.end(), tx6.GetHash().ToString()));
+    sortedOrder.insert(sortedOrder.begin()+1, tx6.GetHash().ToString());
+    sortedOrder.insert(sortedOrder.begin()+2, tx7.GetHash().ToString());
+    BOOST_CHECK(MiningOrder(pool) == sortedOrder);
 
     /* after tx6 is mined, tx7 should move up in the sort */
     std::vector<CTransactionRef> vtx;
     vtx.push_back(MakeTransactionRef(tx6));
     pool.removeForBlock(vtx, 1);
 
-    sortedOrder.erase(sortedOrder.begin()+1);
-    // Ties are broken by hash
-    if (tx3.GetHash() < tx6.GetHash())
-        sortedOrder.pop_back();
-    else
-        sortedOrder.erase(sortedOrder.end()-2);
+    sortedOrder.erase(sortedOrder.begin()+1, sortedOrder.begin()+3);
     sortedOrder.insert(sortedOrder.begin(), tx7.GetHash().ToString());
-    CheckSort<ancestor_score>(pool, sortedOrder);
+    BOOST_CHECK(MiningOrder(pool) == sortedOrder);
 
     // High-fee parent, low-fee child
     // tx7 -> tx8
@@ -418,15 +512,14 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
     tx8.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
     tx8.vout[0].nValue = 10*COIN;
 
-    // Check that we sort by min(feerate, ancestor_feerate):
-    // set the fee so that the ancestor feerate is above tx1/5,
+    // Check that the child is mined at its own feerate:
+    // set the fee so that the feerate with its parent is above tx1/5,
     // but the transaction's own feerate is lower
     pool.addUnchecked(entry.Fee(5000LL).FromTx(tx8));
     sortedOrder.insert(sortedOrder.end()-1, tx8.GetHash().ToString());
-    CheckSort<ancestor_score>(pool, sortedOrder);
+    BOOST_CHECK(MiningOrder(pool) == sortedOrder);
 }
 
-
 BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
 {
     auto& pool = static_cast<MemPoolTest&>(*Assert(m_node.mempool));
@@ -543,7 +636,7 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
         pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
     pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
 
-    pool.TrimToSize(pool.DynamicMemoryUsage() / 2); // should maximize mempool size by only removing 5/7
+    pool.TrimToSize(pool.DynamicMemoryUsage() * 3 / 5); // should maximize mempool size by only removing 5/7
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx4.GetHash())));
     BOOST_CHECK(!pool.exists(GenTxid::Txid(tx5.GetHash())));
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx6.GetHash())));
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/mpmcqueue.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(mpmcqueue_tests)
+
+BOOST_AUTO_TEST_CASE(bounded_fifo)
+{
+    MPMCQueue<std::unique_ptr<int>> queue{3};
+    BOOST_CHECK_EQUAL(queue.Capacity(), 3U);
+    BOOST_CHECK(!queue.TryPop());
+
+    // Wrap around the ring a few times
+    for (int round{0}; round < 4; ++round) {
+        for (int i{0}; i < 3; ++i) {
+            auto value{std::make_unique<int>(round * 3 + i)};
+            BOOST_CHECK(queue.TryPush(value));
+            BOOST_CHECK(!value);
+        }
+        // A failed push leaves the value with the caller
+        auto extra{std::make_unique<int>(-1)};
+        BOOST_CHECK(!queue.TryPush(extra));
+        BOOST_CHECK(extra);
+
+        for (int i{0}; i < 3; ++i) {
+            const auto value{queue.TryPop()};
+            BOOST_REQUIRE(value);
+            BOOST_CHECK_EQUAL(**value, round * 3 + i);
+        }
+        BOOST_CHECK(!queue.TryPop());
+    }
+
+    BOOST_CHECK_EQUAL(MPMCQueue<int>{1}.Capacity(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    constexpr int PRODUCERS{4};
+    constexpr int CONSUMERS{4};
+    constexpr int ITEMS_PER_PRODUCER{10000};
+    MPMCQueue<int> queue{64};
+    std::atomic<int> popped{0};
+    std::atomic<int64_t> sum{0};
+
+    std::vector<std::thread> threads;
+    for (int p{0}; p < PRODUCERS; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i{0}; i < ITEMS_PER_PRODUCER; ++i) {
+                int value{p * ITEMS_PER_PRODUCER + i};
+                while (!queue.TryPush(value)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c{0}; c < CONSUMERS; ++c) {
+        threads.emplace_back([&] {
+            while (popped < PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (const auto value{queue.TryPop()}) {
+                    sum += *value;
+                    ++popped;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // Every element was popped exactly once
+    constexpr int64_t n{PRODUCERS * ITEMS_PER_PRODUCER};
+    BOOST_CHECK_EQUAL(popped.load(), n);
+    BOOST_CHECK_EQUAL(sum.load(), n * (n - 1) / 2);
+    BOOST_CHECK(!queue.TryPop());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
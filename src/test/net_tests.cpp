@@ -16,6 +16,7 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <test/util/net.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <test/util/validation.h>
@@ -28,6 +29,7 @@
 
 #include <algorithm>
 #include <ios>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -1100,11 +1102,24 @@ public:
                     progress = true;
                 }
             }
-            // Receive bytes from the transport.
-            const auto& [recv_bytes, _more, _msg_type] = m_transport.GetBytesToSend(!m_msg_to_send.empty());
-            if (!recv_bytes.empty() && (!progress || InsecureRandBool())) {
-                size_t to_receive = 1 + InsecureRandRange(recv_bytes.size());
-                m_received.insert(m_received.end(), recv_bytes.begin(), recv_bytes.begin() + to_receive);
+            // Receive bytes from the transport, from either the next bytes to send or all of them.
+            std::vector<Transport::SendBuffer> recv_buffers;
+            if (InsecureRandBool()) {
+                m_transport.GetSendBuffers(!m_msg_to_send.empty(), recv_buffers);
+            } else {
+                const auto& [recv_bytes, _more, msg_type] = m_transport.GetBytesToSend(!m_msg_to_send.empty());
+                if (!recv_bytes.empty()) recv_buffers.push_back({recv_bytes, msg_type});
+            }
+            size_t recv_size{0};
+            for (const auto& [recv_bytes, _msg_type] : recv_buffers) recv_size += recv_bytes.size();
+            if (recv_size > 0 && (!progress || InsecureRandBool())) {
+                size_t to_receive = 1 + InsecureRandRange(recv_size);
+                size_t left{to_receive};
+                for (const auto& [recv_bytes, _msg_type] : recv_buffers) {
+                    const size_t len{std::min(left, recv_bytes.size())};
+                    m_received.insert(m_received.end(), recv_bytes.begin(), recv_bytes.begin() + len);
+                    left -= len;
+                }
                 progress = true;
                 m_transport.MarkBytesSent(to_receive);
             }
@@ -1345,6 +1360,64 @@ public:
 
 } // namespace
 
+BOOST_AUTO_TEST_CASE(v1transport_send_batch)
+{
+    V1Transport sender{0}, receiver{1};
+
+    // Queue messages until the transport has as many as it batches.
+    std::vector<CSerializedNetMsg> expected;
+    while (true) {
+        CSerializedNetMsg msg;
+        msg.m_type = InsecureRandBool() ? "inv" : "tx";
+        msg.data = g_insecure_rand_ctx.randbytes<uint8_t>(InsecureRandRange(4000));
+        CSerializedNetMsg copy{msg.Copy()};
+        if (!sender.SetMessageToSend(msg)) break;
+        expected.push_back(std::move(copy));
+    }
+    BOOST_CHECK_LE(expected.size(), Transport::MAX_SEND_BATCH_MESSAGES);
+    BOOST_CHECK_GT(expected.size(), 1U);
+
+    // The buffers hold the header and payload of every message, starting with the bytes that
+    // GetBytesToSend() returns.
+    std::vector<Transport::SendBuffer> buffers;
+    BOOST_CHECK(!sender.GetSendBuffers(/*have_next_message=*/false, buffers));
+    BOOST_CHECK(sender.GetSendBuffers(/*have_next_message=*/true, buffers));
+    BOOST_CHECK(buffers.front().data == std::get<0>(sender.GetBytesToSend(false)));
+    std::vector<uint8_t> wire;
+    for (const auto& [data, msg_type] : buffers) {
+        BOOST_CHECK(!data.empty());
+        wire.insert(wire.end(), data.begin(), data.end());
+    }
+
+    // Sending part of them leaves the rest in the buffers.
+    const size_t sent{1 + InsecureRandRange(wire.size() - 1)};
+    sender.MarkBytesSent(sent);
+    sender.GetSendBuffers(/*have_next_message=*/false, buffers);
+    std::vector<uint8_t> rest;
+    for (const auto& [data, msg_type] : buffers) rest.insert(rest.end(), data.begin(), data.end());
+    BOOST_CHECK(Span{rest} == Span{wire}.subspan(sent));
+    sender.MarkBytesSent(rest.size());
+    BOOST_CHECK(std::get<0>(sender.GetBytesToSend(false)).empty());
+    BOOST_CHECK_EQUAL(sender.GetSendMemoryUsage(), 0U);
+
+    // The bytes decode to the messages in order.
+    Span<const uint8_t> to_recv{wire};
+    size_t received{0};
+    while (!to_recv.empty()) {
+        BOOST_REQUIRE(receiver.ReceivedBytes(to_recv));
+        if (receiver.ReceivedMessageComplete()) {
+            bool reject{false};
+            CNetMessage msg{receiver.GetReceivedMessage({}, reject)};
+            BOOST_REQUIRE(!reject);
+            BOOST_REQUIRE_LT(received, expected.size());
+            BOOST_CHECK_EQUAL(msg.m_type, expected[received].m_type);
+            BOOST_CHECK(MakeByteSpan(msg.m_recv) == MakeByteSpan(expected[received].data));
+            ++received;
+        }
+    }
+    BOOST_CHECK_EQUAL(received, expected.size());
+}
+
 BOOST_AUTO_TEST_CASE(v2transport_test)
 {
     // A mostly normal scenario, testing a transport in initiator mode.
@@ -1547,6 +1620,36 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
         tester.ReceiveMessage(uint8_t(3), msg_data_2); // "blocktxn" short id
     }
 
+    // Send many messages at once, which the transport batches.
+    for (int i = 0; i < 10; ++i) {
+        V2TransportTester tester(InsecureRandBool());
+        tester.SendKey();
+        tester.SendGarbage();
+        auto ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveKey();
+        tester.SendGarbageTerm();
+        tester.SendVersion();
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveGarbage();
+        tester.ReceiveVersion();
+        std::vector<std::vector<uint8_t>> msg_data;
+        for (size_t m = 0; m < 2 * Transport::MAX_SEND_BATCH_MESSAGES; ++m) {
+            msg_data.push_back(g_insecure_rand_ctx.randbytes<uint8_t>(InsecureRandRange(2000)));
+            tester.AddMessage(m % 2 ? "inv" : "foobar", msg_data.back());
+        }
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        for (size_t m = 0; m < msg_data.size(); ++m) {
+            if (m % 2) {
+                tester.ReceiveMessage(uint8_t(14), msg_data[m]); // inv short id
+            } else {
+                tester.ReceiveMessage("foobar", msg_data[m]);
+            }
+        }
+    }
+
     // Send correct network's V1 header
     {
         V2TransportTester tester(false);
@@ -1564,4 +1667,154 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+namespace {
+
+/**
+ * A mocked socket that returns the given data on read and takes as many bytes as there is room
+ * for on write, which it reports as writable. Like all mocked sockets, it is waited on without
+ * epoll.
+ */
+class LimitedSendSock : public StaticContentsSock
+{
+public:
+    explicit LimitedSendSock(const std::string& contents) : StaticContentsSock{contents} {}
+
+    ssize_t SendMany(Span<const Span<const uint8_t>> data, int) const override
+    {
+        size_t len{0};
+        for (const auto& buf : data) {
+            const size_t take{std::min(buf.size(), m_room - len)};
+            m_sent.insert(m_sent.end(), buf.begin(), buf.begin() + take);
+            len += take;
+        }
+        m_room -= len;
+        return len;
+    }
+
+    bool WaitMany(std::chrono::milliseconds, EventsPerSock& events_per_sock) const override
+    {
+        for (auto& [sock, events] : events_per_sock) {
+            events.occurred = events.requested & ((m_room > 0 ? SEND : 0) | (m_readable ? RECV : 0));
+        }
+        return true;
+    }
+
+    mutable size_t m_room{std::numeric_limits<size_t>::max()};
+    bool m_readable{true};
+    mutable std::vector<uint8_t> m_sent;
+};
+
+/** The bytes a V1 transport sends for a message. */
+std::vector<uint8_t> V1Bytes(CSerializedNetMsg&& msg)
+{
+    V1Transport transport{/*node_id=*/0};
+    BOOST_REQUIRE(transport.SetMessageToSend(msg));
+    std::vector<uint8_t> ret;
+    while (true) {
+        const auto& [bytes, more, msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+        if (bytes.empty()) return ret;
+        ret.insert(ret.end(), bytes.begin(), bytes.end());
+        transport.MarkBytesSent(bytes.size());
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(socket_shard_optimistic_send)
+{
+    auto connman{std::make_unique<ConnmanTestMsg>(0x1337, 0x1337, *m_node.addrman, *m_node.netgroupman, Params())};
+    auto peerman{PeerManager::make(*connman, *m_node.addrman, nullptr, *m_node.chainman, *m_node.mempool, {})};
+    CConnman::Options options;
+    options.m_msgproc = peerman.get();
+    connman->Init(options);
+    connman->CreateSocketShards();
+
+    auto sock{std::make_shared<LimitedSendSock>("")};
+    sock->m_readable = false;
+    CNode* node{new CNode{/*id=*/0, sock, CAddress{}, /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0, CAddress{},
+                          /*addrNameIn=*/"", ConnectionType::INBOUND, /*inbound_onion=*/false}};
+    peerman->InitializeNode(*node, NODE_NETWORK);
+    connman->AddTestNode(*node);
+
+    // The socket is reported as writable once, with nothing to send yet.
+    connman->SocketHandlerPublic();
+
+    // A message pushed from another thread is sent right away, but only partly fits.
+    const std::vector<uint8_t> expected{V1Bytes(NetMsg::Make(NetMsgType::PING, uint64_t{1}))};
+    sock->m_room = 10;
+    connman->PushMessage(node, NetMsg::Make(NetMsgType::PING, uint64_t{1}));
+    BOOST_CHECK_EQUAL(sock->m_sent.size(), 10U);
+
+    // The socket handler sends the rest, without the socket being reported as writable again.
+    sock->m_room = std::numeric_limits<size_t>::max();
+    connman->SocketHandlerPublic();
+    BOOST_CHECK(sock->m_sent == expected);
+
+    peerman->FinalizeNode(*node);
+    connman->ClearTestNodes();
+}
+
+BOOST_AUTO_TEST_CASE(socket_shards)
+{
+    auto connman{std::make_unique<ConnmanTestMsg>(0x1337, 0x1337, *m_node.addrman, *m_node.netgroupman, Params())};
+    auto peerman{PeerManager::make(*connman, *m_node.addrman, nullptr, *m_node.chainman, *m_node.mempool, {})};
+    CConnman::Options options;
+    options.m_msgproc = peerman.get();
+    options.socket_threads = 2;
+    connman->Init(options);
+    connman->CreateSocketShards();
+
+    // Each node receives a ping, which its mocked socket returns before the end of the stream.
+    const std::vector<uint8_t> ping{V1Bytes(NetMsg::Make(NetMsgType::PING, uint64_t{1}))};
+    std::vector<std::shared_ptr<LimitedSendSock>> socks;
+    std::vector<CNode*> nodes;
+    for (NodeId id{0}; id < 2; ++id) {
+        socks.push_back(std::make_shared<LimitedSendSock>(std::string{ping.begin(), ping.end()}));
+        nodes.push_back(new CNode{id, socks.back(), CAddress{}, /*nKeyedNetGroupIn=*/0, /*nLocalHostNonceIn=*/0, CAddress{},
+                                  /*addrNameIn=*/"", ConnectionType::INBOUND, /*inbound_onion=*/false});
+        peerman->InitializeNode(*nodes.back(), NODE_NETWORK);
+        // The reference of the connection manager, as AcceptConnection() takes it
+        nodes.back()->AddRef();
+        connman->AddTestNode(*nodes.back());
+        BOOST_CHECK_EQUAL(nodes.back()->m_sock_shard, static_cast<size_t>(id));
+    }
+
+    // A shard only serves its own node.
+    for (size_t shard{0}; shard < 2; ++shard) {
+        BOOST_CHECK(!nodes[shard]->PollMessage());
+        connman->SocketHandlerPublic(shard);
+        const auto msg{nodes[shard]->PollMessage()};
+        BOOST_REQUIRE(msg);
+        BOOST_CHECK_EQUAL(msg->first.m_type, NetMsgType::PING);
+        if (shard == 0) BOOST_CHECK(!nodes[1]->PollMessage());
+    }
+
+    // Both nodes send a reply.
+    const std::vector<uint8_t> pong{V1Bytes(NetMsg::Make(NetMsgType::PONG, uint64_t{1}))};
+    for (size_t i{0}; i < 2; ++i) {
+        connman->PushMessage(nodes[i], NetMsg::Make(NetMsgType::PONG, uint64_t{1}));
+        BOOST_CHECK(socks[i]->m_sent == pong);
+    }
+
+    // The end of the stream disconnects a node. It is only deleted once its own shard has stopped
+    // serving it, which running the other shard doesn't do.
+    connman->SocketHandlerPublic(0);
+    BOOST_CHECK(nodes[0]->fDisconnect);
+    BOOST_CHECK(!nodes[1]->fDisconnect);
+    connman->DisconnectNodesPublic();
+    BOOST_CHECK_EQUAL(connman->NumDisconnectedNodes(), 1U);
+    BOOST_CHECK_EQUAL(connman->TestNodes().size(), 1U);
+    connman->SocketHandlerPublic(1);
+    BOOST_CHECK(nodes[1]->fDisconnect);
+    connman->DisconnectNodesPublic();
+    BOOST_CHECK_EQUAL(connman->NumDisconnectedNodes(), 2U);
+    connman->SocketHandlerPublic(0);
+    connman->DisconnectNodesPublic();
+    BOOST_CHECK_EQUAL(connman->NumDisconnectedNodes(), 1U);
+    connman->SocketHandlerPublic(1);
+    connman->DisconnectNodesPublic();
+    BOOST_CHECK_EQUAL(connman->NumDisconnectedNodes(), 0U);
+    BOOST_CHECK(connman->TestNodes().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,13 +4,20 @@
 
 #include <chainparams.h>
 #include <node/miner.h>
+#include <net.h>
 #include <net_processing.h>
+#include <netmessagemaker.h>
 #include <pow.h>
+#include <protocol.h>
+#include <test/util/net.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <future>
+
 BOOST_FIXTURE_TEST_SUITE(peerman_tests, RegTestingSetup)
 
 /** Window, in blocks, for connecting to NODE_NETWORK_LIMITED peers */
@@ -73,4 +80,104 @@ BOOST_AUTO_TEST_CASE(connections_desirable_service_flags)
     BOOST_CHECK(peerman->GetDesirableServiceFlags(peer_flags) == ServiceFlags(NODE_NETWORK | NODE_WITNESS));
 }
 
+BOOST_AUTO_TEST_CASE(concurrent_message_processing)
+{
+    ConnmanTestMsg& connman{static_cast<ConnmanTestMsg&>(*m_node.connman)};
+    PeerManager& peerman{*m_node.peerman};
+    CNode node{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::INBOUND,
+               /*inbound_onion=*/false};
+    {
+        LOCK(NetEventsInterface::g_msgproc_mutex);
+        connman.Handshake(node,
+                          /*successfully_connected=*/true,
+                          /*remote_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                          /*local_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                          /*version=*/PROTOCOL_VERSION,
+                          /*relay_txs=*/true);
+    }
+
+    BOOST_CHECK(peerman.IsConcurrentMessage(NetMsgType::PING));
+    BOOST_CHECK(peerman.IsConcurrentMessage(NetMsgType::GETCFILTERS));
+    BOOST_CHECK(!peerman.IsConcurrentMessage(NetMsgType::TX));
+    BOOST_CHECK(!peerman.IsConcurrentMessage(NetMsgType::HEADERS));
+
+    // A ping that is next in line is answered without g_msgproc_mutex
+    BOOST_CHECK(!peerman.ProcessMessageConcurrently(&node));
+    connman.FlushSendBuffer(node);
+    BOOST_CHECK(connman.ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::PING, uint64_t{42})));
+    node.fPauseSend = false;
+    BOOST_CHECK(peerman.ProcessMessageConcurrently(&node));
+    BOOST_CHECK(!node.PollMessage());
+    {
+        const auto& [to_send, _more, msg_type] = node.m_transport->GetBytesToSend(/*have_next_message=*/false);
+        BOOST_CHECK(!to_send.empty());
+        BOOST_CHECK_EQUAL(msg_type, NetMsgType::PONG);
+    }
+    connman.FlushSendBuffer(node);
+
+    // A ping behind a message that has to be processed by the message handler is left to it, so
+    // that the peer's messages are processed in order
+    BOOST_CHECK(connman.ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::SENDHEADERS)));
+    BOOST_CHECK(connman.ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::PING, uint64_t{43})));
+    node.fPauseSend = false;
+    BOOST_CHECK(!peerman.ProcessMessageConcurrently(&node));
+    {
+        LOCK(NetEventsInterface::g_msgproc_mutex);
+        connman.ProcessMessagesOnce(node);
+    }
+    BOOST_CHECK(peerman.ProcessMessageConcurrently(&node));
+    BOOST_CHECK(!node.PollMessage());
+
+    peerman.FinalizeNode(node);
+}
+
+BOOST_AUTO_TEST_CASE(ping_while_message_handler_busy)
+{
+    ConnmanTestMsg& connman{static_cast<ConnmanTestMsg&>(*m_node.connman)};
+    PeerManager& peerman{*m_node.peerman};
+    CNode node{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::INBOUND,
+               /*inbound_onion=*/false};
+    {
+        LOCK(NetEventsInterface::g_msgproc_mutex);
+        connman.Handshake(node,
+                          /*successfully_connected=*/true,
+                          /*remote_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                          /*local_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                          /*version=*/PROTOCOL_VERSION,
+                          /*relay_txs=*/true);
+    }
+    connman.FlushSendBuffer(node);
+    BOOST_CHECK(connman.ReceiveMsgFrom(node, NetMsg::Make(NetMsgType::PING, uint64_t{42})));
+    node.fPauseSend = false;
+
+    // While the message handler thread is busy with another peer's message, holding
+    // g_msgproc_mutex and cs_main as it does to validate a block, a message pool thread
+    // answers the ping.
+    {
+        LOCK2(NetEventsInterface::g_msgproc_mutex, ::cs_main);
+        auto answered{std::async(std::launch::async, [&] { return peerman.ProcessMessageConcurrently(&node); })};
+        BOOST_REQUIRE(answered.wait_for(std::chrono::seconds{30}) == std::future_status::ready);
+        BOOST_CHECK(answered.get());
+        const auto& [to_send, _more, msg_type] = node.m_transport->GetBytesToSend(/*have_next_message=*/false);
+        BOOST_CHECK(!to_send.empty());
+        BOOST_CHECK_EQUAL(msg_type, NetMsgType::PONG);
+    }
+
+    peerman.FinalizeNode(node);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -14,6 +14,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+
 BOOST_FIXTURE_TEST_SUITE(policyestimator_tests, ChainTestingSetup)
 
 BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
@@ -264,4 +266,68 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(SmartFeeEstimates)
+{
+    CBlockPolicyEstimator& feeEst = *Assert(m_node.fee_estimator);
+    TestMemPoolEntryHelper entry;
+
+    // Confirm transactions paying 1000 * (j + 1) sat/vB after 10 - j blocks
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    std::vector<std::vector<RemovedMempoolTransactionInfo>> unconfirmed(11);
+    for (unsigned int height = 1; height <= 100; height++) {
+        std::vector<RemovedMempoolTransactionInfo> block;
+        std::swap(block, unconfirmed[height % unconfirmed.size()]);
+        feeEst.processBlock(block, height);
+
+        for (int j = 0; j < 10; j++) {
+            tx.vin[0].prevout.n = 100 * height + j;
+            const CTxMemPoolEntry tx_entry{entry.Fee(1000 * (j + 1) * GetVirtualTransactionSize(CTransaction(tx))).Height(height).FromTx(tx)};
+            feeEst.processTransaction(NewMempoolTransactionInfo{tx_entry.GetSharedTx(), tx_entry.GetFee(), tx_entry.GetTxSize(), height,
+                                                                /*mempool_limit_bypassed=*/false,
+                                                                /*submitted_in_package=*/false,
+                                                                /*chainstate_is_current=*/true,
+                                                                /*has_no_mempool_parents=*/true});
+            unconfirmed[(height + 10 - j) % unconfirmed.size()].emplace_back(tx_entry);
+        }
+    }
+
+    // The estimates right after the block, possibly computed on demand, are the
+    // same as the ones looked up once the background thread computed them.
+    std::vector<std::pair<CFeeRate, FeeCalculation>> estimates;
+    for (const bool conservative : {false, true}) {
+        for (int target = 0; target <= 1010; target++) {
+            FeeCalculation feeCalc;
+            const CFeeRate feeRate{feeEst.estimateSmartFee(target, &feeCalc, conservative)};
+            estimates.emplace_back(feeRate, feeCalc);
+        }
+    }
+    UninterruptibleSleep(std::chrono::milliseconds{100});
+    size_t i = 0;
+    for (const bool conservative : {false, true}) {
+        for (int target = 0; target <= 1010; target++) {
+            FeeCalculation feeCalc;
+            const CFeeRate feeRate{feeEst.estimateSmartFee(target, &feeCalc, conservative)};
+            const auto& [expectedFeeRate, expectedFeeCalc] = estimates[i++];
+            BOOST_CHECK(feeRate == expectedFeeRate);
+            BOOST_CHECK(feeCalc.reason == expectedFeeCalc.reason);
+            BOOST_CHECK_EQUAL(feeCalc.est.pass.start, expectedFeeCalc.est.pass.start);
+            BOOST_CHECK_EQUAL(feeCalc.est.fail.inMempool, expectedFeeCalc.est.fail.inMempool);
+            BOOST_CHECK_EQUAL(feeCalc.desiredTarget, target);
+            BOOST_CHECK_EQUAL(feeCalc.returnedTarget, expectedFeeCalc.returnedTarget);
+        }
+    }
+
+    FeeCalculation feeCalc;
+    BOOST_CHECK(feeEst.estimateSmartFee(0, &feeCalc, /*conservative=*/false) == CFeeRate(0));
+    BOOST_CHECK(feeEst.estimateSmartFee(1009, &feeCalc, /*conservative=*/false) == CFeeRate(0));
+    BOOST_CHECK(feeEst.estimateSmartFee(1, &feeCalc, /*conservative=*/false) != CFeeRate(0));
+    BOOST_CHECK_EQUAL(feeCalc.returnedTarget, 2);
+    // Targets beyond the data recorded so far are answered at the highest usable one
+    BOOST_CHECK(feeEst.estimateSmartFee(1000, &feeCalc, /*conservative=*/true) != CFeeRate(0));
+    BOOST_CHECK_LT(feeCalc.returnedTarget, 1000);
+    BOOST_CHECK_GT(feeCalc.returnedTarget, 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/json_stream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <test/util/setup_common.h>
@@ -14,6 +15,8 @@
 #include <util/time.h>
 
 #include <any>
+#include <string>
+#include <string_view>
 
 #include <boost/test/unit_test.hpp>
 
@@ -650,4 +653,35 @@ BOOST_AUTO_TEST_CASE(rpc_arg_helper)
     CheckRpc(params, UniValue{JSON(R"([5, "hello", 4, "test", true, 1.23, "world"])")}, check_named);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    const UniValue value{JSON(R"({"a": [1, "two", {"x\"y": null}, []], "b": {}, "c": true, "d": [[], [{}], 3.5]})")};
+
+    std::string out;
+    size_t chunks{0};
+    // Flush after every few bytes to check that chunks are handed to the sink in order
+    JSONStreamWriter writer{[&](std::string_view chunk) { out += chunk; ++chunks; }, /*flush_size=*/4};
+    BOOST_CHECK(!writer.Started());
+    writer.BeginObject();
+    writer.Key("a");
+    writer.BeginArray();
+    writer.Value(1);
+    writer.Value("two");
+    writer.Value(value["a"][2]);
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.KV("b", UniValue{UniValue::VOBJ});
+    UniValue rest{UniValue::VOBJ};
+    rest.pushKV("c", true);
+    rest.pushKV("d", value["d"]);
+    writer.Entries(rest);
+    writer.EndObject();
+    writer.Flush();
+
+    BOOST_CHECK(writer.Started());
+    BOOST_CHECK_EQUAL(out, value.write());
+    BOOST_CHECK_GT(chunks, 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,12 +6,15 @@
 #include <compat/compat.h>
 #include <test/util/setup_common.h>
 #include <util/sock.h>
+#include <util/sockevents.h>
 #include <util/threadinterrupt.h>
 
 #include <boost/test/unit_test.hpp>
 
 #include <cassert>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -169,6 +172,57 @@ BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
     receiver.join();
 }
 
+BOOST_AUTO_TEST_CASE(sock_events)
+{
+    int s[2];
+    CreateSocketPair(s);
+    auto sock0{std::make_shared<Sock>(s[0])};
+    auto sock1{std::make_shared<Sock>(s[1])};
+
+    SockEvents events;
+    std::vector<SockEvents::Ready> ready;
+    BOOST_CHECK(!events.Wait(0ms, ready));
+
+    // A new socket is reported as writable, once
+    events.Add(7, sock0);
+    BOOST_CHECK_EQUAL(events.Size(), 1U);
+    BOOST_REQUIRE(events.Wait(0ms, ready));
+    BOOST_REQUIRE_EQUAL(ready.size(), 1U);
+    BOOST_CHECK_EQUAL(ready[0].key, 7U);
+    BOOST_CHECK_EQUAL(ready[0].occurred, Sock::SEND);
+    BOOST_REQUIRE(events.Wait(0ms, ready));
+    BOOST_CHECK(ready.empty());
+
+    // Incoming data is reported until all of it was read and the socket is rearmed
+    BOOST_REQUIRE_EQUAL(sock1->Send("ab", 2, 0), 2);
+    BOOST_REQUIRE(events.Wait(1min, ready));
+    BOOST_REQUIRE_EQUAL(ready.size(), 1U);
+    BOOST_CHECK(ready[0].occurred & Sock::RECV);
+    char buf[10];
+    BOOST_CHECK_EQUAL(sock0->Recv(buf, sizeof(buf), MSG_DONTWAIT), 2);
+    BOOST_CHECK_EQUAL(sock0->Recv(buf, sizeof(buf), MSG_DONTWAIT), -1);
+    events.Rearm(7, Sock::RECV);
+    BOOST_REQUIRE(events.Wait(0ms, ready));
+    BOOST_CHECK(ready.empty());
+    BOOST_REQUIRE_EQUAL(sock1->Send("c", 1, 0), 1);
+    BOOST_REQUIRE(events.Wait(1min, ready));
+    BOOST_REQUIRE_EQUAL(ready.size(), 1U);
+    BOOST_CHECK(ready[0].occurred & Sock::RECV);
+
+    // Closing the other end is reported as an error
+    sock1.reset();
+    BOOST_REQUIRE(events.Wait(1min, ready));
+    BOOST_REQUIRE_EQUAL(ready.size(), 1U);
+    BOOST_CHECK(ready[0].occurred & Sock::ERR);
+
+    // The set keeps the socket open until it is removed
+    sock0.reset();
+    BOOST_CHECK(!SocketIsClosed(s[0]));
+    events.Remove(7);
+    BOOST_CHECK_EQUAL(events.Size(), 0U);
+    BOOST_CHECK(SocketIsClosed(s[0]));
+}
+
 #endif /* WIN32 */
 
 BOOST_AUTO_TEST_SUITE_END()
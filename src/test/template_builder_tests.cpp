@@ -0,0 +1,176 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/validation.h>
+#include <node/miner.h>
+#include <node/template_builder.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+using node::BlockAssembler;
+using node::BlockTemplateBuilder;
+
+BOOST_FIXTURE_TEST_SUITE(template_builder_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(follow_mempool)
+{
+    // Make the first coinbase spendable, and let the builder miss the notifications for it
+    mineBlocks(1);
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    BlockTemplateBuilder builder{*m_node.chainman, *m_node.mempool, BlockAssembler::Options{}};
+    m_node.validation_signals->RegisterValidationInterface(&builder);
+
+    uint64_t sequence;
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(builder.GetTemplate(sequence)->block.vtx.size(), 1U);
+    }
+
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    const auto parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, 49 * COIN))};
+    const auto child{MakeTransactionRef(CreateValidMempoolTransaction(parent, 0, 102, coinbaseKey, script, 48 * COIN))};
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+
+    uint64_t current;
+    auto delta{WITH_LOCK(cs_main, return builder.GetDelta(sequence, current))};
+    BOOST_REQUIRE(delta);
+    BOOST_CHECK_GT(current, sequence);
+    BOOST_CHECK(delta->first.removed.empty());
+    BOOST_CHECK(delta->first.added == std::vector<size_t>({1, 2}));
+    const CBlock& block{delta->second->block};
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 3U);
+    BOOST_CHECK(block.vtx[1]->GetHash() == parent->GetHash());
+    BOOST_CHECK(block.vtx[2]->GetHash() == child->GetHash());
+    BOOST_CHECK_EQUAL(block.vtx[0]->vout[0].nValue, 52 * COIN);
+    BOOST_CHECK_EQUAL(delta->second->vTxFees[0], -2 * COIN);
+    BOOST_CHECK(!delta->second->vchCoinbaseCommitment.empty());
+
+    // Fetching the template does not rebuild it
+    {
+        LOCK(cs_main);
+        uint64_t fetched;
+        BOOST_CHECK_EQUAL(builder.GetTemplate(fetched)->block.vtx.size(), 3U);
+        BOOST_CHECK_EQUAL(fetched, current);
+    }
+
+    // Removing the parent takes the child along
+    {
+        LOCK2(cs_main, m_node.mempool->cs);
+        m_node.mempool->removeRecursive(*parent, MemPoolRemovalReason::CONFLICT);
+    }
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    uint64_t after_removal;
+    delta = WITH_LOCK(cs_main, return builder.GetDelta(current, after_removal));
+    BOOST_REQUIRE(delta);
+    BOOST_CHECK_GT(after_removal, current);
+    BOOST_CHECK_EQUAL(delta->first.removed.size(), 2U);
+    BOOST_CHECK(delta->first.added.empty());
+    BOOST_CHECK_EQUAL(delta->second->block.vtx.size(), 1U);
+    BOOST_CHECK_EQUAL(delta->second->block.vtx[0]->vout[0].nValue, 50 * COIN);
+
+    // Transactions that were added and removed again cancel out
+    delta = WITH_LOCK(cs_main, return builder.GetDelta(sequence, current));
+    BOOST_REQUIRE(delta);
+    BOOST_CHECK(delta->first.removed.empty());
+    BOOST_CHECK(delta->first.added.empty());
+
+    // Deltas are not available across rebuilds, nor for unknown sequence numbers
+    BOOST_CHECK(!WITH_LOCK(cs_main, return builder.GetDelta(current + 1, current)));
+    builder.Invalidate();
+    BOOST_CHECK(!WITH_LOCK(cs_main, return builder.GetDelta(after_removal, current)));
+
+    m_node.validation_signals->UnregisterValidationInterface(&builder);
+}
+
+BOOST_AUTO_TEST_CASE(stale_template)
+{
+    BlockTemplateBuilder builder{*m_node.chainman, *m_node.mempool, BlockAssembler::Options{}};
+    m_node.validation_signals->RegisterValidationInterface(&builder);
+    uint64_t sequence;
+    uint64_t current;
+    WITH_LOCK(cs_main, builder.GetTemplate(sequence));
+    BOOST_CHECK(WITH_LOCK(cs_main, return builder.GetDelta(sequence, current)));
+
+    // A new tip is noticed before the notification for it arrives
+    m_node.validation_signals->UnregisterValidationInterface(&builder);
+    mineBlocks(1);
+    BOOST_CHECK(!WITH_LOCK(cs_main, return builder.GetDelta(sequence, current)));
+    m_node.validation_signals->RegisterValidationInterface(&builder);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(builder.GetTemplate(sequence)->block.hashPrevBlock == m_node.chainman->ActiveChain().Tip()->GetBlockHash());
+        BOOST_CHECK(builder.GetDelta(sequence, current));
+    }
+
+    // So is the age of the template
+    SetMockTime(GetTime<std::chrono::seconds>() + node::MAX_TEMPLATE_AGE + std::chrono::seconds{1});
+    BOOST_CHECK(!WITH_LOCK(cs_main, return builder.GetDelta(sequence, current)));
+    WITH_LOCK(cs_main, builder.GetTemplate(sequence));
+    BOOST_CHECK(WITH_LOCK(cs_main, return builder.GetDelta(sequence, current)));
+
+    m_node.validation_signals->UnregisterValidationInterface(&builder);
+}
+
+BOOST_AUTO_TEST_CASE(evict_lower_feerate)
+{
+    mineBlocks(3);
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    const auto low{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, 49 * COIN, /*submit=*/false))};
+    const auto high{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 0, coinbaseKey, script, 40 * COIN, /*submit=*/false))};
+    const auto lower{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[2], 0, 0, coinbaseKey, script, 49 * COIN + COIN / 2, /*submit=*/false))};
+
+    // Leave room for a single one of them
+    BlockAssembler::Options options;
+    options.nBlockMaxWeight = 4000 + GetTransactionWeight(*low) + 100;
+    BlockTemplateBuilder builder{*m_node.chainman, *m_node.mempool, options};
+    m_node.validation_signals->RegisterValidationInterface(&builder);
+
+    uint64_t sequence;
+    {
+        LOCK(cs_main);
+        builder.GetTemplate(sequence);
+    }
+    const auto submit{[&](const CTransactionRef& tx) {
+        {
+            LOCK(cs_main);
+            BOOST_REQUIRE_EQUAL(m_node.chainman->ProcessTransaction(tx).m_result_type, MempoolAcceptResult::ResultType::VALID);
+        }
+        m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    }};
+
+    submit(low);
+    uint64_t current;
+    auto delta{WITH_LOCK(cs_main, return builder.GetDelta(sequence, current))};
+    BOOST_REQUIRE(delta);
+    BOOST_REQUIRE_EQUAL(delta->second->block.vtx.size(), 2U);
+    BOOST_CHECK(delta->second->block.vtx[1]->GetHash() == low->GetHash());
+
+    // A transaction paying more replaces it
+    submit(high);
+    sequence = current;
+    delta = WITH_LOCK(cs_main, return builder.GetDelta(sequence, current));
+    BOOST_REQUIRE(delta);
+    BOOST_CHECK(delta->first.removed == std::vector<Txid>{low->GetHash()});
+    BOOST_CHECK(delta->first.added == std::vector<size_t>{1});
+    BOOST_REQUIRE_EQUAL(delta->second->block.vtx.size(), 2U);
+    BOOST_CHECK(delta->second->block.vtx[1]->GetHash() == high->GetHash());
+
+    // A transaction paying less does not
+    submit(lower);
+    sequence = current;
+    delta = WITH_LOCK(cs_main, return builder.GetDelta(sequence, current));
+    BOOST_REQUIRE(delta);
+    BOOST_CHECK_EQUAL(current, sequence);
+    BOOST_CHECK(delta->first.removed.empty());
+    BOOST_CHECK(delta->first.added.empty());
+
+    m_node.validation_signals->UnregisterValidationInterface(&builder);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -387,4 +387,39 @@ BOOST_FIXTURE_TEST_CASE(version3_tests, RegTestingSetup)
     // equivalent to the tx with multiple generations of ancestors.
 }
 
+/**
+ * Ensure that batch acceptance reports the same results as individual acceptance, including for
+ * transactions that depend on each other and invalid transactions among valid ones.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_batch_accept, TestChain100Setup)
+{
+    mineBlocks(3);
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    const auto parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, 49 * COIN, /*submit=*/false))};
+    const auto child{MakeTransactionRef(CreateValidMempoolTransaction(parent, 0, 102, coinbaseKey, script, 48 * COIN, /*submit=*/false))};
+    const auto other{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[2], 0, 0, coinbaseKey, script, 49 * COIN, /*submit=*/false))};
+    // Changing the output after signing invalidates the signature
+    CMutableTransaction mtx{CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 0, coinbaseKey, script, 49 * COIN, /*submit=*/false)};
+    mtx.vout[0].nValue -= 1;
+    const auto bad_signature{MakeTransactionRef(mtx)};
+
+    LOCK(cs_main);
+    // The child comes first, so it is validated after the others
+    const auto results{m_node.chainman->ProcessTransactions({child, parent, bad_signature, other, other})};
+    BOOST_REQUIRE_EQUAL(results.size(), 5U);
+    BOOST_CHECK(results[0].m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(results[1].m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(results[2].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(results[2].m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK_EQUAL(results[2].m_state.GetRejectReason().rfind("mandatory-script-verify-flag-failed", 0), 0U);
+    BOOST_CHECK(results[3].m_result_type == MempoolAcceptResult::ResultType::VALID);
+    // The duplicate is validated individually, after the first one was accepted
+    BOOST_CHECK(results[4].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[4].m_state.GetRejectReason(), "txn-already-in-mempool");
+
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 3U);
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(child->GetHash())));
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(bad_signature->GetHash())));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -49,13 +49,35 @@ struct ConnmanTestMsg : public CConnman {
     {
         LOCK(m_nodes_mutex);
         m_nodes.push_back(&node);
+        AddNodeToSocketShard(node);
 
         if (node.IsManualOrFullOutboundConn()) ++m_network_conn_counts[node.addr.GetNetwork()];
     }
 
+    /** Create the socket handler shards Start() would, without threads to serve them. */
+    void CreateSocketShards()
+    {
+        while (m_sock_shards.size() < static_cast<size_t>(m_socket_threads)) {
+            m_sock_shards.push_back(std::make_unique<SocketHandlerShard>());
+        }
+    }
+
+    void SocketHandlerPublic(size_t shard = 0) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc, !m_msg_pool_mutex)
+    {
+        SocketHandler(*m_sock_shards.at(shard));
+    }
+
+    void DisconnectNodesPublic() EXCLUSIVE_LOCKS_REQUIRED(!m_reconnections_mutex, !m_nodes_mutex)
+    {
+        DisconnectNodes();
+    }
+
+    size_t NumDisconnectedNodes() const { return m_nodes_disconnected.size(); }
+
     void ClearTestNodes()
     {
         LOCK(m_nodes_mutex);
+        ClearSocketShards();
         for (CNode* node : m_nodes) {
             delete node;
         }
@@ -152,6 +174,13 @@ public:
 
     ssize_t Send(const void*, size_t len, int) const override { return len; }
 
+    ssize_t SendMany(Span<const Span<const uint8_t>> data, int) const override
+    {
+        size_t len{0};
+        for (const auto& buf : data) len += buf.size();
+        return len;
+    }
+
     ssize_t Recv(void* buf, size_t len, int flags) const override
     {
         const size_t consume_bytes{std::min(len, m_contents.size() - m_consumed)};
@@ -240,6 +240,7 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
         .notifications = *m_node.notifications,
         .signals = m_node.validation_signals.get(),
         .worker_threads_num = 2,
+        .script_check_window = static_cast<int>(m_node.args->GetIntArg("-scriptcheckwindow", 1)),
     };
     const BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.chainparams,
@@ -36,17 +36,14 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
         BOOST_TEST_MESSAGE("CCoinsViewCache memory usage: " << view.DynamicMemoryUsage());
     };
 
-    // PoolResource defaults to 256 KiB that will be allocated, so we'll take that and make it a bit larger.
-    constexpr size_t MAX_COINS_CACHE_BYTES = 262144 + 512;
-
     // Without any coins in the cache, we shouldn't need to flush.
     BOOST_TEST(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/ 0) != CoinsCacheSizeState::CRITICAL);
+        chainstate.GetCoinsCacheSizeState(/*max_coins_cache_size_bytes=*/0, /*max_mempool_size_bytes=*/ 0) != CoinsCacheSizeState::CRITICAL);
 
-    // If the initial memory allocations of cacheCoins don't match these common
-    // cases, we can't really continue to make assertions about memory usage.
+    // If the initial memory allocations of cacheCoins don't match this common
+    // case, we can't really continue to make assertions about memory usage.
     // End the test early.
-    if (view.DynamicMemoryUsage() != 32 && view.DynamicMemoryUsage() != 16) {
+    if (view.DynamicMemoryUsage() != 0) {
         // Add a bunch of coins to see that we at least flip over to CRITICAL.
 
         for (int i{0}; i < 1000; ++i) {
@@ -55,81 +52,59 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
         }
 
         BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/0),
+            chainstate.GetCoinsCacheSizeState(/*max_coins_cache_size_bytes=*/1 << 16, /*max_mempool_size_bytes=*/0),
             CoinsCacheSizeState::CRITICAL);
 
         BOOST_TEST_MESSAGE("Exiting cache flush tests early due to unsupported arch");
         return;
     }
 
+    // The first coin allocates the map's index and its first segment of
+    // entries, which has room for several more coins.
+    AddTestCoin(view);
     print_view_mem_usage(view);
-    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), is_64_bit ? 32U : 16U);
-
-    // We should be able to add COINS_UNTIL_CRITICAL coins to the cache before going CRITICAL.
-    // This is contingent not only on the dynamic memory usage of the Coins
-    // that we're adding (COIN_SIZE bytes per), but also on how much memory the
-    // cacheCoins (unordered_map) preallocates.
-    constexpr int COINS_UNTIL_CRITICAL{3};
-
-    // no coin added, so we have plenty of space left.
-    BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 0),
-        CoinsCacheSizeState::OK);
+    const size_t first_usage{view.DynamicMemoryUsage()};
+    BOOST_CHECK(first_usage > COIN_SIZE);
 
-    for (int i{0}; i < COINS_UNTIL_CRITICAL; ++i) {
+    // Coins that fit in the already allocated segment (and don't require the
+    // index to grow) only add the memory of the coins themselves.
+    for (int i{0}; i < 5; ++i) {
         const COutPoint res = AddTestCoin(view);
-        print_view_mem_usage(view);
         BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(), COIN_SIZE);
-
-        // adding first coin causes the MemoryResource to allocate one 256 KiB chunk of memory,
-        // pushing us immediately over to LARGE
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/ 0),
-            CoinsCacheSizeState::LARGE);
-    }
-
-    // Adding some additional coins will push us over the edge to CRITICAL.
-    for (int i{0}; i < 4; ++i) {
-        AddTestCoin(view);
-        print_view_mem_usage(view);
-        if (chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/0) ==
-            CoinsCacheSizeState::CRITICAL) {
-            break;
-        }
     }
+    print_view_mem_usage(view);
+    const size_t usage{view.DynamicMemoryUsage()};
+    BOOST_CHECK_EQUAL(usage, first_usage + 5 * COIN_SIZE);
 
+    // Using exactly the current usage as limit puts us >90%, but not yet critical.
     BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/0),
+        chainstate.GetCoinsCacheSizeState(usage, /*max_mempool_size_bytes=*/0),
+        CoinsCacheSizeState::LARGE);
+    BOOST_CHECK_EQUAL(
+        chainstate.GetCoinsCacheSizeState(usage - 1, /*max_mempool_size_bytes=*/0),
         CoinsCacheSizeState::CRITICAL);
+    BOOST_CHECK_EQUAL(
+        chainstate.GetCoinsCacheSizeState(usage * 10 / 9 + 1, /*max_mempool_size_bytes=*/0),
+        CoinsCacheSizeState::OK);
 
     // Passing non-zero max mempool usage (512 KiB) should allow us more headroom.
     BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/ 1 << 19),
+        chainstate.GetCoinsCacheSizeState(usage - 1, /*max_mempool_size_bytes=*/ 1 << 19),
         CoinsCacheSizeState::OK);
 
-    for (int i{0}; i < 3; ++i) {
+    // Adding coins until the segment runs out pushes us over the edge to CRITICAL.
+    for (int i{0}; i < 100; ++i) {
         AddTestCoin(view);
-        print_view_mem_usage(view);
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/ 1 << 19),
-            CoinsCacheSizeState::OK);
+        if (chainstate.GetCoinsCacheSizeState(usage + 10 * COIN_SIZE, /*max_mempool_size_bytes=*/0) ==
+            CoinsCacheSizeState::CRITICAL) {
+            break;
+        }
     }
-
-    // Adding another coin with the additional mempool room will put us >90%
-    // but not yet critical.
-    AddTestCoin(view);
     print_view_mem_usage(view);
 
-    // Only perform these checks on 64 bit hosts; I haven't done the math for 32.
-    if (is_64_bit) {
-        float usage_percentage = (float)view.DynamicMemoryUsage() / (MAX_COINS_CACHE_BYTES + (1 << 10));
-        BOOST_TEST_MESSAGE("CoinsTip usage percentage: " << usage_percentage);
-        BOOST_CHECK(usage_percentage >= 0.9);
-        BOOST_CHECK(usage_percentage < 1);
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 1 << 10), // 1024
-            CoinsCacheSizeState::LARGE);
-    }
+    BOOST_CHECK_EQUAL(
+        chainstate.GetCoinsCacheSizeState(usage + 10 * COIN_SIZE, /*max_mempool_size_bytes=*/0),
+        CoinsCacheSizeState::CRITICAL);
 
     // Using the default max_* values permits way more coins to be added.
     for (int i{0}; i < 1000; ++i) {
@@ -142,15 +117,16 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
     // Flushing the view does take us back to OK because ReallocateCache() is called
 
     BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
+        chainstate.GetCoinsCacheSizeState(usage, 0),
         CoinsCacheSizeState::CRITICAL);
 
     view.SetBestBlock(InsecureRand256());
     BOOST_CHECK(view.Flush());
     print_view_mem_usage(view);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), 0U);
 
     BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
+        chainstate.GetCoinsCacheSizeState(usage, 0),
         CoinsCacheSizeState::OK);
 }
 
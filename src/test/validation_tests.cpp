@@ -8,7 +8,12 @@
 #include <core_io.h>
 #include <hash.h>
 #include <net.h>
+#include <node/miner.h>
+#include <pow.h>
+#include <script/interpreter.h>
 #include <signet.h>
+#include <test/util/random.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <util/chaintype.h>
 #include <validation.h>
@@ -360,4 +365,198 @@ BOOST_AUTO_TEST_CASE(block_malleation)
     }
 }
 
+BOOST_AUTO_TEST_CASE(prefetch_block_inputs)
+{
+    CCoinsViewDB db{{.path = "", .cache_bytes = 1 << 20, .memory_only = true}, {}};
+    const auto make_coin = [](CAmount value) { return Coin{CTxOut{value, CScript{} << OP_TRUE}, /*nHeightIn=*/1, /*fCoinBaseIn=*/false}; };
+
+    // Coins a, b and c exist in the database, missing doesn't.
+    const COutPoint a{Txid::FromUint256(InsecureRand256()), 0};
+    const COutPoint b{Txid::FromUint256(InsecureRand256()), 1};
+    const COutPoint c{Txid::FromUint256(InsecureRand256()), 2};
+    const COutPoint missing{Txid::FromUint256(InsecureRand256()), 3};
+    {
+        CCoinsViewCache writer{&db};
+        writer.AddCoin(a, make_coin(1), /*possible_overwrite=*/false);
+        writer.AddCoin(b, make_coin(2), /*possible_overwrite=*/false);
+        writer.AddCoin(c, make_coin(3), /*possible_overwrite=*/false);
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(writer.Flush());
+    }
+
+    // The cache has already spent c, which the database doesn't know yet.
+    CCoinsViewCache cache{&db};
+    BOOST_CHECK(cache.SpendCoin(c));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 1U);
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.emplace_back(50 * COIN, CScript{} << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CMutableTransaction tx1;
+    tx1.vin = {CTxIn{a}, CTxIn{b}};
+    tx1.vout.emplace_back(3, CScript{} << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(tx1));
+    CMutableTransaction tx2;
+    tx2.vin = {CTxIn{COutPoint{block.vtx[1]->GetHash(), 0}}, CTxIn{missing}, CTxIn{c}};
+    tx2.vout.emplace_back(3, CScript{} << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(tx2));
+
+    CCheckQueue<CCoinPrefetch> queue{/*batch_size=*/1, /*worker_threads_num=*/2};
+    PrefetchBlockInputs(block, cache, db, queue);
+
+    // Only a and b were added; the output created in the block and the missing
+    // coin were not found, and the spent entry for c was left alone.
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 3U);
+    BOOST_CHECK(cache.HaveCoinInCache(a));
+    BOOST_CHECK(cache.HaveCoinInCache(b));
+    BOOST_CHECK(!cache.HaveCoinInCache(c));
+    BOOST_CHECK(!cache.HaveCoinInCache(missing));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(a).out.nValue, 1);
+    BOOST_CHECK_EQUAL(cache.AccessCoin(b).out.nValue, 2);
+    BOOST_CHECK(cache.AccessCoin(c).IsSpent());
+    cache.SanityCheck();
+}
+
+BOOST_FIXTURE_TEST_CASE(block_lookahead, TestChain100Setup)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        for (int height = 90; height <= 100; ++height) {
+            blocks.push_back(chainman.ActiveChain()[height]);
+        }
+    }
+
+    BlockLookahead lookahead{chainman.m_blockman, chainman.GetConsensus(), /*depth=*/4, /*worker_threads_num=*/2};
+    WITH_LOCK(cs_main, lookahead.Schedule(blocks));
+    // The block to connect and the 4 following ones are prepared.
+    for (size_t i = 0; i < 5; ++i) {
+        const auto block{lookahead.Take(*blocks[i])};
+        BOOST_REQUIRE(block);
+        BOOST_CHECK_EQUAL(block->GetHash(), blocks[i]->GetBlockHash());
+        BOOST_CHECK(block->fChecked);
+        BOOST_CHECK(!lookahead.Take(*blocks[i]));
+    }
+    BOOST_CHECK(!lookahead.Take(*blocks[5]));
+
+    // Rescheduling drops the blocks that are no longer going to be connected.
+    blocks.erase(blocks.begin(), blocks.begin() + 5);
+    WITH_LOCK(cs_main, lookahead.Schedule(blocks));
+    const std::vector<const CBlockIndex*> reorged{blocks.begin() + 3, blocks.end()};
+    WITH_LOCK(cs_main, lookahead.Schedule(reorged));
+    BOOST_CHECK(!lookahead.Take(*blocks[0]));
+    BOOST_CHECK(!lookahead.Take(*blocks[2]));
+    BOOST_CHECK(lookahead.Take(*blocks[3]));
+
+    // Without workers, blocks are prepared by the thread taking them.
+    BlockLookahead serial{chainman.m_blockman, chainman.GetConsensus(), /*depth=*/1, /*worker_threads_num=*/0};
+    WITH_LOCK(cs_main, serial.Schedule(blocks));
+    const auto block{serial.Take(*blocks[0])};
+    BOOST_REQUIRE(block);
+    BOOST_CHECK_EQUAL(block->GetHash(), blocks[0]->GetBlockHash());
+    BOOST_CHECK(block->fChecked);
+}
+
+struct ScriptCheckWindowSetup : public TestChain100Setup {
+    ScriptCheckWindowSetup() : TestChain100Setup{ChainType::REGTEST, {"-scriptcheckwindow=4"}} {}
+
+    //! Spend the output of the i-th coinbase, with a valid signature or not.
+    CMutableTransaction SpendCoinbase(int i, bool valid)
+    {
+        const CScript script_pub_key{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{m_coinbase_txns[i]->GetHash(), 0});
+        tx.vout.emplace_back(11 * CENT, script_pub_key);
+        std::vector<unsigned char> sig;
+        const uint256 hash{valid ? SignatureHash(script_pub_key, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE) : uint256::ONE};
+        BOOST_CHECK(coinbaseKey.Sign(hash, sig));
+        sig.push_back(SIGHASH_ALL);
+        tx.vin[0].scriptSig << sig;
+        return tx;
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(script_check_window, ScriptCheckWindowSetup)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    const CScript script_pub_key{CScript() << OP_TRUE};
+    const CBlock block1{CreateAndProcessBlock({SpendCoinbase(0, /*valid=*/true)}, script_pub_key)};
+    const CBlock block2{CreateAndProcessBlock({SpendCoinbase(1, /*valid=*/true)}, script_pub_key)};
+    CBlockIndex* index1{WITH_LOCK(cs_main, return chainman.m_blockman.LookupBlockIndex(block1.GetHash()))};
+    const COutPoint spent{m_coinbase_txns[1]->GetHash(), 0};
+    const COutPoint created{block2.vtx[1]->GetHash(), 0};
+
+    // Reconnecting both blocks from disk connects them at once.
+    BlockValidationState state;
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, index1));
+    BOOST_CHECK(WITH_LOCK(cs_main, return chainstate.CoinsTip().HaveCoin(spent)));
+    WITH_LOCK(cs_main, chainstate.ResetBlockFailureFlags(index1));
+    BOOST_REQUIRE(chainstate.ActivateBestChain(state));
+    BOOST_CHECK_EQUAL(WITH_LOCK(cs_main, return chainman.ActiveTip()->GetBlockHash()), block2.GetHash());
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(!chainstate.CoinsTip().HaveCoin(spent));
+        BOOST_CHECK(chainstate.CoinsTip().HaveCoin(created));
+        BOOST_CHECK(chainman.ActiveTip()->IsValid(BLOCK_VALID_SCRIPTS));
+    }
+
+    // A script check failing in the last of three blocks connected at once
+    // leaves the first two connected and the last one marked invalid.
+    const auto block3{std::make_shared<const CBlock>(CreateBlock({SpendCoinbase(2, /*valid=*/false)}, script_pub_key, chainstate))};
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, index1));
+    {
+        LOCK(cs_main);
+        chainstate.ResetBlockFailureFlags(index1);
+        CBlockIndex* index3{nullptr};
+        BOOST_REQUIRE(chainman.AcceptBlock(block3, state, &index3, /*fRequested=*/true, /*dbp=*/nullptr, /*fNewBlock=*/nullptr, /*min_pow_checked=*/true));
+    }
+    BOOST_REQUIRE(chainstate.ActivateBestChain(state));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ActiveTip()->GetBlockHash(), block2.GetHash());
+        BOOST_CHECK(chainstate.CoinsTip().HaveCoin(created));
+        BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(block3->GetHash())->nStatus & BLOCK_FAILED_VALID);
+    }
+
+    // Spending a coin spent by an earlier block of the window fails when connecting the
+    // block, while the script checks of the earlier blocks may still be running.
+    const auto double_spend{std::make_shared<const CBlock>(CreateBlock({SpendCoinbase(1, /*valid=*/true)}, script_pub_key, chainstate))};
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, index1));
+    CBlockIndex* index_double_spend{nullptr};
+    {
+        LOCK(cs_main);
+        chainstate.ResetBlockFailureFlags(index1);
+        BOOST_REQUIRE(chainman.AcceptBlock(double_spend, state, &index_double_spend, /*fRequested=*/true, /*dbp=*/nullptr, /*fNewBlock=*/nullptr, /*min_pow_checked=*/true));
+    }
+    BOOST_REQUIRE(chainstate.ActivateBestChain(state));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ActiveTip()->GetBlockHash(), block2.GetHash());
+        BOOST_CHECK(index_double_spend->nStatus & BLOCK_FAILED_VALID);
+    }
+
+    // The same failure in the first block of the window is reported right away.
+    CBlock child{CreateBlock({}, script_pub_key, chainstate)};
+    child.hashPrevBlock = double_spend->GetHash();
+    CMutableTransaction coinbase{*child.vtx[0]};
+    coinbase.vin[0].scriptSig = CScript() << (index_double_spend->nHeight + 1) << OP_0;
+    child.vtx[0] = MakeTransactionRef(coinbase);
+    {
+        LOCK(cs_main);
+        chainstate.ResetBlockFailureFlags(index_double_spend);
+        node::RegenerateCommitments(child, chainman);
+        while (!CheckProofOfWork(child.GetHash(), child.nBits, chainman.GetConsensus())) ++child.nNonce;
+        BOOST_REQUIRE(chainman.AcceptBlock(std::make_shared<const CBlock>(child), state, /*ppindex=*/nullptr, /*fRequested=*/true, /*dbp=*/nullptr, /*fNewBlock=*/nullptr, /*min_pow_checked=*/true));
+    }
+    BOOST_REQUIRE(chainstate.ActivateBestChain(state));
+    LOCK(cs_main);
+    BOOST_CHECK_EQUAL(chainman.ActiveTip()->GetBlockHash(), block2.GetHash());
+    BOOST_CHECK(index_double_spend->nStatus & BLOCK_FAILED_VALID);
+    BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(child.GetHash())->nStatus & BLOCK_FAILED_MASK);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
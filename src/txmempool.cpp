@@ -6,6 +6,7 @@
 #include <txmempool.h>
 
 #include <chain.h>
+#include <cluster_linearize.h>
 #include <coins.h>
 #include <common/system.h>
 #include <consensus/consensus.h>
@@ -30,8 +31,37 @@
 #include <numeric>
 #include <optional>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 
+using cluster_linearize::ClusterIndex;
+
+/** Clusters up to this size are linearized again after a removal. Larger ones keep the order they
+ * had, which remains valid, so that evicting from a big cluster does not linearize it every time. */
+static constexpr size_t MAX_CLUSTER_RELINEARIZE_ON_REMOVAL{64};
+
+/** Linearize the given transactions, ignoring their dependencies on transactions not among them.
+ * Returns the order to mine them in, as indexes into txs, and the chunks of that order. */
+static std::pair<std::vector<ClusterIndex>, std::vector<cluster_linearize::Chunk>> LinearizeEntries(Span<const CTxMemPool::txiter> txs)
+{
+    cluster_linearize::DepGraph depgraph{txs.size()};
+    std::unordered_map<const CTxMemPoolEntry*, ClusterIndex> indexes;
+    indexes.reserve(txs.size());
+    for (const CTxMemPool::txiter& it : txs) {
+        indexes.emplace(&*it, depgraph.AddTransaction({it->GetModifiedFee(), it->GetTxSize()}));
+    }
+    for (ClusterIndex i{0}; i < txs.size(); ++i) {
+        for (const CTxMemPoolEntry& parent : txs[i]->GetMemPoolParentsConst()) {
+            const auto parent_index{indexes.find(&parent)};
+            if (parent_index != indexes.end()) depgraph.AddDependency(parent_index->second, i);
+        }
+    }
+    auto linearization{cluster_linearize::Linearize(depgraph)};
+    auto chunks{cluster_linearize::ChunkLinearization(depgraph, linearization)};
+    return {std::move(linearization), std::move(chunks)};
+}
+
 bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 {
     AssertLockHeld(cs_main);
@@ -52,8 +82,8 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    const CTxMemPoolEntry::Children& children_of_updated = updateIt->GetMemPoolChildrenConst();
+    setEntryRefs stageEntries{children_of_updated.begin(), children_of_updated.end()}, descendants;
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -158,7 +188,7 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimits(
     int64_t entry_size,
     size_t entry_count,
-    CTxMemPoolEntry::Parents& staged_ancestors,
+    setEntryRefs& staged_ancestors,
     const Limits& limits) const
 {
     int64_t totalSizeWithAncestors = entry_size;
@@ -213,7 +243,7 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
         return util::Error{Untranslated(strprintf("package size %u exceeds descendant size limit [limit: %u]", total_vsize, m_limits.descendant_size_vbytes))};
     }
 
-    CTxMemPoolEntry::Parents staged_ancestors;
+    setEntryRefs staged_ancestors;
     for (const auto& tx : package) {
         for (const auto& input : tx->vin) {
             std::optional<txiter> piter = GetIter(input.prevout.hash);
@@ -235,12 +265,40 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
     return {};
 }
 
+util::Result<void> CTxMemPool::CheckClusterLimits(const Package& package, const int64_t total_vsize, const setEntries& removed) const
+{
+    AssertLockHeld(cs);
+    std::set<uint64_t> cluster_ids;
+    int64_t cluster_count{static_cast<int64_t>(package.size())};
+    int64_t cluster_vsize{total_vsize};
+    for (const auto& tx : package) {
+        for (const auto& input : tx->vin) {
+            const std::optional<txiter> piter{GetIter(input.prevout.hash)};
+            if (!piter || !cluster_ids.insert((*piter)->m_cluster_id).second) continue;
+            const Cluster& cluster{m_clusters.at((*piter)->m_cluster_id)};
+            cluster_count += cluster.Count();
+            cluster_vsize += cluster.vsize;
+        }
+    }
+    for (const txiter& it : removed) {
+        if (!cluster_ids.count(it->m_cluster_id)) continue;
+        --cluster_count;
+        cluster_vsize -= it->GetTxSize();
+    }
+    if (cluster_count > m_limits.cluster_count) {
+        return util::Error{Untranslated(strprintf("cluster count %u exceeds limit [limit: %u]", cluster_count, m_limits.cluster_count))};
+    } else if (cluster_vsize > m_limits.cluster_size_vbytes) {
+        return util::Error{Untranslated(strprintf("cluster size %u exceeds limit [limit: %u]", cluster_vsize, m_limits.cluster_size_vbytes))};
+    }
+    return {};
+}
+
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
     const CTxMemPoolEntry &entry,
     const Limits& limits,
     bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    setEntryRefs staged_ancestors;
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -260,7 +318,7 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        staged_ancestors.insert(it->GetMemPoolParentsConst().begin(), it->GetMemPoolParentsConst().end());
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, staged_ancestors,
@@ -462,7 +520,9 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // In that case, our disconnect block logic will call UpdateTransactionsFromBlock
     // to clean up the mess we're leaving here.
 
-    // Update ancestors with information about this tx
+    // Update ancestors with information about this tx. Linking the parents
+    // merges their clusters into the new one.
+    AddToCluster(newit);
     for (const auto& pit : GetIterSet(setParentTransactions)) {
             UpdateParent(newit, pit, true);
     }
@@ -520,10 +580,12 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     } else
         txns_randomized.clear();
 
+    RemoveFromCluster(it);
+
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    cachedInnerUsage -= it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
     mapTx.erase(it);
     nTransactionsUpdated++;
 }
@@ -674,8 +736,8 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
-        CTxMemPoolEntry::Parents setParentCheck;
+        innerUsage += it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
+        setEntryRefs setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
             indexed_transaction_set::const_iterator it2 = mapTx.find(txin.prevout.hash);
@@ -699,6 +761,11 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         };
         assert(setParentCheck.size() == it->GetMemPoolParentsConst().size());
         assert(std::equal(setParentCheck.begin(), setParentCheck.end(), it->GetMemPoolParentsConst().begin(), comp));
+        // Check that the entry is in its cluster, along with its parents.
+        assert(m_clusters.at(it->m_cluster_id).txs.at(it->m_cluster_pos) == it);
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+            assert(parent.m_cluster_id == it->m_cluster_id);
+        }
         // Verify ancestor state is correct.
         auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits())};
         uint64_t nCountCheck = ancestors.size() + 1;
@@ -721,7 +788,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         prev_ancestor_count = it->GetCountWithAncestors();
 
         // Check children against mapNextTx
-        CTxMemPoolEntry::Children setChildrenCheck;
+        setEntryRefs setChildrenCheck;
         auto iter = mapNextTx.lower_bound(COutPoint(it->GetTx().GetHash(), 0));
         int32_t child_sizes{0};
         for (; iter != mapNextTx.end() && iter->first->hash == it->GetTx().GetHash(); ++iter) {
@@ -755,6 +822,37 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+
+    // Check that every linearization is topological and that its chunks add up
+    LinearizeClusters();
+    size_t cluster_tx_count{0};
+    for (const auto& [cluster_id, cluster] : m_clusters) {
+        assert(cluster.removed == 0);
+        cluster_tx_count += cluster.txs.size();
+        int64_t cluster_vsize{0};
+        for (size_t pos{0}; pos < cluster.txs.size(); ++pos) {
+            assert(cluster.txs[pos]->m_cluster_pos == pos);
+            cluster_vsize += cluster.txs[pos]->GetTxSize();
+            for (const CTxMemPoolEntry& parent : cluster.txs[pos]->GetMemPoolParentsConst()) {
+                assert(parent.m_cluster_pos < pos);
+            }
+        }
+        const txiter* next{cluster.txs.data()};
+        for (size_t i{0}; i < cluster.chunks.size(); ++i) {
+            const Chunk& chunk{cluster.chunks[i]};
+            assert(chunk.txs.data() == next);
+            next += chunk.txs.size();
+            FeeFrac feerate;
+            for (const txiter& it : chunk.txs) feerate += FeeFrac{it->GetModifiedFee(), it->GetTxSize()};
+            assert(feerate == chunk.feerate);
+            assert(i == 0 || !(chunk.feerate >> cluster.chunks[i - 1].feerate));
+        }
+        assert(next == cluster.txs.data() + cluster.txs.size());
+        assert(cluster_vsize == cluster.vsize);
+        assert(m_worst_chunks.count({cluster.chunks.back().feerate, cluster_id}));
+    }
+    assert(cluster_tx_count == mapTx.size());
+    assert(m_worst_chunks.size() == m_clusters.size());
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid)
@@ -894,6 +992,8 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
             for (txiter descendantIt : setDescendants) {
                 mapTx.modify(descendantIt, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
             }
+            MarkClusterDirty(it->m_cluster_id);
+            m_clusters.at(it->m_cluster_id).relinearize = true;
             ++nTransactionsUpdated;
         }
         if (delta == 0) {
@@ -1026,8 +1126,10 @@ void CCoinsViewMemPool::Reset()
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    // Estimate the overhead of mapTx to be 9 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
+    // Cluster linearizations hold an iterator and at most one chunk per transaction.
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 9 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) +
+           (sizeof(txiter) + sizeof(Chunk)) * mapTx.size() + memusage::DynamicUsage(m_clusters) + memusage::DynamicUsage(m_dirty_clusters) + memusage::DynamicUsage(m_worst_chunks) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1073,23 +1175,183 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry)
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Children& children = entry->GetMemPoolChildren();
+    cachedInnerUsage -= children.DynamicMemoryUsage();
+    if (add) {
+        children.insert(*child);
+    } else {
+        children.erase(*child);
     }
+    cachedInnerUsage += children.DynamicMemoryUsage();
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Parents& parents = entry->GetMemPoolParents();
+    cachedInnerUsage -= parents.DynamicMemoryUsage();
+    if (add && parents.insert(*parent)) {
+        MergeClusters(entry, parent);
+    } else if (!add) {
+        parents.erase(*parent);
     }
+    cachedInnerUsage += parents.DynamicMemoryUsage();
+}
+
+void CTxMemPool::AddToCluster(txiter entry)
+{
+    AssertLockHeld(cs);
+    const uint64_t cluster_id{m_next_cluster_id++};
+    Cluster& cluster{m_clusters[cluster_id]};
+    cluster.txs.push_back(entry);
+    cluster.vsize = entry->GetTxSize();
+    entry->m_cluster_id = cluster_id;
+    entry->m_cluster_pos = 0;
+    m_dirty_clusters.insert(cluster_id);
+}
+
+void CTxMemPool::RemoveFromCluster(txiter entry)
+{
+    AssertLockHeld(cs);
+    const uint64_t cluster_id{entry->m_cluster_id};
+    Cluster& cluster{m_clusters.at(cluster_id)};
+    if (cluster.Count() == 1) {
+        if (!m_dirty_clusters.erase(cluster_id)) {
+            m_worst_chunks.erase({cluster.chunks.back().feerate, cluster_id});
+        }
+        m_clusters.erase(cluster_id);
+        return;
+    }
+    MarkClusterDirty(cluster_id);
+    cluster.may_split = true;
+    // Leave a placeholder, so that the positions of the remaining entries stay valid and removing
+    // many transactions from a large cluster does not shift the rest for each of them. The order
+    // of the remaining entries stays topological, so large clusters can be chunked again without
+    // relinearizing them.
+    cluster.txs[entry->m_cluster_pos] = mapTx.end();
+    ++cluster.removed;
+    cluster.vsize -= entry->GetTxSize();
+    if (cluster.Count() <= MAX_CLUSTER_RELINEARIZE_ON_REMOVAL) cluster.relinearize = true;
+}
+
+void CTxMemPool::MergeClusters(txiter a, txiter b)
+{
+    AssertLockHeld(cs);
+    uint64_t into{a->m_cluster_id};
+    uint64_t from{b->m_cluster_id};
+    if (into == from) return;
+    // Move the transactions of the smaller cluster
+    if (m_clusters.at(into).Count() < m_clusters.at(from).Count()) std::swap(into, from);
+    MarkClusterDirty(into);
+    MarkClusterDirty(from);
+    Cluster& target{m_clusters.at(into)};
+    Cluster& source{m_clusters.at(from)};
+    for (const txiter& it : source.txs) {
+        if (it == mapTx.end()) continue;
+        it->m_cluster_id = into;
+        it->m_cluster_pos = target.txs.size();
+        target.txs.push_back(it);
+    }
+    target.vsize += source.vsize;
+    target.may_split |= source.may_split;
+    target.relinearize = true;
+    m_dirty_clusters.erase(from);
+    m_clusters.erase(from);
+}
+
+void CTxMemPool::MarkClusterDirty(uint64_t cluster_id) const
+{
+    AssertLockHeld(cs);
+    if (!m_dirty_clusters.insert(cluster_id).second) return;
+    Cluster& cluster{m_clusters.at(cluster_id)};
+    m_worst_chunks.erase({cluster.chunks.back().feerate, cluster_id});
+    cluster.chunks.clear();
+}
+
+void CTxMemPool::LinearizeClusters() const
+{
+    AssertLockHeld(cs);
+    for (const uint64_t cluster_id : m_dirty_clusters) {
+        Cluster& cluster{m_clusters.at(cluster_id)};
+        if (cluster.removed > 0) {
+            cluster.txs.erase(std::remove(cluster.txs.begin(), cluster.txs.end(), mapTx.end()), cluster.txs.end());
+            cluster.removed = 0;
+        }
+        if (cluster.may_split) {
+            // Find the connected components. The first one keeps the cluster's id.
+            cluster.may_split = false;
+            std::vector<uint64_t> component_ids;
+            std::vector<txiter> to_visit;
+            WITH_FRESH_EPOCH(m_epoch);
+            for (const txiter& start : cluster.txs) {
+                if (visited(start)) continue;
+                const uint64_t component_id{component_ids.empty() ? cluster_id : m_next_cluster_id++};
+                component_ids.push_back(component_id);
+                to_visit.push_back(start);
+                while (!to_visit.empty()) {
+                    const txiter it{to_visit.back()};
+                    to_visit.pop_back();
+                    it->m_cluster_id = component_id;
+                    for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                        if (!visited(mapTx.iterator_to(parent))) to_visit.push_back(mapTx.iterator_to(parent));
+                    }
+                    for (const CTxMemPoolEntry& child : it->GetMemPoolChildrenConst()) {
+                        if (!visited(mapTx.iterator_to(child))) to_visit.push_back(mapTx.iterator_to(child));
+                    }
+                }
+            }
+            if (component_ids.size() > 1) {
+                // Distribute the transactions in their current order, which stays topological
+                // within every component.
+                const std::vector<txiter> txs{std::move(cluster.txs)};
+                cluster.txs.clear();
+                for (const uint64_t component_id : component_ids) {
+                    m_clusters[component_id].relinearize = cluster.relinearize;
+                    m_clusters[component_id].vsize = 0;
+                }
+                for (const txiter& it : txs) {
+                    Cluster& component{m_clusters.at(it->m_cluster_id)};
+                    component.txs.push_back(it);
+                    component.vsize += it->GetTxSize();
+                }
+                for (const uint64_t component_id : component_ids) {
+                    if (component_id != cluster_id) LinearizeCluster(component_id, m_clusters.at(component_id));
+                }
+            }
+        }
+        LinearizeCluster(cluster_id, cluster);
+    }
+    m_dirty_clusters.clear();
+}
+
+void CTxMemPool::LinearizeCluster(uint64_t cluster_id, Cluster& cluster) const
+{
+    AssertLockHeld(cs);
+    std::vector<cluster_linearize::Chunk> chunks;
+    if (cluster.relinearize) {
+        std::vector<ClusterIndex> linearization;
+        std::tie(linearization, chunks) = LinearizeEntries(cluster.txs);
+        std::vector<txiter> txs;
+        txs.reserve(linearization.size());
+        for (const ClusterIndex index : linearization) txs.push_back(cluster.txs[index]);
+        cluster.txs = std::move(txs);
+        cluster.relinearize = false;
+    } else {
+        // Only transactions were removed, so the order is still valid; only the chunks changed.
+        std::vector<FeeFrac> feerates;
+        feerates.reserve(cluster.txs.size());
+        for (const txiter& it : cluster.txs) feerates.emplace_back(it->GetModifiedFee(), it->GetTxSize());
+        chunks = cluster_linearize::ChunkLinearization(feerates);
+    }
+    for (size_t pos{0}; pos < cluster.txs.size(); ++pos) cluster.txs[pos]->m_cluster_pos = pos;
+    cluster.chunks.clear();
+    cluster.chunks.reserve(chunks.size());
+    size_t begin{0};
+    for (const auto& chunk : chunks) {
+        cluster.chunks.push_back({chunk.feerate, Span<const txiter>{cluster.txs}.subspan(begin, chunk.end - begin)});
+        begin = chunk.end;
+    }
+    m_worst_chunks.emplace(cluster.chunks.back().feerate, cluster_id);
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1130,19 +1392,21 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        LinearizeClusters();
+        const auto [worst, cluster_id]{*m_worst_chunks.begin()};
 
-        // We set the new mempool min fee to the feerate of the removed set, plus the
+        // We set the new mempool min fee to the feerate of the worst chunk, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+        CFeeRate removed(worst.fee, worst.size);
         removed += m_incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        // Only evict the last transaction of the linearization, which has no
+        // descendants, so that the rest of the chunk may stay if it fits.
+        setEntries stage{m_clusters.at(cluster_id).txs.back()};
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1240,6 +1504,18 @@ std::vector<CTxMemPool::txiter> CTxMemPool::GatherClusters(const std::vector<uin
     return clustered_txs;
 }
 
+std::vector<Span<const CTxMemPool::Chunk>> CTxMemPool::GetClusterChunks() const
+{
+    AssertLockHeld(cs);
+    LinearizeClusters();
+    std::vector<Span<const Chunk>> clusters;
+    clusters.reserve(m_clusters.size());
+    for (const auto& [_, cluster] : m_clusters) {
+        clusters.emplace_back(cluster.chunks);
+    }
+    return clusters;
+}
+
 std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& direct_conflicts)
 {
     for (const auto& direct_conflict : direct_conflicts) {
@@ -1290,79 +1566,42 @@ util::Result<std::pair<std::vector<FeeFrac>, std::vector<FeeFrac>>> CTxMemPool::
         return util::Error{Untranslated(err_string.value())};
     }
 
-    // new diagram will have chunks that consist of each ancestor of
-    // direct_conflicts that is at its own fee/size, along with the replacement
-    // tx/package at its own fee/size
-
-    // old diagram will consist of the ancestors and descendants of each element of
-    // all_conflicts.  every such transaction will either be at its own feerate (followed
-    // by any descendant at its own feerate), or as a single chunk at the descendant's
-    // ancestor feerate.
-
+    // The old diagram consists of the chunks of every cluster containing a conflict. The new
+    // diagram consists of the chunks of the same clusters linearized again without the
+    // conflicts, plus the replacement as a single chunk.
+    LinearizeClusters();
     std::vector<FeeFrac> old_chunks;
-    // Step 1: build the old diagram.
-
-    // The above clusters are all trivially linearized;
-    // they have a strict topology of 1 or two connected transactions.
-
-    // OLD: Compute existing chunks from all affected clusters
-    for (auto txiter : all_conflicts) {
-        // Does this transaction have descendants?
-        if (txiter->GetCountWithDescendants() > 1) {
-            // Consider this tx when we consider the descendant.
-            continue;
+    std::vector<FeeFrac> new_chunks;
+    std::set<uint64_t> affected_clusters;
+    std::vector<txiter> remaining;
+    for (const auto& conflict : all_conflicts) {
+        if (!affected_clusters.insert(conflict->m_cluster_id).second) continue;
+        const Cluster& cluster{m_clusters.at(conflict->m_cluster_id)};
+        for (const Chunk& chunk : cluster.chunks) {
+            old_chunks.push_back(chunk.feerate);
+        }
+        remaining.clear();
+        for (const txiter& it : cluster.txs) {
+            if (!all_conflicts.count(it)) remaining.push_back(it);
         }
-        // Does this transaction have ancestors?
-        FeeFrac individual{txiter->GetModifiedFee(), txiter->GetTxSize()};
-        if (txiter->GetCountWithAncestors() > 1) {
-            // We'll add chunks for either the ancestor by itself and this tx
-            // by itself, or for a combined package.
-            FeeFrac package{txiter->GetModFeesWithAncestors(), static_cast<int32_t>(txiter->GetSizeWithAncestors())};
-            if (individual >> package) {
-                // The individual feerate is higher than the package, and
-                // therefore higher than the parent's fee. Chunk these
-                // together.
-                old_chunks.emplace_back(package);
-            } else {
-                // Add two points, one for the parent and one for this child.
-                old_chunks.emplace_back(package - individual);
-                old_chunks.emplace_back(individual);
+        if (remaining.size() <= MAX_CLUSTER_RELINEARIZE_ON_REMOVAL) {
+            for (const auto& chunk : LinearizeEntries(remaining).second) {
+                new_chunks.push_back(chunk.feerate);
             }
         } else {
-            old_chunks.emplace_back(individual);
-        }
-    }
-
-    // No topology restrictions post-chunking; sort
-    std::sort(old_chunks.begin(), old_chunks.end(), std::greater());
-
-    std::vector<FeeFrac> new_chunks;
-
-    /* Step 2: build the NEW diagram
-     * CON = Conflicts of proposed chunk
-     * CNK = Proposed chunk
-     * NEW = OLD - CON + CNK: New diagram includes all chunks in OLD, minus
-     * the conflicts, plus the proposed chunk
-     */
-
-    // OLD - CON: Add any parents of direct conflicts that are not conflicted themselves
-    for (auto direct_conflict : direct_conflicts) {
-        // If a direct conflict has an ancestor that is not in all_conflicts,
-        // it can be affected by the replacement of the child.
-        if (direct_conflict->GetMemPoolParentsConst().size() > 0) {
-            // Grab the parent.
-            const CTxMemPoolEntry& parent = direct_conflict->GetMemPoolParentsConst().begin()->get();
-            if (!all_conflicts.count(mapTx.iterator_to(parent))) {
-                // This transaction would be left over, so add to the NEW
-                // diagram.
-                new_chunks.emplace_back(parent.GetModifiedFee(), parent.GetTxSize());
+            // Like RemoveFromCluster, keep the order of large clusters and only chunk it again.
+            std::vector<FeeFrac> feerates;
+            feerates.reserve(remaining.size());
+            for (const txiter& it : remaining) feerates.emplace_back(it->GetModifiedFee(), it->GetTxSize());
+            for (const auto& chunk : cluster_linearize::ChunkLinearization(feerates)) {
+                new_chunks.push_back(chunk.feerate);
             }
         }
     }
-    // + CNK: Add the proposed chunk itself
     new_chunks.emplace_back(replacement_fees, int32_t(replacement_vsize));
 
     // No topology restrictions post-chunking; sort
+    std::sort(old_chunks.begin(), old_chunks.end(), std::greater());
     std::sort(new_chunks.begin(), new_chunks.end(), std::greater());
     return std::make_pair(old_chunks, new_chunks);
 }
@@ -17,6 +17,7 @@
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <primitives/transaction.h>
+#include <span.h>
 #include <sync.h>
 #include <util/epochguard.h>
 #include <util/hasher.h>
@@ -37,6 +38,7 @@
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -82,48 +84,6 @@ struct mempoolentry_wtxid
 };
 
 
-/** \class CompareTxMemPoolEntryByDescendantScore
- *
- *  Sort an entry by max(score/size of entry's tx, score/size with all descendants).
- */
-class CompareTxMemPoolEntryByDescendantScore
-{
-public:
-    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
-    {
-        double a_mod_fee, a_size, b_mod_fee, b_size;
-
-        GetModFeeAndSize(a, a_mod_fee, a_size);
-        GetModFeeAndSize(b, b_mod_fee, b_size);
-
-        // Avoid division by rewriting (a/b > c/d) as (a*d > c*b).
-        double f1 = a_mod_fee * b_size;
-        double f2 = a_size * b_mod_fee;
-
-        if (f1 == f2) {
-            return a.GetTime() >= b.GetTime();
-        }
-        return f1 < f2;
-    }
-
-    // Return the fee/size we're using for sorting this entry.
-    void GetModFeeAndSize(const CTxMemPoolEntry &a, double &mod_fee, double &size) const
-    {
-        // Compare feerate with descendants to feerate of the transaction, and
-        // return the fee/size for the max.
-        double f1 = (double)a.GetModifiedFee() * a.GetSizeWithDescendants();
-        double f2 = (double)a.GetModFeesWithDescendants() * a.GetTxSize();
-
-        if (f2 > f1) {
-            mod_fee = a.GetModFeesWithDescendants();
-            size = a.GetSizeWithDescendants();
-        } else {
-            mod_fee = a.GetModifiedFee();
-            size = a.GetTxSize();
-        }
-    }
-};
-
 /** \class CompareTxMemPoolEntryByScore
  *
  *  Sort by feerate of entry (fee/size) in descending order
@@ -154,54 +114,8 @@ public:
     }
 };
 
-/** \class CompareTxMemPoolEntryByAncestorScore
- *
- *  Sort an entry by min(score/size of entry's tx, score/size with all ancestors).
- */
-class CompareTxMemPoolEntryByAncestorFee
-{
-public:
-    template<typename T>
-    bool operator()(const T& a, const T& b) const
-    {
-        double a_mod_fee, a_size, b_mod_fee, b_size;
-
-        GetModFeeAndSize(a, a_mod_fee, a_size);
-        GetModFeeAndSize(b, b_mod_fee, b_size);
-
-        // Avoid division by rewriting (a/b > c/d) as (a*d > c*b).
-        double f1 = a_mod_fee * b_size;
-        double f2 = a_size * b_mod_fee;
-
-        if (f1 == f2) {
-            return a.GetTx().GetHash() < b.GetTx().GetHash();
-        }
-        return f1 > f2;
-    }
-
-    // Return the fee/size we're using for sorting this entry.
-    template <typename T>
-    void GetModFeeAndSize(const T &a, double &mod_fee, double &size) const
-    {
-        // Compare feerate with ancestors to feerate of the transaction, and
-        // return the fee/size for the min.
-        double f1 = (double)a.GetModifiedFee() * a.GetSizeWithAncestors();
-        double f2 = (double)a.GetModFeesWithAncestors() * a.GetTxSize();
-
-        if (f1 > f2) {
-            mod_fee = a.GetModFeesWithAncestors();
-            size = a.GetSizeWithAncestors();
-        } else {
-            mod_fee = a.GetModifiedFee();
-            size = a.GetTxSize();
-        }
-    }
-};
-
 // Multi_index tag names
-struct descendant_score {};
 struct entry_time {};
-struct ancestor_score {};
 struct index_by_wtxid {};
 
 /**
@@ -240,21 +154,31 @@ struct TxMempoolInfo
  *
  * CTxMemPool::mapTx, and CTxMemPoolEntry bookkeeping:
  *
- * mapTx is a boost::multi_index that sorts the mempool on 5 criteria:
+ * mapTx is a boost::multi_index that sorts the mempool on 3 criteria:
  * - transaction hash (txid)
  * - witness-transaction hash (wtxid)
- * - descendant feerate [we use max(feerate of tx, feerate of tx with all descendants)]
  * - time in mempool
- * - ancestor feerate [we use min(feerate of tx, feerate of tx with all unconfirmed ancestors)]
  *
  * Note: the term "descendant" refers to in-mempool transactions that depend on
  * this one, while "ancestor" refers to in-mempool transactions that a given
  * transaction depends on.
  *
- * In order for the feerate sort to remain correct, we must update transactions
- * in the mempool when new descendants arrive.  To facilitate this, we track
- * the set of in-mempool direct parents and direct children in mapLinks.  Within
- * each CTxMemPoolEntry, we track the size and fees of all descendants.
+ * We track the set of in-mempool direct parents and direct children of each
+ * entry. Within each CTxMemPoolEntry, we also track the size and fees of all
+ * ancestors and descendants, which are used to enforce the package limits.
+ *
+ * Clusters and chunks:
+ *
+ * The mempool is partitioned into clusters: sets of transactions that are
+ * connected through spending relationships. Each cluster keeps a
+ * linearization, an order of its transactions for mining, split into chunks
+ * of decreasing feerate (see cluster_linearize.h). Mining picks the best chunk
+ * among all clusters, eviction drops the worst, and replacements are judged by
+ * the chunks of the clusters they affect.
+ *
+ * Adding a transaction merges the clusters of its parents, and removing one
+ * may split its cluster. Either way only the clusters involved are touched:
+ * they are marked dirty and linearized again the next time chunks are needed.
  *
  * Usually when a new transaction is added to the mempool, it has no in-mempool
  * children (because any such children would be an orphan).  So in
@@ -339,23 +263,11 @@ public:
                 mempoolentry_wtxid,
                 SaltedTxidHasher
             >,
-            // sorted by fee rate
-            boost::multi_index::ordered_non_unique<
-                boost::multi_index::tag<descendant_score>,
-                boost::multi_index::identity<CTxMemPoolEntry>,
-                CompareTxMemPoolEntryByDescendantScore
-            >,
             // sorted by entry time
             boost::multi_index::ordered_non_unique<
                 boost::multi_index::tag<entry_time>,
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByEntryTime
-            >,
-            // sorted by fee rate with ancestors
-            boost::multi_index::ordered_non_unique<
-                boost::multi_index::tag<ancestor_score>,
-                boost::multi_index::identity<CTxMemPoolEntry>,
-                CompareTxMemPoolEntryByAncestorFee
             >
         >
     > indexed_transaction_set;
@@ -394,6 +306,15 @@ public:
     std::vector<CTransactionRef> txns_randomized GUARDED_BY(cs); //!< All transactions in mapTx, in random order
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
+    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> setEntryRefs;
+
+    /** A chunk of a cluster's linearization: transactions that are mined together. */
+    struct Chunk {
+        //! Combined modified fee and virtual size of the transactions
+        FeeFrac feerate;
+        //! The transactions, in an order that is valid in a block
+        Span<const txiter> txs;
+    };
 
     using Limits = kernel::MemPoolLimits;
 
@@ -412,6 +333,44 @@ private:
      */
     std::set<uint256> m_unbroadcast_txids GUARDED_BY(cs);
 
+    /** A connected component of the mempool, see "Clusters and chunks" above. */
+    struct Cluster {
+        //! The transactions, in linearization order unless the cluster is dirty. Removed
+        //! transactions leave a placeholder (mapTx.end()) until the cluster is linearized again.
+        std::vector<txiter> txs;
+        //! Number of placeholders in txs
+        size_t removed{0};
+        //! Combined virtual size of the transactions
+        int64_t vsize{0};
+        //! The chunks of the linearization, empty while the cluster is dirty
+        std::vector<Chunk> chunks;
+        //! Whether transactions were removed since the last linearization, so that it may have fallen apart
+        bool may_split{false};
+        //! Whether transactions were added or their fees changed since the last linearization. If not,
+        //! the remaining order is still topological and only needs to be chunked again.
+        bool relinearize{true};
+
+        size_t Count() const { return txs.size() - removed; }
+    };
+
+    mutable std::unordered_map<uint64_t, Cluster> m_clusters GUARDED_BY(cs);
+    //! Clusters that changed since they were last linearized
+    mutable std::set<uint64_t> m_dirty_clusters GUARDED_BY(cs);
+    //! The last (lowest feerate) chunk of every linearized cluster, the candidates for eviction
+    mutable std::set<std::pair<FeeFrac, uint64_t>> m_worst_chunks GUARDED_BY(cs);
+    mutable uint64_t m_next_cluster_id GUARDED_BY(cs){1};
+
+    /** Put a new entry in a cluster of its own. */
+    void AddToCluster(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Take an entry that is about to be erased out of its cluster. */
+    void RemoveFromCluster(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Merge the clusters of two entries that now depend on each other. */
+    void MergeClusters(txiter a, txiter b) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void MarkClusterDirty(uint64_t cluster_id) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Linearize all dirty clusters, splitting the ones that fell apart first. */
+    void LinearizeClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void LinearizeCluster(uint64_t cluster_id, Cluster& cluster) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
 
     /**
      * Helper function to calculate all in-mempool ancestors of staged_ancestors and apply ancestor
@@ -426,7 +385,7 @@ private:
      */
     util::Result<setEntries> CalculateAncestorsAndCheckLimits(int64_t entry_size,
                                                               size_t entry_count,
-                                                              CTxMemPoolEntry::Parents &staged_ancestors,
+                                                              setEntryRefs& staged_ancestors,
                                                               const Limits& limits
                                                               ) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -598,6 +557,11 @@ public:
      * more transactions as a DoS protection. */
     std::vector<txiter> GatherClusters(const std::vector<uint256>& txids) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Return the chunks of every cluster, each in linearization order and therefore by decreasing
+     * feerate. Clusters that changed are linearized first. The result is only valid until the
+     * mempool is modified. */
+    std::vector<Span<const Chunk>> GetClusterChunks() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Calculate all in-mempool ancestors of a set of transactions not already in the mempool and
      * check ancestor and descendant limits. Heuristics are used to estimate the ancestor and
      * descendant count of all entries if the package were to be added to the mempool.  The limits
@@ -613,6 +577,22 @@ public:
     util::Result<void> CheckPackageLimits(const Package& package,
                                           int64_t total_vsize) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Check that adding the package would not create a cluster exceeding the cluster count and
+     * size limits. The package is assumed to end up in a single cluster together with the clusters
+     * of all its in-mempool parents. Transactions in removed (e.g. the ones that get replaced) are
+     * not counted; a cluster that may fall apart by their removal is still treated as one, so this
+     * errs on the side of rejecting.
+     *
+     * @param[in]       package         Transaction package being evaluated for acceptance
+     *                                  to mempool, not already in the mempool.
+     * @param[in]       total_vsize     Sum of virtual sizes of the transactions in the package.
+     * @param[in]       removed         In-mempool transactions that are removed when the package
+     *                                  is added.
+     * @returns {} or the error reason if a limit is hit.
+     */
+    util::Result<void> CheckClusterLimits(const Package& package, int64_t total_vsize,
+                                          const setEntries& removed) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Populate setDescendants with all in-mempool descendants of hash.
      *  Assumes that setDescendants includes all in-mempool descendants of anything
      *  already in it.  */
@@ -628,7 +608,8 @@ public:
         return GetMinFee(m_max_size_bytes);
     }
 
-    /** Remove transactions from the mempool until its dynamic size is <= sizelimit.
+    /** Remove transactions from the mempool until its dynamic size is <= sizelimit,
+      *  evicting the last transaction of the cluster with the lowest feerate chunk each time.
       *  pvNoSpendsRemaining, if set, will be populated with the list of outpoints
       *  which are not in mempool which no longer have any spends in this mempool.
       */
@@ -745,6 +726,10 @@ public:
      * chunk, and represent their complete cluster. In other words, they have no
      * in-mempool ancestors.
      *
+     * The old chunks are those of the clusters containing the conflicts. The
+     * new chunks are those of the same clusters linearized again without the
+     * conflicts, plus the replacement.
+     *
      * @param[in] replacement_fees    Package fees
      * @param[in] replacement_vsize   Package size (must be greater than 0)
      * @param[in] direct_conflicts    All transactions that would be removed directly by